@@ -0,0 +1,508 @@
+/* nexus_bench.c — allocator throughput / latency benchmark (raw malloc vs debug allocator)
+ *
+ * Every run drives one backend with one size distribution, live-set size and
+ * thread count. Each thread owns `live` slots and performs `ops` random
+ * operations on them: an empty slot is allocated, a full one is freed (7/8)
+ * or reallocated (1/8). Every operation is timed individually into a
+ * log-linear histogram; results go to stdout (or --out) as JSON.
+ *
+ *   nexus_bench [--quick] [--ops N] [--threads 1,2,4] [--live 1,1024,16384]
+ *               [--sizes small,mixed,large] [--backends malloc,debug]
+ *               [--sample-rate BYTES] [--quarantine BYTES] [--seed N] [--out FILE]
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* clock_gettime(), pthreads under -std=c90 */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <time.h>
+#endif
+
+#include "nexus/nexus.h"
+#include "nexus/nexus_build_config.h"
+
+/* ------------------------------------------------------------------ */
+/* Config                                                              */
+/* ------------------------------------------------------------------ */
+#define BENCH_MAX_THREADS 64
+#define BENCH_MAX_LIST    16
+#define BENCH_SITES       64     /* debug backend spreads calls over this many lines */
+
+/* Histogram: exact below 16 ns, then 8 sub-buckets per power of two. */
+#define HIST_SUB_BITS 3
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS  (16 + 44 * HIST_SUB)
+
+enum { OP_ALLOC, OP_REALLOC, OP_FREE, OP_COUNT };
+static const char *const g_op_names[OP_COUNT] = { "alloc", "realloc", "free" };
+
+typedef struct {
+    nexus_u64 counts[HIST_BUCKETS];
+    nexus_u64 total;
+    nexus_u64 max_ns;
+} BenchHist;
+
+/* ------------------------------------------------------------------ */
+/* Backends                                                            */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    const char *name;
+    void *(*alloc_fn)(size_t n, unsigned site);
+    void *(*realloc_fn)(void *p, size_t n, unsigned site);
+    void  (*free_fn)(void *p);
+} BenchBackend;
+
+static void *crt_alloc(size_t n, unsigned site)            { (void)site; return malloc(n); }
+static void *crt_realloc(void *p, size_t n, unsigned site) { (void)site; return realloc(p, n); }
+static void  crt_free(void *p)                             { free(p); }
+
+static void *dbg_alloc(size_t n, unsigned site)            { return nexus_debug_mem_malloc(n, __FILE__, site); }
+static void *dbg_realloc(void *p, size_t n, unsigned site) { return nexus_debug_mem_realloc(p, n, __FILE__, site); }
+static void  dbg_free(void *p)                             { nexus_debug_mem_free(p); }
+
+static const BenchBackend g_backends[] = {
+    { "malloc", crt_alloc, crt_realloc, crt_free },
+    { "debug",  dbg_alloc, dbg_realloc, dbg_free }
+};
+#define BENCH_BACKEND_COUNT (sizeof g_backends / sizeof g_backends[0])
+
+/* ------------------------------------------------------------------ */
+/* Size distributions                                                  */
+/* ------------------------------------------------------------------ */
+static nexus_u32 bench_rand(nexus_u32 *state)
+{
+    nexus_u32 x = *state;          /* xorshift32 */
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static size_t size_small(nexus_u32 *rng) { return 8u + bench_rand(rng) % 121u; }           /* 8..128 */
+static size_t size_large(nexus_u32 *rng) { return 16384u + bench_rand(rng) % 245761u; }    /* 16K..256K */
+static size_t size_mixed(nexus_u32 *rng)                                                   /* log-uniform 16..16K */
+{
+    unsigned shift = 4u + bench_rand(rng) % 10u;
+    return ((size_t)1 << shift) + bench_rand(rng) % ((size_t)1 << shift);
+}
+
+typedef struct {
+    const char *name;
+    size_t (*draw)(nexus_u32 *rng);
+} BenchSizes;
+
+static const BenchSizes g_sizes[] = {
+    { "small", size_small },
+    { "mixed", size_mixed },
+    { "large", size_large }
+};
+#define BENCH_SIZES_COUNT (sizeof g_sizes / sizeof g_sizes[0])
+
+/* ------------------------------------------------------------------ */
+/* Timing                                                              */
+/* ------------------------------------------------------------------ */
+#if defined(_WIN32)
+static double g_qpc_ns = 0.0;
+static nexus_u64 bench_now_ns(void)
+{
+    LARGE_INTEGER t;
+    if (g_qpc_ns == 0.0) {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        g_qpc_ns = 1e9 / (double)f.QuadPart;
+    }
+    QueryPerformanceCounter(&t);
+    return (nexus_u64)((double)t.QuadPart * g_qpc_ns);
+}
+#else
+static nexus_u64 bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (nexus_u64)ts.tv_sec * 1000000000u + (nexus_u64)ts.tv_nsec;
+}
+#endif
+
+static unsigned hist_index(nexus_u64 ns)
+{
+    unsigned e = 0;
+    nexus_u64 v = ns;
+    if (ns < 16u) return (unsigned)ns;
+    while (v >>= 1) ++e;                     /* e = floor(log2(ns)) >= 4 */
+    if (e > 47u) return HIST_BUCKETS - 1u;
+    return 16u + (e - 4u) * HIST_SUB + (unsigned)((ns >> (e - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+static nexus_u64 hist_value(unsigned idx)    /* lower bound of the bucket */
+{
+    unsigned e, sub;
+    if (idx < 16u) return idx;
+    e   = (idx - 16u) / HIST_SUB + 4u;
+    sub = (idx - 16u) % HIST_SUB;
+    return ((nexus_u64)(HIST_SUB + sub)) << (e - HIST_SUB_BITS);
+}
+
+static void hist_add(BenchHist *h, nexus_u64 ns)
+{
+    h->counts[hist_index(ns)] += 1u;
+    h->total += 1u;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+static void hist_merge(BenchHist *into, const BenchHist *from)
+{
+    unsigned i;
+    for (i = 0; i < HIST_BUCKETS; ++i) into->counts[i] += from->counts[i];
+    into->total += from->total;
+    if (from->max_ns > into->max_ns) into->max_ns = from->max_ns;
+}
+
+static nexus_u64 hist_percentile(const BenchHist *h, double pct)
+{
+    nexus_u64 want, seen = 0;
+    unsigned i;
+    if (!h->total) return 0;
+    want = (nexus_u64)((double)h->total * pct / 100.0);
+    if (want >= h->total) want = h->total - 1u;
+    for (i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h->counts[i];
+        if (seen > want) return hist_value(i);
+    }
+    return h->max_ns;
+}
+
+/* ------------------------------------------------------------------ */
+/* Workload                                                            */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    const BenchBackend *backend;
+    const BenchSizes   *sizes;
+    size_t              live;
+    unsigned long       ops;
+    nexus_u32           seed;
+    int                 failed;
+    BenchHist           hist[OP_COUNT];
+} BenchThread;
+
+static void bench_touch(void *p, size_t n)
+{
+    volatile nexus_u8 *b = (volatile nexus_u8*)p;
+    b[0] = 1u;
+    b[n - 1u] = 1u;
+}
+
+static void bench_worker_run(BenchThread *t)
+{
+    const BenchBackend *be = t->backend;
+    void **slots = (void**)calloc(t->live, sizeof(void*));
+    nexus_u32 rng = t->seed ? t->seed : 0x9E3779B9u;
+    unsigned long i;
+    size_t s;
+
+    if (!slots) { t->failed = 1; return; }
+
+    for (i = 0; i < t->ops; ++i) {
+        nexus_u32 r = bench_rand(&rng);
+        size_t slot = t->live > 1u ? r % t->live : 0u;
+        void *p = slots[slot];
+        nexus_u64 t0, t1;
+        int op;
+
+        if (!p) {
+            size_t n = t->sizes->draw(&rng);
+            op = OP_ALLOC;
+            t0 = bench_now_ns();
+            p = be->alloc_fn(n, r % BENCH_SITES);
+            t1 = bench_now_ns();
+            if (!p) { t->failed = 1; break; }
+            bench_touch(p, n);
+        } else if (((r >> 24) & 7u) == 0u) {
+            size_t n = t->sizes->draw(&rng);
+            op = OP_REALLOC;
+            t0 = bench_now_ns();
+            p = be->realloc_fn(p, n, r % BENCH_SITES);
+            t1 = bench_now_ns();
+            if (!p) { t->failed = 1; break; }
+            bench_touch(p, n);
+        } else {
+            op = OP_FREE;
+            t0 = bench_now_ns();
+            be->free_fn(p);
+            t1 = bench_now_ns();
+            p = NULL;
+        }
+        slots[slot] = p;
+        hist_add(&t->hist[op], t1 - t0);
+    }
+
+    for (s = 0; s < t->live; ++s) {
+        if (slots[s]) be->free_fn(slots[s]);
+    }
+    free(slots);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI bench_worker(LPVOID arg) { bench_worker_run((BenchThread*)arg); return 0; }
+#else
+static void *bench_worker(void *arg) { bench_worker_run((BenchThread*)arg); return NULL; }
+#endif
+
+/* Run `count` workers concurrently; returns wall-clock seconds or < 0 on
+   failure. Workers already started when a spawn fails are waited for, so
+   nothing still touches `threads` once this returns. */
+static double bench_spawn(BenchThread *threads, unsigned count)
+{
+    nexus_u64 start, end;
+    unsigned i, n;
+#if defined(_WIN32)
+    HANDLE handles[BENCH_MAX_THREADS];
+    start = bench_now_ns();
+    for (i = 0; i < count; ++i) {
+        handles[i] = CreateThread(NULL, 0, bench_worker, &threads[i], 0, NULL);
+        if (!handles[i]) break;
+    }
+    if (i) WaitForMultipleObjects(i, handles, TRUE, INFINITE);
+    for (n = 0; n < i; ++n) CloseHandle(handles[n]);
+    if (i < count) return -1.0;
+#else
+    pthread_t handles[BENCH_MAX_THREADS];
+    start = bench_now_ns();
+    for (i = 0; i < count; ++i) {
+        if (pthread_create(&handles[i], NULL, bench_worker, &threads[i]) != 0) break;
+    }
+    for (n = 0; n < i; ++n) pthread_join(handles[n], NULL);
+    if (i < count) return -1.0;
+#endif
+    end = bench_now_ns();
+    return (double)(end - start) / 1e9;
+}
+
+/* ------------------------------------------------------------------ */
+/* Options                                                             */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    unsigned long ops;
+    unsigned      threads[BENCH_MAX_LIST];  unsigned thread_count;
+    unsigned long live[BENCH_MAX_LIST];     unsigned live_count;
+    unsigned      sizes[BENCH_MAX_LIST];    unsigned size_count;
+    unsigned      backends[BENCH_MAX_LIST]; unsigned backend_count;
+    size_t        sample_rate;
+    size_t        quarantine;
+    nexus_u32     seed;
+    const char   *out;
+} BenchOptions;
+
+static int parse_numbers(const char *s, unsigned long *out, unsigned *count)
+{
+    char *end;
+    *count = 0;
+    while (*s && *count < BENCH_MAX_LIST) {
+        unsigned long v = strtoul(s, &end, 10);
+        if (end == s || v == 0) return 0;
+        out[(*count)++] = v;
+        s = (*end == ',') ? end + 1 : end;
+        if (*end && *end != ',') return 0;
+    }
+    return *count > 0;
+}
+
+/* Match comma-separated names against a table of `stride`-sized entries
+   whose first member is the name. */
+static int parse_names(const char *s, const void *table, size_t stride, unsigned n,
+                       unsigned *out, unsigned *count)
+{
+    *count = 0;
+    while (*s && *count < BENCH_MAX_LIST) {
+        size_t len = strcspn(s, ",");
+        unsigned i;
+        for (i = 0; i < n; ++i) {
+            const char *name = *(const char *const*)((const char*)table + i * stride);
+            if (strlen(name) == len && strncmp(name, s, len) == 0) break;
+        }
+        if (i == n) return 0;
+        out[(*count)++] = i;
+        s += len;
+        if (*s == ',') ++s;
+    }
+    return *count > 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: nexus_bench [--quick] [--ops N] [--threads 1,2,4] [--live 1,1024,16384]\n"
+            "                   [--sizes small,mixed,large] [--backends malloc,debug]\n"
+            "                   [--sample-rate BYTES] [--quarantine BYTES] [--seed N] [--out FILE]\n");
+}
+
+static int parse_options(int argc, char **argv, BenchOptions *o)
+{
+    unsigned long tmp[BENCH_MAX_LIST];
+    unsigned i;
+    int a;
+
+    memset(o, 0, sizeof *o);
+    o->ops = 200000u;
+    o->threads[0] = 1u; o->threads[1] = 2u; o->threads[2] = 4u; o->thread_count = 3u;
+    o->live[0] = 1u; o->live[1] = 1024u; o->live[2] = 16384u; o->live_count = 3u;
+    for (i = 0; i < BENCH_SIZES_COUNT; ++i) o->sizes[i] = i;
+    o->size_count = BENCH_SIZES_COUNT;
+    for (i = 0; i < BENCH_BACKEND_COUNT; ++i) o->backends[i] = i;
+    o->backend_count = BENCH_BACKEND_COUNT;
+    o->seed = 12345u;
+
+    for (a = 1; a < argc; ++a) {
+        const char *arg = argv[a];
+        const char *val = (a + 1 < argc) ? argv[a + 1] : NULL;
+
+        if (strcmp(arg, "--quick") == 0) {
+            o->ops = 20000u;
+            o->threads[0] = 1u; o->threads[1] = 2u; o->thread_count = 2u;
+            o->live[0] = 1u; o->live[1] = 1024u; o->live_count = 2u;
+            continue;
+        }
+        if (!val) { usage(); return 0; }
+        ++a;
+        if (strcmp(arg, "--ops") == 0) {
+            o->ops = strtoul(val, NULL, 10);
+            if (!o->ops) { usage(); return 0; }
+        } else if (strcmp(arg, "--threads") == 0) {
+            if (!parse_numbers(val, tmp, &o->thread_count)) { usage(); return 0; }
+            for (i = 0; i < o->thread_count; ++i) {
+                if (tmp[i] > BENCH_MAX_THREADS) { usage(); return 0; }
+                o->threads[i] = (unsigned)tmp[i];
+            }
+        } else if (strcmp(arg, "--live") == 0) {
+            if (!parse_numbers(val, o->live, &o->live_count)) { usage(); return 0; }
+        } else if (strcmp(arg, "--sizes") == 0) {
+            if (!parse_names(val, g_sizes, sizeof g_sizes[0], BENCH_SIZES_COUNT,
+                             o->sizes, &o->size_count)) { usage(); return 0; }
+        } else if (strcmp(arg, "--backends") == 0) {
+            if (!parse_names(val, g_backends, sizeof g_backends[0], BENCH_BACKEND_COUNT,
+                             o->backends, &o->backend_count)) { usage(); return 0; }
+        } else if (strcmp(arg, "--sample-rate") == 0) {
+            o->sample_rate = (size_t)strtoul(val, NULL, 10);
+        } else if (strcmp(arg, "--quarantine") == 0) {
+            o->quarantine = (size_t)strtoul(val, NULL, 10);
+        } else if (strcmp(arg, "--seed") == 0) {
+            o->seed = (nexus_u32)strtoul(val, NULL, 10);
+        } else if (strcmp(arg, "--out") == 0) {
+            o->out = val;
+        } else {
+            usage();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ------------------------------------------------------------------ */
+/* Main                                                                */
+/* ------------------------------------------------------------------ */
+static double timer_overhead_ns(void)
+{
+    enum { N = 100000 };
+    nexus_u64 start = bench_now_ns(), end;
+    int i;
+    for (i = 0; i < N; ++i) (void)bench_now_ns();
+    end = bench_now_ns();
+    return (double)(end - start) / N;
+}
+
+static void write_hist(FILE *f, const char *name, const BenchHist *h, int last)
+{
+    fprintf(f, "        \"%s\": { \"count\": %lu, \"p50_ns\": %lu, \"p90_ns\": %lu, "
+               "\"p99_ns\": %lu, \"p999_ns\": %lu, \"max_ns\": %lu }%s\n",
+            name, (unsigned long)h->total,
+            (unsigned long)hist_percentile(h, 50.0), (unsigned long)hist_percentile(h, 90.0),
+            (unsigned long)hist_percentile(h, 99.0), (unsigned long)hist_percentile(h, 99.9),
+            (unsigned long)h->max_ns, last ? "" : ",");
+}
+
+int main(int argc, char **argv)
+{
+    static BenchThread threads[BENCH_MAX_THREADS];
+    BenchOptions o;
+    FILE *out = stdout;
+    unsigned b, s, l, t, i, k;
+    int first = 1, ok = 1;
+
+    if (!parse_options(argc, argv, &o)) return EXIT_FAILURE;
+    if (o.out) {
+        out = fopen(o.out, "w");
+        if (!out) { fprintf(stderr, "nexus_bench: cannot open %s\n", o.out); return EXIT_FAILURE; }
+    }
+    nexus_debug_mem_set_sample_rate(o.sample_rate);
+    nexus_debug_mem_set_quarantine(o.quarantine);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"nexus_bench\",\n");
+    fprintf(out, "  \"version\": \"%d.%d.%d\",\n", NEXUS_VERSION_MAJOR, NEXUS_VERSION_MINOR, NEXUS_VERSION_PATCH);
+#ifdef NEXUS_CFG_PP_BUILD_CONFIG
+    fprintf(out, "  \"build\": \"%s\",\n", NEXUS_CFG_PP_BUILD_CONFIG);
+#endif
+    fprintf(out, "  \"sample_rate\": %lu,\n", (unsigned long)o.sample_rate);
+    fprintf(out, "  \"quarantine\": %lu,\n", (unsigned long)o.quarantine);
+    fprintf(out, "  \"ops_per_thread\": %lu,\n", o.ops);
+    fprintf(out, "  \"timer_overhead_ns\": %.1f,\n", timer_overhead_ns());
+    fprintf(out, "  \"results\": [\n");
+
+    for (b = 0; b < o.backend_count; ++b)
+    for (s = 0; s < o.size_count; ++s)
+    for (l = 0; l < o.live_count; ++l)
+    for (t = 0; t < o.thread_count; ++t) {
+        const BenchBackend *be = &g_backends[o.backends[b]];
+        const BenchSizes   *sz = &g_sizes[o.sizes[s]];
+        unsigned count = o.threads[t];
+        BenchHist merged[OP_COUNT];
+        nexus_u64 total_ops = 0;
+        double secs;
+
+        fprintf(stderr, "nexus_bench: %s/%s live=%lu threads=%u\n", be->name, sz->name, o.live[l], count);
+        memset(threads, 0, sizeof threads[0] * count);
+        for (i = 0; i < count; ++i) {
+            threads[i].backend = be;
+            threads[i].sizes   = sz;
+            threads[i].live    = o.live[l];
+            threads[i].ops     = o.ops;
+            threads[i].seed    = o.seed + 7919u * (i + 1u);
+        }
+        secs = bench_spawn(threads, count);
+
+        memset(merged, 0, sizeof merged);
+        for (i = 0; i < count; ++i) {
+            if (threads[i].failed) secs = -1.0;
+            for (k = 0; k < OP_COUNT; ++k) hist_merge(&merged[k], &threads[i].hist[k]);
+        }
+        if (secs < 0.0) {
+            fprintf(stderr, "nexus_bench: run failed (thread or allocation error)\n");
+            ok = 0;
+            continue;
+        }
+        for (k = 0; k < OP_COUNT; ++k) total_ops += merged[k].total;
+        if (be->free_fn == dbg_free) nexus_debug_mem_reset();
+
+        fprintf(out, "%s    {\n", first ? "" : ",\n");
+        first = 0;
+        fprintf(out, "      \"backend\": \"%s\", \"sizes\": \"%s\", \"live\": %lu, \"threads\": %u,\n",
+                be->name, sz->name, o.live[l], count);
+        fprintf(out, "      \"seconds\": %.6f, \"ops_per_sec\": %.0f,\n",
+                secs, secs > 0.0 ? (double)total_ops / secs : 0.0);
+        fprintf(out, "      \"ops\": {\n");
+        for (k = 0; k < OP_COUNT; ++k) write_hist(out, g_op_names[k], &merged[k], k + 1u == OP_COUNT);
+        fprintf(out, "      }\n    }");
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) fclose(out);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -18,6 +18,8 @@
 /* ===== Config knobs (set via compiler flags ideally) =====
    -DNEXUS_DOUBLE_PRECISION           : float_real == double
    -DNEXUS_MEMORY_DEBUG               : enable debug alloc API
+   -DNEXUS_MEMORY_STATS               : count NEXUS_ALLOC & co. (see nexus_mem_stats.h)
+   -DNEXUS_PROFILE                    : compile NEXUS_PROFILE_ZONE markers in (see nexus_profile.h)
    -DNEXUS_OVERRIDE_STDLIB_ALLOC      : (with MEMORY_DEBUG) macro-replace malloc/realloc/free
    -DNEXUS_EXIT_CRASH                 : provide exit_crash() and optional exit() override
    -DNEXUS_OVERRIDE_STDLIB_EXIT       : (with EXIT_CRASH) macro-replace exit()
@@ -95,32 +97,157 @@ typedef unsigned char NEXUS_BOOL;
 
 NEXUS_EXTERN_C_BEGIN
 
-/* ===== Debug memory API (opt-in) ===== */
-#ifdef NEXUS_MEMORY_DEBUG
+/* ===== Debug memory API (opt-in) =====
+   The debug allocator is always compiled into the library; NEXUS_MEMORY_DEBUG
+   only decides whether NEXUS_ALLOC & co. route through it.
+   nexus_debug_memory_init installs the lock guarding the allocator's
+   global tables; without one it uses a built-in futex mutex
+   (nexus_sync.h), whose nexus_mutex_lock_cb/unlock_cb also fit here. */
 void      nexus_debug_memory_init(void (*lock)(void*), void (*unlock)(void*), void *mutex);
 void     *nexus_debug_mem_malloc(size_t size, const char *file, unsigned line);
 void     *nexus_debug_mem_realloc(void *ptr, size_t size, const char *file, unsigned line);
 void      nexus_debug_mem_free(void *ptr);
+/* align is a power of two. Tracked like any block, plus a front guard;
+   release with nexus_debug_mem_free_aligned and never realloc. */
+void     *nexus_debug_mem_malloc_aligned(size_t size, size_t align, const char *file, unsigned line);
+void      nexus_debug_mem_free_aligned(void *ptr);
 void      nexus_debug_mem_print(unsigned min_allocs);
 void      nexus_debug_mem_reset(void);
+/* Live bytes held by tracked allocations (scaled estimate when sampling). */
+size_t    nexus_debug_mem_consumption(void);
 NEXUS_BOOL nexus_debug_memory(void); /* NEXUS_TRUE if any guard error found */
+/* Incremental nexus_debug_memory: checks up to `budget` live allocations,
+   resuming where the previous call stopped. Cheap enough for every frame. */
+NEXUS_BOOL nexus_debug_memory_step(unsigned budget);
+/* Run nexus_debug_memory_step(budget) every interval_ms on a background
+   thread. Start fails if one is already running; stop returns NEXUS_TRUE
+   if it found guard errors. Call both from the same controlling thread. */
+NEXUS_BOOL nexus_debug_memory_checker_start(unsigned interval_ms, unsigned budget);
+NEXUS_BOOL nexus_debug_memory_checker_stop(void);
+/* Track ~1 allocation per N bytes (Poisson); others bypass guards and sites.
+   Reports then show scaled estimates. 0 (default) tracks everything. */
+void      nexus_debug_mem_set_sample_rate(size_t bytes_per_sample);
+/* Capture up to `frames` return addresses (max 16) per tracked allocation,
+   so allocations made through a shared helper are told apart by call path.
+   Stacks are deduplicated into a table and sites keep a 32-bit ID; reports
+   print each path. Needs glibc, macOS or Windows; 0 (default) is off. */
+void      nexus_debug_mem_set_stack_depth(unsigned frames);
+/* Put blocks of at least min_size bytes flush against an inaccessible
+   page, so an overrun faults on the spot instead of waiting for a guard
+   scan. Pages in use (payload plus guard) are capped at max_bytes (0 = no
+   cap); blocks over budget get the ordinary tail guard. min_size 0 turns
+   it off. Existing blocks keep their layout. */
+void      nexus_debug_mem_set_page_guard(size_t min_size, size_t max_bytes);
+/* Hold freed blocks back, poisoned, in a FIFO of up to max_bytes and
+   report writes to them when they are finally released. Frees are staged
+   per shard and published in small batches. 0 (default) releases at once
+   and drains everything held. Unsampled blocks and blocks over a quarter
+   of the budget skip the quarantine. While it is on, realloc always moves
+   quarantine-sized blocks, so the old copy is held back like a free. */
+void      nexus_debug_mem_set_quarantine(size_t max_bytes);
+/* Write-after-free reports made since start, e.g. to fail a test run. */
+size_t    nexus_debug_mem_quarantine_errors(void);
 
-#  define NEXUS_ALLOC(n)      nexus_debug_mem_malloc((n), __FILE__, __LINE__)
-#  define NEXUS_REALLOC(p, n) nexus_debug_mem_realloc((p), (n), __FILE__, __LINE__)
-#  define NEXUS_FREE(p)       nexus_debug_mem_free((p))
-
-#  ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
-#    undef  malloc
-#    undef  realloc
-#    undef  free
-#    define malloc(n)      nexus_debug_mem_malloc((n), __FILE__, __LINE__)
-#    define realloc(p, n)  nexus_debug_mem_realloc((p), (n), __FILE__, __LINE__)
-#    define free(p)        nexus_debug_mem_free((p))
-#  endif
+/* ===== Runtime allocator interface =====
+   An allocator installed globally or for the current thread takes over
+   NEXUS_ALLOC & co. Blocks must be released while the allocator that
+   produced them is still current, so install at subsystem / thread
+   boundaries rather than around individual calls. With nothing installed
+   the macros make a direct call to malloc (or the debug allocator). */
+typedef struct NexusAllocator {
+    /* Required */
+    void *(*allocate)(void *ctx, size_t size, const char *file, unsigned line);
+    void  (*deallocate)(void *ctx, void *ptr);
+    /* Optional (NULL makes the matching call return NULL) */
+    void *(*reallocate)(void *ctx, void *ptr, size_t size, const char *file, unsigned line);
+    /* align is a power of two; release with deallocate_aligned */
+    void *(*allocate_aligned)(void *ctx, size_t size, size_t align, const char *file, unsigned line);
+    void  (*deallocate_aligned)(void *ctx, void *ptr);
+    void  *ctx;
+} NexusAllocator;
+
+/* Nonzero while any allocator is installed anywhere; the macros' only fast-path cost. */
+NEXUS_API extern unsigned nexus_allocator_installed;
+
+/* Install (NULL uninstalls); return the previously installed allocator. The
+   thread allocator wins over the global one. The vtable must outlive its
+   installation. */
+NEXUS_API const NexusAllocator *nexus_allocator_set_global(const NexusAllocator *allocator);
+NEXUS_API const NexusAllocator *nexus_allocator_set_thread(const NexusAllocator *allocator);
+/* Thread, else global, else NULL. */
+NEXUS_API const NexusAllocator *nexus_allocator_current(void);
+
+/* Built-in vtables: plain CRT and the debug allocator. */
+NEXUS_API const NexusAllocator *nexus_allocator_system(void);
+NEXUS_API const NexusAllocator *nexus_allocator_debug(void);
+/* What the macros use with nothing installed: the debug allocator or the
+   counting front end in those builds, else the CRT. */
+NEXUS_API const NexusAllocator *nexus_allocator_default(void);
+
+/* Dispatch through `allocator`, or the current one when NULL; with none
+   installed these fall back to the build's default backend. */
+NEXUS_API void *nexus_allocator_alloc(const NexusAllocator *allocator, size_t size, const char *file, unsigned line);
+NEXUS_API void *nexus_allocator_realloc(const NexusAllocator *allocator, void *ptr, size_t size, const char *file, unsigned line);
+NEXUS_API void  nexus_allocator_free(const NexusAllocator *allocator, void *ptr);
+NEXUS_API void *nexus_allocator_alloc_aligned(const NexusAllocator *allocator, size_t size, size_t align, const char *file, unsigned line);
+NEXUS_API void  nexus_allocator_free_aligned(const NexusAllocator *allocator, void *ptr);
+
+/* Explicit-allocator forms, for code that carries its own allocator. */
+#define NEXUS_ALLOCATOR_ALLOC(a, n)      nexus_allocator_alloc((a), (n), __FILE__, __LINE__)
+#define NEXUS_ALLOCATOR_REALLOC(a, p, n) nexus_allocator_realloc((a), (p), (n), __FILE__, __LINE__)
+#define NEXUS_ALLOCATOR_FREE(a, p)       nexus_allocator_free((a), (p))
+#define NEXUS_ALLOCATOR_ALLOC_ALIGNED(a, n, align) \
+    nexus_allocator_alloc_aligned((a), (n), (align), __FILE__, __LINE__)
+#define NEXUS_ALLOCATOR_FREE_ALIGNED(a, p) nexus_allocator_free_aligned((a), (p))
+
+/* Counting front end for the default backend (nexus_mem_stats.h). Blocks
+   carry a header, so only free them through nexus_mem_stats_free. */
+NEXUS_API void *nexus_mem_stats_malloc(size_t size, const char *file, unsigned line);
+NEXUS_API void *nexus_mem_stats_realloc(void *ptr, size_t size, const char *file, unsigned line);
+NEXUS_API void  nexus_mem_stats_free(void *ptr);
+
+#if defined(NEXUS_MEMORY_STATS)
+#  define NEXUS__ALLOC_DEFAULT(n, file, line)      nexus_mem_stats_malloc((n), (file), (line))
+#  define NEXUS__REALLOC_DEFAULT(p, n, file, line) nexus_mem_stats_realloc((p), (n), (file), (line))
+#  define NEXUS__FREE_DEFAULT(p)                   nexus_mem_stats_free((p))
+#elif defined(NEXUS_MEMORY_DEBUG)
+#  define NEXUS__ALLOC_DEFAULT(n, file, line)      nexus_debug_mem_malloc((n), (file), (line))
+#  define NEXUS__REALLOC_DEFAULT(p, n, file, line) nexus_debug_mem_realloc((p), (n), (file), (line))
+#  define NEXUS__FREE_DEFAULT(p)                   nexus_debug_mem_free((p))
 #else
-#  define NEXUS_ALLOC(n)      malloc((n))
-#  define NEXUS_REALLOC(p, n) realloc((p), (n))
-#  define NEXUS_FREE(p)       free((p))
+#  define NEXUS__ALLOC_DEFAULT(n, file, line)      ((void)(file), (void)(line), malloc((n)))
+#  define NEXUS__REALLOC_DEFAULT(p, n, file, line) ((void)(file), (void)(line), realloc((p), (n)))
+#  define NEXUS__FREE_DEFAULT(p)                   free((p))
+#endif
+
+/* Attribute to a caller-supplied site (for allocators built on NEXUS_ALLOC) */
+#define NEXUS_ALLOC_AT(n, file, line) \
+    (nexus_allocator_installed ? nexus_allocator_alloc(NULL, (n), (file), (line)) \
+                               : NEXUS__ALLOC_DEFAULT((n), (file), (line)))
+#define NEXUS_REALLOC_AT(p, n, file, line) \
+    (nexus_allocator_installed ? nexus_allocator_realloc(NULL, (p), (n), (file), (line)) \
+                               : NEXUS__REALLOC_DEFAULT((p), (n), (file), (line)))
+
+#define NEXUS_ALLOC(n)      NEXUS_ALLOC_AT((n), __FILE__, __LINE__)
+#define NEXUS_REALLOC(p, n) NEXUS_REALLOC_AT((p), (n), __FILE__, __LINE__)
+#define NEXUS_FREE(p) \
+    (nexus_allocator_installed ? nexus_allocator_free(NULL, (p)) : NEXUS__FREE_DEFAULT((p)))
+
+/* Aligned blocks (align a power of two, e.g. 32/64 for AVX loads or cache
+   lines). Guarded and tracked in debug builds. Release only with
+   NEXUS_FREE_ALIGNED, and never NEXUS_REALLOC them. */
+#define NEXUS_ALLOC_ALIGNED_AT(n, align, file, line) \
+    nexus_allocator_alloc_aligned(NULL, (n), (align), (file), (line))
+#define NEXUS_ALLOC_ALIGNED(n, align) NEXUS_ALLOC_ALIGNED_AT((n), (align), __FILE__, __LINE__)
+#define NEXUS_FREE_ALIGNED(p)         nexus_allocator_free_aligned(NULL, (p))
+
+#if defined(NEXUS_MEMORY_DEBUG) && defined(NEXUS_OVERRIDE_STDLIB_ALLOC)
+#  undef  malloc
+#  undef  realloc
+#  undef  free
+#  define malloc(n)      nexus_debug_mem_malloc((n), __FILE__, __LINE__)
+#  define realloc(p, n)  nexus_debug_mem_realloc((p), (n), __FILE__, __LINE__)
+#  define free(p)        nexus_debug_mem_free((p))
 #endif
 
 /* ===== Exit crash (opt-in) ===== */
@@ -0,0 +1,67 @@
+/* nexus_arena.h — linear (bump) allocator over chained blocks (C89-compatible) */
+#ifndef NEXUS_ARENA_H
+#define NEXUS_ARENA_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Default alignment of nexus_arena_alloc; matches what malloc guarantees. */
+#ifndef NEXUS_ARENA_ALIGN
+#  define NEXUS_ARENA_ALIGN 16
+#endif
+
+typedef struct nexus_arena_block nexus_arena_block;
+
+/* Scratch allocator for per-request / per-frame memory. Allocation bumps a
+   pointer inside the newest block; a full block is chained behind a fresh
+   one. Everything is released at once by rewind, reset or free.
+
+   Backing blocks come from the allocator that was current when the arena
+   was initialised (the default one if none was, or if it was this arena's
+   own vtable), attributed to the initialising site, so Debug builds list
+   them in nexus_debug_mem_print and guard checks cover every block. The
+   arena keeps using that parent however the installed allocator changes
+   later, which also makes its vtable safe to install. */
+typedef struct {
+    nexus_arena_block    *head;       /* newest block, older ones chain behind */
+    size_t                block_size; /* payload size of regular blocks */
+    const NexusAllocator *parent;     /* backing blocks come from and go back to it */
+    const char           *file;       /* site the backing blocks are attributed to */
+    unsigned              line;
+} nexus_arena;
+
+/* Position to rewind to; only valid while the arena has not been rewound
+   past it or reset. */
+typedef struct {
+    nexus_arena_block *block;
+    size_t             used;
+} nexus_arena_mark;
+
+NEXUS_API void  nexus_arena_init(nexus_arena *arena, size_t block_size, const char *file, unsigned line);
+/* Releases every block. The arena may be reused afterwards. */
+NEXUS_API void  nexus_arena_free(nexus_arena *arena);
+
+/* NULL on out-of-memory. */
+NEXUS_API void *nexus_arena_alloc(nexus_arena *arena, size_t size);
+/* align must be a power of two. */
+NEXUS_API void *nexus_arena_alloc_aligned(nexus_arena *arena, size_t size, size_t align);
+
+NEXUS_API nexus_arena_mark nexus_arena_get_mark(const nexus_arena *arena);
+/* Drops everything allocated after mark and releases blocks chained since. */
+NEXUS_API void  nexus_arena_rewind(nexus_arena *arena, nexus_arena_mark mark);
+/* Drops everything; keeps the newest block so the next cycle avoids malloc. */
+NEXUS_API void  nexus_arena_reset(nexus_arena *arena);
+
+/* Bytes handed out across all blocks (including alignment padding). */
+NEXUS_API size_t nexus_arena_used(const nexus_arena *arena);
+
+/* Fill *out with a NexusAllocator that bump-allocates from arena. Frees are
+   no-ops (memory goes back on rewind/reset); reallocate grows the newest
+   allocation in place when it can. */
+NEXUS_API void   nexus_arena_allocator(nexus_arena *arena, NexusAllocator *out);
+
+#define NEXUS_ARENA_INIT(a, block_size) nexus_arena_init((a), (block_size), __FILE__, __LINE__)
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_ARENA_H */
@@ -0,0 +1,75 @@
+/* nexus_file.h — memory-mapped views and streaming file I/O (C89-compatible) */
+#ifndef NEXUS_FILE_H
+#define NEXUS_FILE_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* ===== Mapped views =====
+   A whole file mapped read-only, so loaders parse straight out of the
+   page cache instead of reading into a buffer and copying again. The view
+   holds no descriptor; it stays valid until nexus_file_map_close. */
+typedef enum {
+    NEXUS_FILE_ADVICE_NORMAL     = 0,
+    NEXUS_FILE_ADVICE_SEQUENTIAL = 1,   /* read ahead aggressively, drop behind */
+    NEXUS_FILE_ADVICE_RANDOM     = 2,   /* no read-ahead */
+    NEXUS_FILE_ADVICE_WILLNEED   = 3,   /* start paging the range in now */
+    NEXUS_FILE_ADVICE_DONTNEED   = 4    /* the range may be dropped from memory */
+} nexus_file_advice;
+
+typedef struct {
+    const void *data;       /* NULL for an empty file */
+    size_t      size;
+} nexus_file_map;
+
+/* NEXUS_FALSE if the file cannot be opened or mapped (or does not fit
+   the address space); `advice` applies to the whole view. */
+NEXUS_API NEXUS_BOOL nexus_file_map_open(nexus_file_map *m, const char *path, nexus_file_advice advice);
+/* Hint for [offset, offset + size) of the view, widened to whole pages.
+   Ignored where the platform has no equivalent (Windows honours WILLNEED). */
+NEXUS_API void       nexus_file_map_advise(const nexus_file_map *m, size_t offset, size_t size,
+                                           nexus_file_advice advice);
+NEXUS_API void       nexus_file_map_close(nexus_file_map *m);
+
+/* ===== Streaming reader =====
+   Reads a file front to back in chunk_size pieces through two buffers: a
+   background thread fills one while the caller works on the other, so
+   memory stays at two chunks however large the file is. Buffers come
+   from NEXUS_ALLOC under the opening site. */
+typedef struct nexus_file_reader nexus_file_reader;
+
+/* chunk_size 0 picks 1 MiB. NULL if the file cannot be opened, on
+   out-of-memory, or if the reading thread cannot be started. */
+NEXUS_API nexus_file_reader *nexus_file_reader_open(const char *path, size_t chunk_size,
+                                                    const char *file, unsigned line);
+/* The next chunk and its length (only the last may be short); NULL at the
+   end of the file or after a read error. A chunk stays valid until the
+   next call. */
+NEXUS_API const void        *nexus_file_reader_next(nexus_file_reader *r, size_t *size);
+/* NEXUS_TRUE if reading stopped on an I/O error rather than end of file. */
+NEXUS_API NEXUS_BOOL         nexus_file_reader_failed(const nexus_file_reader *r);
+NEXUS_API void               nexus_file_reader_close(nexus_file_reader *r);
+
+#define NEXUS_FILE_READER_OPEN(path, chunk_size) \
+    nexus_file_reader_open((path), (chunk_size), __FILE__, __LINE__)
+
+/* ===== Buffered writer =====
+   Collects small writes in one buffer and hands them to the OS when it
+   fills; writes at least as large as the buffer bypass it. Errors are
+   sticky: once a write fails every later call returns NEXUS_FALSE. */
+typedef struct nexus_file_writer nexus_file_writer;
+
+/* Creates or truncates path. buffer_size 0 picks 64 KiB. */
+NEXUS_API nexus_file_writer *nexus_file_writer_open(const char *path, size_t buffer_size,
+                                                    const char *file, unsigned line);
+NEXUS_API NEXUS_BOOL         nexus_file_writer_write(nexus_file_writer *w, const void *data, size_t size);
+NEXUS_API NEXUS_BOOL         nexus_file_writer_flush(nexus_file_writer *w);
+/* Flushes and closes; NEXUS_FALSE if anything was lost along the way. */
+NEXUS_API NEXUS_BOOL         nexus_file_writer_close(nexus_file_writer *w);
+
+#define NEXUS_FILE_WRITER_OPEN(path, buffer_size) \
+    nexus_file_writer_open((path), (buffer_size), __FILE__, __LINE__)
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_FILE_H */
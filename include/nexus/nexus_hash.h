@@ -0,0 +1,59 @@
+/* nexus_hash.h — fast non-cryptographic hashing and string interning (C89-compatible) */
+#ifndef NEXUS_HASH_H
+#define NEXUS_HASH_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* ===== Hashing =====
+   64-bit hashes for hash tables, deduplication and checksums of trusted
+   data; none of them resists deliberate collisions. Results depend on
+   byte order and may change between releases, so do not persist them.
+
+   nexus_hash_bytes reads 32-byte stripes into four independent lanes
+   (two SSE2 registers where available; the scalar path gives the same
+   result), so long inputs are bound by memory bandwidth rather than by
+   one multiply chain. Inputs of up to 128 bytes take a short path with
+   overlapping loads instead of a byte loop. `data` needs no alignment. */
+NEXUS_API nexus_u64 nexus_hash_bytes(const void *data, size_t size, nexus_u64 seed);
+/* Same as nexus_hash_bytes over strlen(str) bytes. */
+NEXUS_API nexus_u64 nexus_hash_str(const char *str, nexus_u64 seed);
+/* Bijective mixers: distinct inputs never collide, and every input bit
+   affects every output bit. */
+NEXUS_API nexus_u64 nexus_hash_u64(nexus_u64 value);
+NEXUS_API nexus_u32 nexus_hash_u32(nexus_u32 value);
+/* Fold `value` into a running hash, e.g. over the fields of a key. */
+NEXUS_API nexus_u64 nexus_hash_combine(nexus_u64 hash, nexus_u64 value);
+
+/* ===== String interning =====
+   One process-wide table mapping each distinct string to a small ID and a
+   canonical copy, so equality of interned strings is an ID (or pointer)
+   compare. Thread-safe: the table is split into shards by hash, each with
+   its own lock, and resolving an ID to its string takes no lock at all.
+   Copies live until the process exits; nothing is ever removed.
+
+   Storage comes straight from the C runtime, never from NEXUS_ALLOC, so
+   the debug allocator can intern its file names without recursing. */
+typedef nexus_u32 nexus_str_id;     /* 0 never names a string */
+
+/* ID of str, adding a copy on first sight. 0 for NULL, or when memory
+   runs out or the table is full (about 16 million strings). */
+NEXUS_API nexus_str_id nexus_intern(const char *str);
+/* Same for the first len bytes of str, which need no terminator (and may
+   not contain a NUL). */
+NEXUS_API nexus_str_id nexus_intern_n(const char *str, size_t len);
+/* ID of str if it was interned before, else 0; never adds. */
+NEXUS_API nexus_str_id nexus_intern_find(const char *str, size_t len);
+/* NUL-terminated canonical copy, or NULL for 0 / unknown IDs. The same
+   ID always yields the same pointer. */
+NEXUS_API const char  *nexus_intern_str(nexus_str_id id);
+NEXUS_API size_t       nexus_intern_len(nexus_str_id id);
+/* Distinct strings interned so far. */
+NEXUS_API size_t       nexus_intern_count(void);
+
+/* Canonical pointer for str in one step: equal contents give equal pointers. */
+#define NEXUS_INTERN_CSTR(str) nexus_intern_str(nexus_intern(str))
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_HASH_H */
@@ -0,0 +1,84 @@
+/* nexus_hashmap.h — type-generic open-addressing hash map (C89-compatible) */
+#ifndef NEXUS_HASHMAP_H
+#define NEXUS_HASHMAP_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Keys and values are stored inline in one flat slot array, next to one
+   metadata byte per slot holding 7 bits of the key's hash (or an empty /
+   deleted mark). Lookups compare a whole group of metadata bytes at once
+   (16 with SSE2, 8 otherwise) and only touch slots whose byte matches, so
+   a miss rarely reads a key at all. The table keeps at most 7/8 of its
+   slots occupied.
+
+   Storage comes from `allocator`, or from NEXUS_ALLOC & co. when it is
+   NULL, under the site that initialised the map. Key and value pointers
+   are invalidated by anything that inserts. value_size 0 makes a set. */
+typedef nexus_u64  (*nexus_hashmap_hash_fn)(const void *key, size_t key_size);
+typedef NEXUS_BOOL (*nexus_hashmap_eq_fn)(const void *a, const void *b, size_t key_size);
+
+typedef struct {
+    nexus_u8             *ctrl;         /* metadata bytes, then a copy of the first group */
+    nexus_u8             *slots;        /* capacity * stride bytes */
+    size_t                count;
+    size_t                capacity;     /* slots, a power of two; 0 before first insert */
+    size_t                growth_left;  /* inserts into empty slots before a rehash */
+    size_t                key_size;
+    size_t                value_size;
+    size_t                value_offset; /* within a slot */
+    size_t                stride;
+    nexus_hashmap_hash_fn hash;
+    nexus_hashmap_eq_fn   eq;
+    const NexusAllocator *allocator;    /* NULL: whatever NEXUS_ALLOC uses */
+    const char           *file;         /* site the storage is attributed to */
+    unsigned              line;
+} nexus_hashmap;
+
+/* hash/eq NULL hash and compare the key's bytes, which then must not
+   contain padding. */
+NEXUS_API void       nexus_hashmap_init(nexus_hashmap *m, size_t key_size, size_t value_size,
+                                        nexus_hashmap_hash_fn hash, nexus_hashmap_eq_fn eq,
+                                        const NexusAllocator *allocator,
+                                        const char *file, unsigned line);
+/* Releases the table. The map may be reused afterwards. */
+NEXUS_API void       nexus_hashmap_free(nexus_hashmap *m);
+/* Drops every entry, keeping the table. */
+NEXUS_API void       nexus_hashmap_clear(nexus_hashmap *m);
+/* Size the table so `count` entries fit without a rehash. NEXUS_FALSE on
+   out-of-memory, leaving the map unchanged. */
+NEXUS_API NEXUS_BOOL nexus_hashmap_reserve(nexus_hashmap *m, size_t count);
+
+/* Value stored under key, or NULL. */
+NEXUS_API void      *nexus_hashmap_get(const nexus_hashmap *m, const void *key);
+/* Value under key, inserting a zeroed one first if missing (*inserted
+   tells which, if non-NULL). NULL on out-of-memory. */
+NEXUS_API void      *nexus_hashmap_emplace(nexus_hashmap *m, const void *key, NEXUS_BOOL *inserted);
+/* Insert or overwrite; value may be NULL for sets. NULL on out-of-memory. */
+NEXUS_API void      *nexus_hashmap_put(nexus_hashmap *m, const void *key, const void *value);
+/* NEXUS_FALSE if key was absent. */
+NEXUS_API NEXUS_BOOL nexus_hashmap_remove(nexus_hashmap *m, const void *key);
+
+/* Visit every entry: start with *it = 0 and call until NEXUS_FALSE. key
+   and value may be NULL. The map must not be modified meanwhile, except
+   through nexus_hashmap_remove of the entry just visited. */
+NEXUS_API NEXUS_BOOL nexus_hashmap_next(const nexus_hashmap *m, size_t *it,
+                                        const void **key, void **value);
+
+/* hash/eq for keys that are NUL-terminated `const char *` pointers; the
+   strings must outlive their entries. */
+NEXUS_API nexus_u64  nexus_hashmap_str_hash(const void *key, size_t key_size);
+NEXUS_API NEXUS_BOOL nexus_hashmap_str_eq(const void *a, const void *b, size_t key_size);
+
+#define NEXUS_HASHMAP_INIT(m, key_type, value_type) \
+    nexus_hashmap_init((m), sizeof(key_type), sizeof(value_type), NULL, NULL, NULL, __FILE__, __LINE__)
+#define NEXUS_HASHMAP_INIT_STR(m, value_type) \
+    nexus_hashmap_init((m), sizeof(const char*), sizeof(value_type), nexus_hashmap_str_hash, \
+                       nexus_hashmap_str_eq, NULL, __FILE__, __LINE__)
+#define NEXUS_HASHSET_INIT(m, key_type) \
+    nexus_hashmap_init((m), sizeof(key_type), 0u, NULL, NULL, NULL, __FILE__, __LINE__)
+#define NEXUS_HASHMAP_GET(m, value_type, key) ((value_type*)nexus_hashmap_get((m), (key)))
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_HASHMAP_H */
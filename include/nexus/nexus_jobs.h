@@ -0,0 +1,62 @@
+/* nexus_jobs.h — work-stealing job system over a fixed worker pool (C89-compatible) */
+#ifndef NEXUS_JOBS_H
+#define NEXUS_JOBS_H
+
+#include "nexus/nexus.h"
+#include "nexus/nexus_sync.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* A fixed set of worker threads, each owning a Chase-Lev deque: jobs a
+   worker submits go to the bottom of its own deque and are popped from
+   there (LIFO, cache-warm), while idle workers steal from the top of
+   others' (FIFO, the oldest and usually largest work). Jobs submitted
+   from outside the pool enter through a shared queue. Idle workers sleep
+   on a futex rather than spin.
+
+   Completion is tracked with counters: every job submitted against a
+   counter raises it, and finishing lowers it; nexus_jobs_wait blocks
+   until it reaches zero and runs pending jobs on the waiting thread in
+   the meantime, so waiting inside a job cannot deadlock the pool.
+
+   Job records come from a nexus_pool attributed to the creating site. */
+typedef struct nexus_jobs nexus_jobs;
+
+typedef void (*nexus_job_fn)(void *arg);
+/* Runs over [begin, end). */
+typedef void (*nexus_job_range_fn)(void *arg, size_t begin, size_t end);
+
+/* Zero-initialise (or NEXUS_JOB_COUNTER_INIT); reusable once it reads zero. */
+typedef struct {
+    nexus_atomic_u32 pending;
+} nexus_job_counter;
+#define NEXUS_JOB_COUNTER_INIT { 0u }
+
+/* workers == 0 starts one per CPU but the calling one (at least one).
+   NULL on out-of-memory or if no thread could be started. */
+NEXUS_API nexus_jobs *nexus_jobs_create(unsigned workers, const char *file, unsigned line);
+/* Finishes every submitted job, then stops and joins the workers. */
+NEXUS_API void        nexus_jobs_destroy(nexus_jobs *jobs);
+NEXUS_API unsigned    nexus_jobs_worker_count(const nexus_jobs *jobs);
+/* Index of the calling worker thread of `jobs`, or -1 for other threads. */
+NEXUS_API int         nexus_jobs_worker_index(const nexus_jobs *jobs);
+
+/* Queue fn(arg). counter may be NULL (fire and forget). If no job record
+   can be allocated, fn runs immediately on the calling thread. */
+NEXUS_API void        nexus_jobs_submit(nexus_jobs *jobs, nexus_job_fn fn, void *arg,
+                                        nexus_job_counter *counter);
+/* Queue fn over [begin, end) split into chunks of about `grain` indices
+   (0 picks about four chunks per thread). */
+NEXUS_API void        nexus_jobs_submit_range(nexus_jobs *jobs, size_t begin, size_t end, size_t grain,
+                                              nexus_job_range_fn fn, void *arg,
+                                              nexus_job_counter *counter);
+/* Help run jobs until counter reaches zero. */
+NEXUS_API void        nexus_jobs_wait(nexus_jobs *jobs, nexus_job_counter *counter);
+/* submit_range + wait. */
+NEXUS_API void        nexus_jobs_parallel_for(nexus_jobs *jobs, size_t begin, size_t end, size_t grain,
+                                              nexus_job_range_fn fn, void *arg);
+
+#define NEXUS_JOBS_CREATE(workers) nexus_jobs_create((workers), __FILE__, __LINE__)
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_JOBS_H */
@@ -0,0 +1,54 @@
+/* nexus_mem_snapshot.h — debug allocator heap snapshots (C89-compatible) */
+#ifndef NEXUS_MEM_SNAPSHOT_H
+#define NEXUS_MEM_SNAPSHOT_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Point-in-time copy of the debug allocator's tables. Capturing only holds
+   each shard lock long enough to copy its entries; writing, reading and
+   diffing work on the copy, so allocating threads never wait on I/O.
+
+   On disk ("NXSNAP" + version, little-endian): header, file-name table,
+   per-site stats, then one record per live allocation. */
+typedef struct {
+    const char *file;
+    unsigned    line;
+    nexus_u64   live_count;      /* tracked allocations currently live */
+    nexus_u64   bytes_live;
+    nexus_u64   alloc_total;
+    nexus_u64   free_total;
+    /* Scaled by sample weight; equal to the above when not sampling */
+    nexus_u64   est_bytes_live;
+    nexus_u64   est_alloc_total;
+    nexus_u64   est_free_total;
+} nexus_mem_snapshot_site;
+
+typedef struct {
+    nexus_u64 address;
+    nexus_u64 size;
+    unsigned  site;              /* index into sites */
+} nexus_mem_snapshot_alloc;
+
+typedef struct {
+    nexus_u64                 timestamp;    /* seconds since the epoch */
+    nexus_u64                 sample_rate;  /* 0 = every allocation tracked */
+    unsigned                  site_count;   /* sorted by file, then line */
+    nexus_mem_snapshot_site  *sites;
+    nexus_u64                 alloc_count;
+    nexus_mem_snapshot_alloc *allocs;
+    char                     *strings;      /* backing store for site file names */
+} nexus_mem_snapshot;
+
+/* Capture the current state. NULL on out-of-memory. */
+NEXUS_API nexus_mem_snapshot *nexus_debug_mem_snapshot(void);
+NEXUS_API void                nexus_mem_snapshot_free(nexus_mem_snapshot *snap);
+
+/* 0 on success, -1 on I/O error (errno is left as set by stdio). */
+NEXUS_API int                 nexus_mem_snapshot_write(const nexus_mem_snapshot *snap, const char *path);
+/* NULL if the file cannot be read or is not a snapshot. */
+NEXUS_API nexus_mem_snapshot *nexus_mem_snapshot_read(const char *path);
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_MEM_SNAPSHOT_H */
@@ -0,0 +1,91 @@
+/* nexus_mem_stats.h — always-on allocation statistics (C89-compatible) */
+#ifndef NEXUS_MEM_STATS_H
+#define NEXUS_MEM_STATS_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Counters for blocks that went through nexus_mem_stats_malloc & co. — with
+   -DNEXUS_MEMORY_STATS that is every NEXUS_ALLOC, in Debug and Release alike.
+   Global counters live in per-thread records the owning thread updates
+   with plain stores; per-site counters are atomic adds. Nothing takes a
+   lock, and queries sum the records without stopping anyone, so figures
+   are a consistent-enough view rather than an exact instant. */
+
+/* Size class k holds sizes in [2^(k-1), 2^k); class 0 is size 0 and the
+   last class everything larger. */
+#define NEXUS_MEM_STATS_CLASSES      32
+/* Seconds of allocation-rate history kept. */
+#define NEXUS_MEM_STATS_RATE_SECONDS 60
+
+typedef struct {
+    nexus_u64 bytes_live;
+    nexus_u64 bytes_peak;        /* high-water mark, within ~64 KiB per thread */
+    nexus_u64 allocs_live;
+    nexus_u64 alloc_total;
+    nexus_u64 free_total;
+    nexus_u64 bytes_alloc_total;
+    nexus_u64 size_classes[NEXUS_MEM_STATS_CLASSES];   /* allocations per class */
+} nexus_mem_stats;
+
+typedef struct {
+    const char *file;            /* NULL for the overflow bucket once the site table is full */
+    unsigned    line;
+    nexus_u64   bytes_live;
+    nexus_u64   alloc_total;
+    nexus_u64   free_total;
+} nexus_mem_stats_site;
+
+NEXUS_API void     nexus_mem_stats_get(nexus_mem_stats *out);
+
+/* Fill up to `max` sites, largest bytes_live first; returns how many were written. */
+NEXUS_API unsigned nexus_mem_stats_sites(nexus_mem_stats_site *out, unsigned max);
+
+/* Allocations per second over the last `seconds` complete seconds (at most
+   NEXUS_MEM_STATS_RATE_SECONDS), oldest first. Returns the count written. */
+NEXUS_API unsigned nexus_mem_stats_rate(nexus_u64 *out, unsigned seconds);
+
+/* ===== Budgets =====
+   Byte limits on live memory at one site (file and line), at every site
+   of a source file (line 0, a per-module tag), or across the process
+   (file NULL). A site counts against its most specific budget only.
+   Enforced by nexus_mem_stats_malloc & co. on the allocating thread;
+   with no budgets set that costs two loads per call.
+
+   Crossing the soft limit upwards calls the budget's pressure callback
+   so caches can shrink. An allocation that would pass the hard limit
+   calls it too, and returns NULL if the callback did not free enough.
+   Callbacks run outside every allocator lock and may free or allocate;
+   a hard limit hit from inside a callback fails without recursing.
+
+   The process-wide figure is the one nexus_mem_stats_get reports, which
+   lags each thread by up to 64 KiB; per-site and per-file figures are
+   exact. Set budgets before the allocations they govern: blocks in
+   flight while a budget is first set may be missed by it. */
+#define NEXUS_MEM_BUDGETS 32   /* including the process-wide one */
+
+typedef struct {
+    int         budget;        /* id from nexus_mem_budget_set */
+    const char *file;          /* allocating site (NULL when unknown) */
+    unsigned    line;
+    size_t      bytes_live;    /* charged to the budget, this request included */
+    size_t      request;       /* bytes asked for; 0 when reported after the fact */
+    size_t      limit;         /* the limit crossed */
+    NEXUS_BOOL  hard;          /* the request fails unless the callback frees memory */
+} nexus_mem_pressure;
+
+typedef void (*nexus_mem_pressure_fn)(void *user, const nexus_mem_pressure *p);
+
+/* Create or update the budget for a scope; file is kept by pointer and a
+   0 limit is off. Bytes already live in the scope count from now on.
+   Returns the budget id (0 for the process-wide one), or -1 when all
+   NEXUS_MEM_BUDGETS are in use. Budgets are never removed; zero the
+   limits instead. */
+NEXUS_API int    nexus_mem_budget_set(const char *file, unsigned line, size_t soft_limit, size_t hard_limit,
+                                      nexus_mem_pressure_fn fn, void *user);
+/* Bytes currently charged to a budget. */
+NEXUS_API size_t nexus_mem_budget_live(int budget);
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_MEM_STATS_H */
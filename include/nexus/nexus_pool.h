@@ -0,0 +1,47 @@
+/* nexus_pool.h — fixed-size object pool with per-thread caches (C89-compatible) */
+#ifndef NEXUS_POOL_H
+#define NEXUS_POOL_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Slab allocator for many same-sized objects. Objects are carved from
+   slabs and recycled through an intrusive free list. Slabs (and the pool
+   itself) come from the allocator that was current at creation, or the
+   default one, under the creating site, so Debug builds track them; later
+   changes to the installed allocator, including installing the pool's own
+   vtable, do not affect where they come from. Slabs are allocated with no
+   pool lock held.
+
+   Each thread works out of its own magazine: alloc and free are a pop or
+   push there, and only touch the shared free list in batches when the
+   magazine runs empty or full. Objects may be freed from any thread. */
+typedef struct nexus_pool nexus_pool;
+
+/* objs_per_slab == 0 picks a slab of roughly 64 KiB. NULL on out-of-memory. */
+NEXUS_API nexus_pool *nexus_pool_create(size_t obj_size, size_t objs_per_slab,
+                                        const char *file, unsigned line);
+/* Releases every slab; outstanding objects become invalid. */
+NEXUS_API void        nexus_pool_destroy(nexus_pool *pool);
+
+/* NULL on out-of-memory. Objects are aligned to min(16, size rounded up
+   to a pointer multiple). */
+NEXUS_API void       *nexus_pool_alloc(nexus_pool *pool);
+NEXUS_API void        nexus_pool_free(nexus_pool *pool, void *obj);
+
+/* Return the calling thread's cached objects to the shared free list,
+   e.g. before a worker thread exits. */
+NEXUS_API void        nexus_pool_flush(nexus_pool *pool);
+
+NEXUS_API size_t      nexus_pool_object_size(const nexus_pool *pool);
+
+/* Fill *out with a NexusAllocator serving requests of at most the object
+   size from pool; larger requests (and alignments past the pool's) get NULL. */
+NEXUS_API void        nexus_pool_allocator(nexus_pool *pool, NexusAllocator *out);
+
+#define NEXUS_POOL_CREATE(obj_size, objs_per_slab) \
+    nexus_pool_create((obj_size), (objs_per_slab), __FILE__, __LINE__)
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_POOL_H */
@@ -0,0 +1,54 @@
+/* nexus_profile.h — profiling zones with Chrome trace export (C89-compatible) */
+#ifndef NEXUS_PROFILE_H
+#define NEXUS_PROFILE_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Every thread records into its own fixed ring of events with no locks and
+   no allocation after its first event; a background thread drains the
+   rings into a Chrome trace (JSON, loadable in chrome://tracing and
+   Perfetto). Timestamps come from rdtsc on x86, calibrated against the
+   monotonic clock at start, and from the monotonic clock elsewhere.
+
+   While a session runs, nexus_debug_mem_malloc & co. add an instant event
+   per allocation and free plus a "heap" counter (bytes allocated minus
+   bytes freed since start) to the same timeline.
+
+   A thread whose ring is full drops events instead of waiting; see
+   nexus_profile_dropped. Zone names are stored by pointer, so they must
+   outlive the session (string literals are the usual case). */
+
+/* Start a session writing to `path`, draining every flush_ms (0 picks
+   50 ms). NEXUS_FALSE if a session is running or the file cannot be
+   created. Not thread-safe against a concurrent start or stop. */
+NEXUS_API NEXUS_BOOL nexus_profile_start(const char *path, unsigned flush_ms);
+/* Drain what is left and close the file. NEXUS_FALSE if no session was
+   running or writing failed. */
+NEXUS_API NEXUS_BOOL nexus_profile_stop(void);
+NEXUS_API NEXUS_BOOL nexus_profile_active(void);
+
+/* Open and close a zone on the calling thread; no-ops outside a session. */
+NEXUS_API void       nexus_profile_begin(const char *name);
+NEXUS_API void       nexus_profile_end(void);
+/* Label the calling thread in the trace. */
+NEXUS_API void       nexus_profile_thread_name(const char *name);
+/* Events lost to full rings in the current (or last) session. */
+NEXUS_API size_t     nexus_profile_dropped(void);
+
+/* Markers for code that should cost nothing unless built with
+   -DNEXUS_PROFILE. C has no destructors, so every NEXUS_PROFILE_ZONE needs
+   a NEXUS_PROFILE_ZONE_END on each path out of the scope. */
+#ifdef NEXUS_PROFILE
+#  define NEXUS_PROFILE_ZONE(name)   nexus_profile_begin(name)
+#  define NEXUS_PROFILE_ZONE_END()   nexus_profile_end()
+#  define NEXUS_PROFILE_THREAD(name) nexus_profile_thread_name(name)
+#else
+#  define NEXUS_PROFILE_ZONE(name)   ((void)0)
+#  define NEXUS_PROFILE_ZONE_END()   ((void)0)
+#  define NEXUS_PROFILE_THREAD(name) ((void)0)
+#endif
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_PROFILE_H */
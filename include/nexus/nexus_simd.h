@@ -0,0 +1,47 @@
+/* nexus_simd.h — vectorized float_real kernels with runtime dispatch (C89-compatible) */
+#ifndef NEXUS_SIMD_H
+#define NEXUS_SIMD_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Array kernels over float_real (float, or double with
+   NEXUS_DOUBLE_PRECISION). The first call picks the widest instruction set
+   both the build and the CPU support; every build has the scalar path.
+   Arrays need no particular alignment (64-byte aligned ones, e.g. from
+   NEXUS_ALLOC_ALIGNED, load fastest). Reductions are summed in a
+   different order per level, so results may differ in the last bits
+   between machines; NaN inputs give unspecified min/max results. */
+typedef enum {
+    NEXUS_SIMD_SCALAR = 0,
+    NEXUS_SIMD_SSE2   = 1,
+    NEXUS_SIMD_AVX2   = 2,   /* with FMA3 */
+    NEXUS_SIMD_AVX512 = 3    /* AVX-512F */
+} nexus_simd_level;
+
+/* Widest level this build and CPU support. */
+NEXUS_API nexus_simd_level nexus_simd_detect(void);
+/* Level the kernels currently use. */
+NEXUS_API nexus_simd_level nexus_simd_active(void);
+/* Use `level`, or the widest supported one below it; returns the level in
+   effect. For tests and benchmarks; the default needs no call. */
+NEXUS_API nexus_simd_level nexus_simd_select(nexus_simd_level level);
+NEXUS_API const char      *nexus_simd_level_name(nexus_simd_level level);
+
+/* sum(a[i] * b[i]) */
+NEXUS_API float_real nexus_simd_dot(const float_real *a, const float_real *b, size_t n);
+/* y[i] += alpha * x[i] */
+NEXUS_API void       nexus_simd_axpy(float_real *y, float_real alpha, const float_real *x, size_t n);
+/* out[i] = alpha * x[i]; out may be x */
+NEXUS_API void       nexus_simd_scale(float_real *out, const float_real *x, float_real alpha, size_t n);
+/* Reductions; 0 for n == 0. */
+NEXUS_API float_real nexus_simd_sum(const float_real *x, size_t n);
+NEXUS_API float_real nexus_simd_min(const float_real *x, size_t n);
+NEXUS_API float_real nexus_simd_max(const float_real *x, size_t n);
+/* out[i] = a[i] * b[i] + c[i], fused where the level has FMA; out may be any input */
+NEXUS_API void       nexus_simd_fma(float_real *out, const float_real *a, const float_real *b,
+                                    const float_real *c, size_t n);
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_SIMD_H */
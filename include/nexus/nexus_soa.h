@@ -0,0 +1,79 @@
+/* nexus_soa.h — structure-of-arrays batches of 3D vectors and 4x4 matrices (C89-compatible) */
+#ifndef NEXUS_SOA_H
+#define NEXUS_SOA_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Each component lives in its own row: x[0..count), y[0..count), ... so a
+   SIMD register holds the same component of consecutive elements and no
+   lane is wasted. Rows start NEXUS_SOA_ALIGN-aligned and hold `capacity`
+   lanes, a multiple of NEXUS_SOA_LANES, so the bulk operations run whole
+   vectors without a scalar tail (they may overwrite the padding lanes
+   past count). Storage comes from NEXUS_ALLOC_ALIGNED_AT under the site
+   that initialised the batch. Bulk operations dispatch like nexus_simd.h. */
+#define NEXUS_SOA_ALIGN 64   /* cache line; one AVX-512 register */
+#define NEXUS_SOA_LANES (NEXUS_SOA_ALIGN / sizeof(float_real))
+
+typedef struct {
+    float_real *x, *y, *z;
+    size_t      count;
+    size_t      capacity;
+    const char *file;        /* site the storage is attributed to */
+    unsigned    line;
+} nexus_vec3_soa;
+
+/* Matrices are row-major: m[4 * row + col][i] is element (row, col) of
+   matrix i. */
+typedef struct {
+    float_real *m[16];
+    size_t      count;
+    size_t      capacity;
+    const char *file;
+    unsigned    line;
+} nexus_mat4_batch;
+
+/* Empty batch; nothing is allocated until it grows. */
+NEXUS_API void       nexus_vec3_soa_init(nexus_vec3_soa *v, const char *file, unsigned line);
+NEXUS_API void       nexus_vec3_soa_free(nexus_vec3_soa *v);
+/* NEXUS_FALSE on out-of-memory, leaving the batch unchanged. */
+NEXUS_API NEXUS_BOOL nexus_vec3_soa_reserve(nexus_vec3_soa *v, size_t capacity);
+/* New elements are zero. */
+NEXUS_API NEXUS_BOOL nexus_vec3_soa_resize(nexus_vec3_soa *v, size_t count);
+NEXUS_API NEXUS_BOOL nexus_vec3_soa_push(nexus_vec3_soa *v, float_real x, float_real y, float_real z);
+
+/* out[i] = a_i . b_i for i < a->count; b needs at least as many elements. */
+NEXUS_API void       nexus_vec3_soa_dot(float_real *out, const nexus_vec3_soa *a, const nexus_vec3_soa *b);
+/* Scale every element to unit length; zero vectors stay zero. */
+NEXUS_API void       nexus_vec3_soa_normalize(nexus_vec3_soa *v);
+/* out_i = m * (in_i, w) with m a row-major 4x4 whose bottom row is
+   ignored: w = 1 transforms points, w = 0 directions. out is resized to
+   in->count and may be in. */
+NEXUS_API NEXUS_BOOL nexus_vec3_soa_transform(nexus_vec3_soa *out, const nexus_vec3_soa *in,
+                                              const float_real m[16], float_real w);
+
+NEXUS_API void       nexus_mat4_batch_init(nexus_mat4_batch *b, const char *file, unsigned line);
+NEXUS_API void       nexus_mat4_batch_free(nexus_mat4_batch *b);
+NEXUS_API NEXUS_BOOL nexus_mat4_batch_reserve(nexus_mat4_batch *b, size_t capacity);
+/* New matrices are identity. */
+NEXUS_API NEXUS_BOOL nexus_mat4_batch_resize(nexus_mat4_batch *b, size_t count);
+/* Row-major copies in and out of matrix i (< count). */
+NEXUS_API void       nexus_mat4_batch_set(nexus_mat4_batch *b, size_t i, const float_real m[16]);
+NEXUS_API void       nexus_mat4_batch_get(const nexus_mat4_batch *b, size_t i, float_real m[16]);
+
+/* out_i = a_i * b_i for i < a->count; out is resized and may be a or b.
+   NEXUS_FALSE, leaving out untouched, if b has fewer than a->count. */
+NEXUS_API NEXUS_BOOL nexus_mat4_batch_mul(nexus_mat4_batch *out, const nexus_mat4_batch *a,
+                                          const nexus_mat4_batch *b);
+/* out_i = m_i * (in_i, w) for i < in->count, as nexus_vec3_soa_transform
+   but with a matrix per element. NEXUS_FALSE, leaving out untouched, if m
+   has fewer than in->count. */
+NEXUS_API NEXUS_BOOL nexus_mat4_batch_transform(nexus_vec3_soa *out, const nexus_mat4_batch *m,
+                                                const nexus_vec3_soa *in, float_real w);
+
+#define NEXUS_VEC3_SOA_INIT(v)   nexus_vec3_soa_init((v), __FILE__, __LINE__)
+#define NEXUS_MAT4_BATCH_INIT(b) nexus_mat4_batch_init((b), __FILE__, __LINE__)
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_SOA_H */
@@ -0,0 +1,66 @@
+/* nexus_sync.h — portable atomics, spinlock, futex wait/wake and mutex (C89-compatible) */
+#ifndef NEXUS_SYNC_H
+#define NEXUS_SYNC_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* ===== Atomics =====
+   32-bit and pointer-sized cells; loads acquire, stores release,
+   read-modify-writes are acquire-release. Plain-C types, so they work
+   from any compiler the library was built with. */
+typedef volatile nexus_u32 nexus_atomic_u32;
+typedef volatile size_t    nexus_atomic_size;
+
+NEXUS_API nexus_u32  nexus_atomic_load_u32(nexus_atomic_u32 *p);
+NEXUS_API void       nexus_atomic_store_u32(nexus_atomic_u32 *p, nexus_u32 v);
+/* These return the previous value. */
+NEXUS_API nexus_u32  nexus_atomic_add_u32(nexus_atomic_u32 *p, nexus_u32 v);
+NEXUS_API nexus_u32  nexus_atomic_xchg_u32(nexus_atomic_u32 *p, nexus_u32 v);
+/* NEXUS_TRUE if *p was expected and is now desired. */
+NEXUS_API NEXUS_BOOL nexus_atomic_cas_u32(nexus_atomic_u32 *p, nexus_u32 expected, nexus_u32 desired);
+NEXUS_API size_t     nexus_atomic_load_size(nexus_atomic_size *p);
+NEXUS_API void       nexus_atomic_store_size(nexus_atomic_size *p, size_t v);
+NEXUS_API size_t     nexus_atomic_add_size(nexus_atomic_size *p, size_t v);
+NEXUS_API NEXUS_BOOL nexus_atomic_cas_size(nexus_atomic_size *p, size_t expected, size_t desired);
+/* Full (sequentially consistent) fence. */
+NEXUS_API void       nexus_atomic_fence(void);
+
+/* ===== Spinlock =====
+   Test-and-test-and-set that yields the CPU after a short spin. For
+   critical sections of a few instructions; zero-initialise. */
+typedef nexus_atomic_u32 nexus_spinlock;
+#define NEXUS_SPINLOCK_INIT 0u
+
+NEXUS_API void       nexus_spin_lock(nexus_spinlock *l);
+NEXUS_API NEXUS_BOOL nexus_spin_trylock(nexus_spinlock *l);
+NEXUS_API void       nexus_spin_unlock(nexus_spinlock *l);
+
+/* ===== Address wait/wake =====
+   Block while *addr == expected, until a wake on addr (a futex on Linux,
+   WaitOnAddress on Windows, a polling sleep elsewhere). May return
+   spuriously; callers re-check their condition. */
+NEXUS_API void       nexus_futex_wait(nexus_atomic_u32 *addr, nexus_u32 expected);
+/* Wake one waiter, or all of them. */
+NEXUS_API void       nexus_futex_wake(nexus_atomic_u32 *addr, NEXUS_BOOL all);
+
+/* ===== Mutex =====
+   Spins briefly, then sleeps in the kernel, so long or contended critical
+   sections cost no CPU while waiting. Not recursive. Zero-initialise or
+   use NEXUS_MUTEX_INIT; needs no destruction. */
+typedef struct {
+    nexus_atomic_u32 state;     /* 0 free, 1 held, 2 held with sleepers */
+} nexus_mutex;
+#define NEXUS_MUTEX_INIT { 0u }
+
+NEXUS_API void       nexus_mutex_lock(nexus_mutex *m);
+NEXUS_API NEXUS_BOOL nexus_mutex_trylock(nexus_mutex *m);
+NEXUS_API void       nexus_mutex_unlock(nexus_mutex *m);
+
+/* Callback forms matching nexus_debug_memory_init(lock, unlock, mutex). */
+NEXUS_API void       nexus_mutex_lock_cb(void *mutex);
+NEXUS_API void       nexus_mutex_unlock_cb(void *mutex);
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_SYNC_H */
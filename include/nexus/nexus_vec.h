@@ -0,0 +1,56 @@
+/* nexus_vec.h — type-generic dynamic array (C89-compatible) */
+#ifndef NEXUS_VEC_H
+#define NEXUS_VEC_H
+
+#include "nexus/nexus.h"
+
+NEXUS_EXTERN_C_BEGIN
+
+/* Contiguous array of elem_size-byte elements that grows geometrically.
+   Storage comes from `allocator`, or from NEXUS_ALLOC & co. when it is
+   NULL, under the site that initialised the vector; growth uses the
+   allocator's reallocate. Element pointers are invalidated by anything
+   that grows the array. The NEXUS_VEC_* macros below give typed access. */
+typedef struct {
+    void                 *data;
+    size_t                count;
+    size_t                capacity;     /* elements */
+    size_t                elem_size;
+    const NexusAllocator *allocator;    /* NULL: whatever NEXUS_ALLOC uses */
+    const char           *file;         /* site the storage is attributed to */
+    unsigned              line;
+} nexus_vec;
+
+/* Empty vector; nothing is allocated until it grows. */
+NEXUS_API void       nexus_vec_init(nexus_vec *v, size_t elem_size, const NexusAllocator *allocator,
+                                    const char *file, unsigned line);
+/* Releases the storage. The vector may be reused afterwards. */
+NEXUS_API void       nexus_vec_free(nexus_vec *v);
+/* NEXUS_FALSE on out-of-memory, leaving the vector unchanged. */
+NEXUS_API NEXUS_BOOL nexus_vec_reserve(nexus_vec *v, size_t capacity);
+/* New elements are zero. */
+NEXUS_API NEXUS_BOOL nexus_vec_resize(nexus_vec *v, size_t count);
+NEXUS_API void       nexus_vec_clear(nexus_vec *v);
+
+/* Append a copy of *elem (zero when elem is NULL), which must not point
+   into v; returns the new element, NULL on out-of-memory. */
+NEXUS_API void      *nexus_vec_push(nexus_vec *v, const void *elem);
+NEXUS_API NEXUS_BOOL nexus_vec_append(nexus_vec *v, const void *elems, size_t n);
+/* Insert before index i (<= count), shifting the tail up. */
+NEXUS_API void      *nexus_vec_insert(nexus_vec *v, size_t i, const void *elem);
+/* Copy the last element to *out (if non-NULL) and drop it; NEXUS_FALSE when empty. */
+NEXUS_API NEXUS_BOOL nexus_vec_pop(nexus_vec *v, void *out);
+/* Drop element i keeping order (O(n)), or by moving the last one into
+   its place (O(1)). */
+NEXUS_API void       nexus_vec_remove(nexus_vec *v, size_t i);
+NEXUS_API void       nexus_vec_remove_swap(nexus_vec *v, size_t i);
+
+#define NEXUS_VEC_INIT(v, type) nexus_vec_init((v), sizeof(type), NULL, __FILE__, __LINE__)
+#define NEXUS_VEC_DATA(v, type) ((type*)(v)->data)
+#define NEXUS_VEC_AT(v, type, i) (((type*)(v)->data)[i])
+/* Append an rvalue; evaluates v more than once. NEXUS_FALSE on out-of-memory. */
+#define NEXUS_VEC_PUSH(v, type, value) \
+    (nexus_vec_push((v), NULL) ? (NEXUS_VEC_AT((v), type, (v)->count - 1u) = (value), NEXUS_TRUE) : NEXUS_FALSE)
+
+NEXUS_EXTERN_C_END
+#endif /* NEXUS_VEC_H */
@@ -0,0 +1,542 @@
+/* nexus_preload.c — debug allocator tracking for unmodified binaries
+ *
+ *   LD_PRELOAD=libnexus_preload.so ./service
+ *
+ * Interposes malloc, free, realloc, calloc, reallocarray, posix_memalign,
+ * aligned_alloc, memalign, valloc, pvalloc and malloc_usable_size, and
+ * routes them through the debug allocator. Sites are the calling module
+ * and the return address's offset in it ("libfoo.so line: 74213" is
+ * addr2line -e libfoo.so 0x121e5).
+ *
+ * Environment:
+ *   NEXUS_PRELOAD_SAMPLE      bytes per tracked sample (default 524288, 0 = all)
+ *   NEXUS_PRELOAD_STACK       frames captured per tracked block (default 0)
+ *   NEXUS_PRELOAD_QUARANTINE  quarantine budget in bytes (default 0)
+ *   NEXUS_PRELOAD_PAGE_GUARD  guard-page blocks of at least this size (default 0)
+ *   NEXUS_PRELOAD_DUMP        exit | signal | both | none (default exit)
+ *   NEXUS_PRELOAD_SIGNAL      signal number that requests a dump (default SIGUSR2)
+ *   NEXUS_PRELOAD_OUT         snapshot path prefix (default "nexus"); files are
+ *                             PREFIX.PID.N.nxsnap, readable by nexus_snapdiff
+ *
+ * The debug allocator's own bookkeeping calls malloc too; a per-thread
+ * depth counter sends those calls (and anything libc does on our behalf)
+ * straight to the next malloc in the chain. While that chain is being
+ * looked up, requests are served from a small static arena.
+ */
+
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE 1 /* RTLD_NEXT, dladdr() */
+#endif
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nexus/nexus.h"
+#include "nexus/nexus_mem_snapshot.h"
+#include "nexus_memory_debug.h"
+
+#define NEXUS_EXPORT __attribute__((visibility("default")))
+
+/* ------------------------------------------------------------------ */
+/* Types & globals                                                     */
+/* ------------------------------------------------------------------ */
+#define NEXUS_PRELOAD_BOOTSTRAP   (64u * 1024u)   /* arena used while dlsym runs */
+#define NEXUS_PRELOAD_SITE_CACHE  128u            /* per-thread return address -> site */
+#define NEXUS_PRELOAD_MAX_SIZE    ((size_t)-1 / 2u)
+
+enum { NEXUS_PRELOAD_UNINIT, NEXUS_PRELOAD_INITIALIZING, NEXUS_PRELOAD_READY };
+
+typedef struct {
+    void       *ret;
+    const char *file;
+    unsigned    line;
+} NexusPreloadSite;
+
+static void *(*g_real_malloc)(size_t);
+static void  (*g_real_free)(void *);
+static void *(*g_real_realloc)(void *, size_t);
+static void *(*g_real_calloc)(size_t, size_t);
+static int   (*g_real_posix_memalign)(void **, size_t, size_t);
+static size_t (*g_real_usable_size)(void *);
+
+static volatile int g_state = NEXUS_PRELOAD_UNINIT;
+
+/* Bootstrap arena: bump allocation, each block preceded by its size; never freed. */
+static union { double align; unsigned char bytes[NEXUS_PRELOAD_BOOTSTRAP]; } g_bootstrap;
+static size_t g_bootstrap_used = 0u;
+
+static int                   g_dump_at_exit = 1;
+static const char           *g_dump_prefix = "nexus";
+static volatile unsigned     g_dump_seq = 0u;
+static volatile sig_atomic_t g_dump_pending = 0;
+
+/* Initial-exec: the depth counter is read on every call, including from
+   inside __tls_get_addr's own allocations, so it must never allocate. */
+static __thread unsigned         t_depth __attribute__((tls_model("initial-exec")));
+static __thread NexusPreloadSite t_sites[NEXUS_PRELOAD_SITE_CACHE]
+    __attribute__((tls_model("initial-exec")));
+
+/* ------------------------------------------------------------------ */
+/* Bootstrap                                                           */
+/* ------------------------------------------------------------------ */
+
+static void *nexus__bootstrap_alloc(size_t size)
+{
+    size_t need = 16u + ((size + 15u) & ~(size_t)15u);
+    unsigned char *p;
+
+    if (size > NEXUS_PRELOAD_BOOTSTRAP || need > NEXUS_PRELOAD_BOOTSTRAP - g_bootstrap_used) {
+        static const char msg[] = "nexus_preload: bootstrap arena exhausted\n";
+        (void)!write(2, msg, sizeof msg - 1u);
+        abort();
+    }
+    p = g_bootstrap.bytes + g_bootstrap_used;
+    g_bootstrap_used += need;
+    *(size_t*)p = size;
+    return p + 16u;
+}
+
+static int nexus__is_bootstrap(const void *ptr)
+{
+    const unsigned char *p = (const unsigned char*)ptr;
+    return p >= g_bootstrap.bytes && p < g_bootstrap.bytes + NEXUS_PRELOAD_BOOTSTRAP;
+}
+
+static size_t nexus__bootstrap_size(const void *ptr)
+{
+    return *(const size_t*)((const unsigned char*)ptr - 16u);
+}
+
+/* ------------------------------------------------------------------ */
+/* Dumps                                                               */
+/* ------------------------------------------------------------------ */
+
+static void nexus__preload_dump(void)
+{
+    char path[512];
+    nexus_mem_snapshot *snap;
+    unsigned seq = __sync_fetch_and_add(&g_dump_seq, 1u);
+
+    if (strlen(g_dump_prefix) > sizeof path - 64u) return;
+    sprintf(path, "%s.%ld.%u.nxsnap", g_dump_prefix, (long)getpid(), seq);
+    t_depth += 1u;
+    snap = nexus_debug_mem_snapshot();
+    if (!snap || nexus_mem_snapshot_write(snap, path) != 0)
+        fprintf(stderr, "nexus_preload: cannot write %s\n", path);
+    nexus_mem_snapshot_free(snap);
+    t_depth -= 1u;
+}
+
+/* Only flags the request: the next thread to allocate writes the dump,
+   outside the handler and without holding any allocator lock. */
+static void nexus__preload_on_signal(int sig)
+{
+    (void)sig;
+    g_dump_pending = 1;
+}
+
+static void nexus__preload_poll(void)
+{
+    if (g_dump_pending && __sync_lock_test_and_set(&g_dump_pending, 0)) nexus__preload_dump();
+}
+
+static void nexus__preload_fork_lock(void)
+{
+    if (!t_depth) nexus__debug_mem_fork_lock();
+}
+
+static void nexus__preload_fork_unlock(void)
+{
+    if (!t_depth) nexus__debug_mem_fork_unlock();
+}
+
+/* ------------------------------------------------------------------ */
+/* Init                                                                */
+/* ------------------------------------------------------------------ */
+
+static size_t nexus__env_size(const char *name, size_t fallback)
+{
+    const char *v = getenv(name);
+    return (v && *v) ? (size_t)strtoul(v, NULL, 0) : fallback;
+}
+
+static void nexus__preload_configure(void)
+{
+    const char *dump = getenv("NEXUS_PRELOAD_DUMP");
+    const char *out  = getenv("NEXUS_PRELOAD_OUT");
+    int on_signal = 0, sig;
+
+    nexus_debug_mem_set_sample_rate(nexus__env_size("NEXUS_PRELOAD_SAMPLE", 512u * 1024u));
+    nexus_debug_mem_set_stack_depth((unsigned)nexus__env_size("NEXUS_PRELOAD_STACK", 0u));
+    nexus_debug_mem_set_quarantine(nexus__env_size("NEXUS_PRELOAD_QUARANTINE", 0u));
+    nexus_debug_mem_set_page_guard(nexus__env_size("NEXUS_PRELOAD_PAGE_GUARD", 0u), 0u);
+    if (out && *out) g_dump_prefix = out;
+
+    if (dump && strcmp(dump, "none") == 0) {
+        g_dump_at_exit = 0;
+    } else if (dump && strcmp(dump, "signal") == 0) {
+        g_dump_at_exit = 0;
+        on_signal = 1;
+    } else if (dump && strcmp(dump, "both") == 0) {
+        on_signal = 1;
+    }
+    if (on_signal) {
+        struct sigaction sa;
+        sig = (int)nexus__env_size("NEXUS_PRELOAD_SIGNAL", (size_t)SIGUSR2);
+        memset(&sa, 0, sizeof sa);
+        sa.sa_handler = nexus__preload_on_signal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        if (sigaction(sig, &sa, NULL) != 0)
+            fprintf(stderr, "nexus_preload: cannot install handler for signal %d\n", sig);
+    }
+}
+
+/* Looks up the next allocator in the chain and applies the environment.
+   The first caller does the work; other threads wait, and calls the
+   initializing thread makes into malloc meanwhile (dlsym allocates) hit
+   the bootstrap arena via t_depth. */
+static void nexus__preload_init(void)
+{
+    if (g_state == NEXUS_PRELOAD_READY) return;
+    if (!__sync_bool_compare_and_swap(&g_state, NEXUS_PRELOAD_UNINIT, NEXUS_PRELOAD_INITIALIZING)) {
+        while (g_state != NEXUS_PRELOAD_READY) sched_yield();
+        return;
+    }
+
+    t_depth += 1u;
+    *(void**)&g_real_malloc         = dlsym(RTLD_NEXT, "malloc");
+    *(void**)&g_real_free           = dlsym(RTLD_NEXT, "free");
+    *(void**)&g_real_realloc        = dlsym(RTLD_NEXT, "realloc");
+    *(void**)&g_real_calloc         = dlsym(RTLD_NEXT, "calloc");
+    *(void**)&g_real_posix_memalign = dlsym(RTLD_NEXT, "posix_memalign");
+    *(void**)&g_real_usable_size    = dlsym(RTLD_NEXT, "malloc_usable_size");
+    if (!g_real_malloc || !g_real_free || !g_real_realloc || !g_real_calloc
+        || !g_real_posix_memalign) {
+        static const char msg[] = "nexus_preload: cannot find the next malloc\n";
+        (void)!write(2, msg, sizeof msg - 1u);
+        abort();
+    }
+    nexus__preload_configure();
+    pthread_atfork(nexus__preload_fork_lock, nexus__preload_fork_unlock, nexus__preload_fork_unlock);
+    t_depth -= 1u;
+
+    __sync_synchronize();
+    g_state = NEXUS_PRELOAD_READY;
+}
+
+__attribute__((constructor))
+static void nexus__preload_ctor(void)
+{
+    nexus__preload_init();
+}
+
+__attribute__((destructor))
+static void nexus__preload_dtor(void)
+{
+    if (g_state == NEXUS_PRELOAD_READY && g_dump_at_exit) nexus__preload_dump();
+}
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Nonzero when the call must bypass tracking: re-entered from the debug
+   allocator or libc, or still bootstrapping. Otherwise the caller is
+   tracked and must leave through nexus__preload_leave. */
+static int nexus__preload_enter(void)
+{
+    if (t_depth) return 1;
+    if (g_state != NEXUS_PRELOAD_READY) {
+        nexus__preload_init();
+        if (t_depth) return 1;
+    }
+    nexus__preload_poll();
+    t_depth += 1u;
+    return 0;
+}
+
+static void nexus__preload_leave(void)
+{
+    t_depth -= 1u;
+}
+
+/* Module and offset of a return address, cached per thread. */
+static void nexus__preload_site(void *ret, const char **file, unsigned *line)
+{
+    NexusPreloadSite *c = &t_sites[((size_t)ret >> 4) % NEXUS_PRELOAD_SITE_CACHE];
+    Dl_info info;
+
+    if (c->ret != ret || !c->file) {
+        c->ret = ret;
+        if (dladdr(ret, &info) && info.dli_fbase) {
+            c->file = (info.dli_fname && *info.dli_fname) ? info.dli_fname : "<main>";
+            c->line = (unsigned)((const char*)ret - (const char*)info.dli_fbase);
+        } else {
+            c->file = "<unknown>";
+            c->line = (unsigned)(size_t)ret;
+        }
+    }
+    *file = c->file;
+    *line = c->line;
+}
+
+static void *nexus__preload_malloc(size_t size, void *ret)
+{
+    const char *file;
+    unsigned line;
+
+    if (size > NEXUS_PRELOAD_MAX_SIZE) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    /* Never zero bytes: a tracked block must report a non-zero size so
+       free and realloc can tell it from a foreign pointer. */
+    if (!size) size = 1u;
+    nexus__preload_site(ret, &file, &line);
+    return nexus_debug_mem_malloc(size, file, line);
+}
+
+static void *nexus__preload_aligned(size_t align, size_t size, void *ret)
+{
+    const char *file;
+    unsigned line;
+
+    if (size > NEXUS_PRELOAD_MAX_SIZE || align > NEXUS_PRELOAD_MAX_SIZE) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!size) size = 1u;
+    nexus__preload_site(ret, &file, &line);
+    return nexus_debug_mem_malloc_aligned(size, align, file, line);
+}
+
+/* Untracked aligned block for re-entrant calls. */
+static void *nexus__real_aligned(size_t align, size_t size)
+{
+    unsigned char *p, *q;
+
+    if (align < sizeof(void*)) align = sizeof(void*);
+    if (g_real_posix_memalign) {
+        void *r = NULL;
+        return g_real_posix_memalign(&r, align, size) == 0 ? r : NULL;
+    }
+    if (size > (size_t)-1 - align) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    /* Over-allocate from the arena and round up. Arena blocks are 16-byte
+       aligned, so any skipped prefix is a multiple of 16 and has room for
+       the size word that nexus__bootstrap_size reads. */
+    p = (unsigned char*)nexus__bootstrap_alloc(size + align);
+    q = (unsigned char*)(((size_t)p + align - 1u) & ~(align - 1u));
+    if (q != p) *(size_t*)(q - 16u) = size;
+    return q;
+}
+
+/* The debug allocator's own blocks go back to it; anything it does not
+   recognise was handed out by the real allocator on a re-entrant call. */
+static void nexus__preload_free(void *ptr)
+{
+    NEXUS_BOOL aligned;
+
+    if (!nexus__debug_mem_block(ptr, &aligned)) g_real_free(ptr);
+    else if (aligned) nexus_debug_mem_free_aligned(ptr);
+    else nexus_debug_mem_free(ptr);
+}
+
+static int nexus__is_pow2(size_t n)
+{
+    return n && !(n & (n - 1u));
+}
+
+/* ------------------------------------------------------------------ */
+/* Interposed entry points                                             */
+/* ------------------------------------------------------------------ */
+
+NEXUS_EXPORT void *malloc(size_t size)
+{
+    void *p;
+
+    if (nexus__preload_enter())
+        return g_real_malloc ? g_real_malloc(size) : nexus__bootstrap_alloc(size);
+    p = nexus__preload_malloc(size, __builtin_return_address(0));
+    nexus__preload_leave();
+    return p;
+}
+
+NEXUS_EXPORT void free(void *ptr)
+{
+    if (!ptr || nexus__is_bootstrap(ptr)) return;
+    if (nexus__preload_enter()) {
+        g_real_free(ptr);
+        return;
+    }
+    nexus__preload_free(ptr);
+    nexus__preload_leave();
+}
+
+NEXUS_EXPORT void *calloc(size_t count, size_t size)
+{
+    void *p;
+
+    if (size && count > (size_t)-1 / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (nexus__preload_enter()) {
+        if (g_real_calloc) return g_real_calloc(count, size);
+        return nexus__bootstrap_alloc(count * size);   /* static storage: already zero */
+    }
+    p = nexus__preload_malloc(count * size, __builtin_return_address(0));
+    if (p) memset(p, 0, count * size);
+    nexus__preload_leave();
+    return p;
+}
+
+NEXUS_EXPORT void *realloc(void *ptr, size_t size)
+{
+    void *ret = __builtin_return_address(0), *p;
+    NEXUS_BOOL aligned;
+    size_t old;
+
+    if (ptr && nexus__is_bootstrap(ptr)) {
+        /* Outgrow the arena: copy into a regular block. */
+        p = malloc(size);
+        old = nexus__bootstrap_size(ptr);
+        if (p) memcpy(p, ptr, old < size ? old : size);
+        return p;
+    }
+    if (nexus__preload_enter()) return g_real_realloc(ptr, size);
+
+    if (!ptr) {
+        p = nexus__preload_malloc(size, ret);
+    } else if (!size) {
+        nexus__preload_free(ptr);
+        p = NULL;
+    } else if (size > NEXUS_PRELOAD_MAX_SIZE) {
+        errno = ENOMEM;
+        p = NULL;
+    } else {
+        old = nexus__debug_mem_block(ptr, &aligned);
+        if (!old) {
+            /* Came from the real allocator on a re-entrant call. */
+            p = g_real_realloc(ptr, size);
+        } else if (aligned) {
+            /* The debug allocator refuses to realloc aligned blocks; C does not. */
+            p = nexus__preload_malloc(size, ret);
+            if (p) {
+                memcpy(p, ptr, old < size ? old : size);
+                nexus_debug_mem_free_aligned(ptr);
+            }
+        } else {
+            const char *file;
+            unsigned line;
+            nexus__preload_site(ret, &file, &line);
+            p = nexus_debug_mem_realloc(ptr, size, file, line);
+        }
+    }
+    nexus__preload_leave();
+    return p;
+}
+
+NEXUS_EXPORT void *reallocarray(void *ptr, size_t count, size_t size)
+{
+    if (size && count > (size_t)-1 / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr, count * size);
+}
+
+NEXUS_EXPORT int posix_memalign(void **out, size_t align, size_t size)
+{
+    void *p;
+
+    if (!nexus__is_pow2(align) || align % sizeof(void*)) return EINVAL;
+    if (nexus__preload_enter()) {
+        if (!g_real_posix_memalign) {
+            *out = nexus__real_aligned(align, size);
+            return 0;
+        }
+        return g_real_posix_memalign(out, align, size);
+    }
+    p = nexus__preload_aligned(align, size, __builtin_return_address(0));
+    nexus__preload_leave();
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+NEXUS_EXPORT void *aligned_alloc(size_t align, size_t size)
+{
+    void *p;
+
+    if (!nexus__is_pow2(align)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (nexus__preload_enter()) return nexus__real_aligned(align, size);
+    p = nexus__preload_aligned(align, size, __builtin_return_address(0));
+    nexus__preload_leave();
+    return p;
+}
+
+NEXUS_EXPORT void *memalign(size_t align, size_t size)
+{
+    void *p;
+
+    if (!nexus__is_pow2(align)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (nexus__preload_enter()) return nexus__real_aligned(align, size);
+    p = nexus__preload_aligned(align, size, __builtin_return_address(0));
+    nexus__preload_leave();
+    return p;
+}
+
+NEXUS_EXPORT void *valloc(size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void *p;
+
+    if (nexus__preload_enter()) return nexus__real_aligned(page, size);
+    p = nexus__preload_aligned(page, size, __builtin_return_address(0));
+    nexus__preload_leave();
+    return p;
+}
+
+NEXUS_EXPORT void *pvalloc(size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void *p;
+
+    size = (size + page - 1u) & ~(page - 1u);
+    if (nexus__preload_enter()) return nexus__real_aligned(page, size);
+    p = nexus__preload_aligned(page, size, __builtin_return_address(0));
+    nexus__preload_leave();
+    return p;
+}
+
+/* Reports the requested size for tracked blocks: writing past it is
+   exactly what the guards are there to catch. */
+NEXUS_EXPORT size_t malloc_usable_size(void *ptr)
+{
+    NEXUS_BOOL aligned;
+    size_t n;
+
+    if (!ptr) return 0u;
+    if (nexus__is_bootstrap(ptr)) return nexus__bootstrap_size(ptr);
+    if (nexus__preload_enter()) return g_real_usable_size ? g_real_usable_size(ptr) : 0u;
+    n = nexus__debug_mem_block(ptr, &aligned);
+    nexus__preload_leave();
+    return n;
+}
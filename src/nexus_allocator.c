@@ -0,0 +1,255 @@
+/* nexus_allocator.c — runtime allocator installation and built-in vtables */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* posix_memalign() under -std=c90 */
+#endif
+
+#include <stdlib.h>
+#include <nexus/nexus.h>
+#include "nexus_atomic.h"
+
+/* The built-in vtables must reach the real CRT. */
+#ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
+#  undef malloc
+#  undef realloc
+#  undef free
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Installation state                                                  */
+/* ------------------------------------------------------------------ */
+unsigned nexus_allocator_installed = 0u;
+
+static void *volatile g_allocator = NULL;                      /* const NexusAllocator* */
+static NEXUS_THREAD_LOCAL const NexusAllocator *t_allocator = NULL;
+
+static void nexus__installed_delta(const NexusAllocator *prev, const NexusAllocator *next)
+{
+    volatile nexus_u32 *count = (volatile nexus_u32*)&nexus_allocator_installed;
+    if (!prev && next) nexus__atomic_add_u32(count, 1u);
+    if (prev && !next) nexus__atomic_add_u32(count, (nexus_u32)-1);
+}
+
+/* ------------------------------------------------------------------ */
+/* System (CRT) vtable                                                 */
+/* ------------------------------------------------------------------ */
+static void *nexus__sys_alloc(void *ctx, size_t size, const char *file, unsigned line)
+{
+    (void)ctx; (void)file; (void)line;
+    return malloc(size);
+}
+
+static void *nexus__sys_realloc(void *ctx, void *ptr, size_t size, const char *file, unsigned line)
+{
+    (void)ctx; (void)file; (void)line;
+    return realloc(ptr, size);
+}
+
+static void nexus__sys_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static void *nexus__sys_alloc_aligned(void *ctx, size_t size, size_t align, const char *file, unsigned line)
+{
+    void *p = NULL;
+    (void)ctx; (void)file; (void)line;
+#if defined(_WIN32)
+    p = _aligned_malloc(size ? size : 1u, align);
+#else
+    if (align < sizeof(void*)) align = sizeof(void*);
+    if (posix_memalign(&p, align, size ? size : 1u) != 0) p = NULL;
+#endif
+    return p;
+}
+
+static void nexus__sys_free_aligned(void *ctx, void *ptr)
+{
+    (void)ctx;
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+static const NexusAllocator g_system_allocator = {
+    nexus__sys_alloc, nexus__sys_free, nexus__sys_realloc,
+    nexus__sys_alloc_aligned, nexus__sys_free_aligned, NULL
+};
+
+/* ------------------------------------------------------------------ */
+/* Debug allocator vtable                                              */
+/* ------------------------------------------------------------------ */
+static void *nexus__dbg_alloc(void *ctx, size_t size, const char *file, unsigned line)
+{
+    (void)ctx;
+    return nexus_debug_mem_malloc(size, file, line);
+}
+
+static void *nexus__dbg_realloc(void *ctx, void *ptr, size_t size, const char *file, unsigned line)
+{
+    (void)ctx;
+    return nexus_debug_mem_realloc(ptr, size, file, line);
+}
+
+static void nexus__dbg_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    nexus_debug_mem_free(ptr);
+}
+
+static void *nexus__dbg_alloc_aligned(void *ctx, size_t size, size_t align, const char *file, unsigned line)
+{
+    (void)ctx;
+    return nexus_debug_mem_malloc_aligned(size, align, file, line);
+}
+
+static void nexus__dbg_free_aligned(void *ctx, void *ptr)
+{
+    (void)ctx;
+    nexus_debug_mem_free_aligned(ptr);
+}
+
+static const NexusAllocator g_debug_allocator = {
+    nexus__dbg_alloc, nexus__dbg_free, nexus__dbg_realloc,
+    nexus__dbg_alloc_aligned, nexus__dbg_free_aligned, NULL
+};
+
+#ifdef NEXUS_MEMORY_DEBUG
+#  define NEXUS__BACKEND_ALLOCATOR g_debug_allocator
+#else
+#  define NEXUS__BACKEND_ALLOCATOR g_system_allocator
+#endif
+
+#ifdef NEXUS_MEMORY_STATS
+/* ------------------------------------------------------------------ */
+/* Counting vtable (default with NEXUS_MEMORY_STATS)                   */
+/* ------------------------------------------------------------------ */
+static void *nexus__stats_alloc(void *ctx, size_t size, const char *file, unsigned line)
+{
+    (void)ctx;
+    return nexus_mem_stats_malloc(size, file, line);
+}
+
+static void *nexus__stats_realloc(void *ctx, void *ptr, size_t size, const char *file, unsigned line)
+{
+    (void)ctx;
+    return nexus_mem_stats_realloc(ptr, size, file, line);
+}
+
+static void nexus__stats_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    nexus_mem_stats_free(ptr);
+}
+
+/* Aligned blocks skip the counters and go straight to the backend. */
+static void *nexus__stats_alloc_aligned(void *ctx, size_t size, size_t align, const char *file, unsigned line)
+{
+    (void)ctx;
+    return NEXUS__BACKEND_ALLOCATOR.allocate_aligned(NULL, size, align, file, line);
+}
+
+static void nexus__stats_free_aligned(void *ctx, void *ptr)
+{
+    (void)ctx;
+    NEXUS__BACKEND_ALLOCATOR.deallocate_aligned(NULL, ptr);
+}
+
+static const NexusAllocator g_stats_allocator = {
+    nexus__stats_alloc, nexus__stats_free, nexus__stats_realloc,
+    nexus__stats_alloc_aligned, nexus__stats_free_aligned, NULL
+};
+
+#  define NEXUS__DEFAULT_ALLOCATOR g_stats_allocator
+#else
+#  define NEXUS__DEFAULT_ALLOCATOR NEXUS__BACKEND_ALLOCATOR
+#endif
+
+static const NexusAllocator *nexus__resolve(const NexusAllocator *allocator)
+{
+    if (allocator) return allocator;
+    if (t_allocator) return t_allocator;
+    allocator = (const NexusAllocator*)nexus__atomic_load_ptr(&g_allocator);
+    return allocator ? allocator : &NEXUS__DEFAULT_ALLOCATOR;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+const NexusAllocator *nexus_allocator_set_global(const NexusAllocator *allocator)
+{
+    const NexusAllocator *prev =
+        (const NexusAllocator*)nexus__atomic_xchg_ptr(&g_allocator, (void*)allocator);
+    nexus__installed_delta(prev, allocator);
+    return prev;
+}
+
+const NexusAllocator *nexus_allocator_set_thread(const NexusAllocator *allocator)
+{
+    const NexusAllocator *prev = t_allocator;
+    t_allocator = allocator;
+    nexus__installed_delta(prev, allocator);
+    return prev;
+}
+
+const NexusAllocator *nexus_allocator_current(void)
+{
+    if (t_allocator) return t_allocator;
+    return (const NexusAllocator*)nexus__atomic_load_ptr(&g_allocator);
+}
+
+const NexusAllocator *nexus_allocator_system(void)
+{
+    return &g_system_allocator;
+}
+
+const NexusAllocator *nexus_allocator_debug(void)
+{
+    return &g_debug_allocator;
+}
+
+const NexusAllocator *nexus_allocator_default(void)
+{
+    return &NEXUS__DEFAULT_ALLOCATOR;
+}
+
+void *nexus_allocator_alloc(const NexusAllocator *allocator, size_t size, const char *file, unsigned line)
+{
+    allocator = nexus__resolve(allocator);
+    return allocator->allocate(allocator->ctx, size, file, line);
+}
+
+void *nexus_allocator_realloc(const NexusAllocator *allocator, void *ptr, size_t size,
+                              const char *file, unsigned line)
+{
+    allocator = nexus__resolve(allocator);
+    if (!ptr) return allocator->allocate(allocator->ctx, size, file, line);
+    if (!allocator->reallocate) return NULL;
+    return allocator->reallocate(allocator->ctx, ptr, size, file, line);
+}
+
+void nexus_allocator_free(const NexusAllocator *allocator, void *ptr)
+{
+    if (!ptr) return;
+    allocator = nexus__resolve(allocator);
+    allocator->deallocate(allocator->ctx, ptr);
+}
+
+void *nexus_allocator_alloc_aligned(const NexusAllocator *allocator, size_t size, size_t align,
+                                    const char *file, unsigned line)
+{
+    allocator = nexus__resolve(allocator);
+    if (!allocator->allocate_aligned || !align || (align & (align - 1u))) return NULL;
+    return allocator->allocate_aligned(allocator->ctx, size, align, file, line);
+}
+
+void nexus_allocator_free_aligned(const NexusAllocator *allocator, void *ptr)
+{
+    if (!ptr) return;
+    allocator = nexus__resolve(allocator);
+    if (allocator->deallocate_aligned) allocator->deallocate_aligned(allocator->ctx, ptr);
+}
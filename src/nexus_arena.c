@@ -0,0 +1,221 @@
+/* nexus_arena.c — linear (bump) allocator over chained blocks */
+
+#include <string.h>
+#include "nexus/nexus_arena.h"
+
+struct nexus_arena_block {
+    nexus_arena_block *prev;      /* older block */
+    size_t             capacity;  /* payload bytes after the block header */
+    size_t             used;
+};
+
+/* Block header rounded so the payload starts NEXUS_ARENA_ALIGN-aligned. */
+#define NEXUS_ARENA_BLOCK_HEADER \
+    (((sizeof(nexus_arena_block) + NEXUS_ARENA_ALIGN - 1) / NEXUS_ARENA_ALIGN) * NEXUS_ARENA_ALIGN)
+
+/* Rewound bytes are poisoned in Debug builds so stale pointers read garbage. */
+#define NEXUS_ARENA_POISON 0xCD
+
+static nexus_u8 *nexus__arena_data(nexus_arena_block *b)
+{
+    return (nexus_u8*)b + NEXUS_ARENA_BLOCK_HEADER;
+}
+
+static void nexus__arena_poison(nexus_arena_block *b, size_t from)
+{
+#ifdef NEXUS_MEMORY_DEBUG
+    memset(nexus__arena_data(b) + from, NEXUS_ARENA_POISON, b->used - from);
+#else
+    (void)b; (void)from;
+#endif
+}
+
+/* Chain a block able to hold size bytes at align behind the current head. */
+static nexus_arena_block *nexus__arena_grow(nexus_arena *arena, size_t size, size_t align)
+{
+    size_t cap = arena->block_size;
+    nexus_arena_block *b;
+
+    if (size > (size_t)-1 - align - NEXUS_ARENA_BLOCK_HEADER) return NULL;
+    if (cap < size + align) cap = size + align;   /* oversized request: dedicated block */
+
+    b = (nexus_arena_block*)nexus_allocator_alloc(arena->parent, NEXUS_ARENA_BLOCK_HEADER + cap,
+                                                  arena->file, arena->line);
+    if (!b) return NULL;
+    b->prev     = arena->head;
+    b->capacity = cap;
+    b->used     = 0u;
+    arena->head = b;
+    return b;
+}
+
+static void *nexus__arena_vt_alloc(void *ctx, size_t size, const char *file, unsigned line);
+
+void nexus_arena_init(nexus_arena *arena, size_t block_size, const char *file, unsigned line)
+{
+    const NexusAllocator *parent = nexus_allocator_current();
+
+    /* Growing through our own vtable would recurse. */
+    if (!parent || (parent->allocate == nexus__arena_vt_alloc && parent->ctx == arena))
+        parent = nexus_allocator_default();
+
+    arena->head       = NULL;
+    arena->block_size = block_size ? block_size : 64u * 1024u;
+    arena->parent     = parent;
+    arena->file       = file;
+    arena->line       = line;
+}
+
+void nexus_arena_free(nexus_arena *arena)
+{
+    while (arena->head) {
+        nexus_arena_block *prev = arena->head->prev;
+        NEXUS_ALLOCATOR_FREE(arena->parent, arena->head);
+        arena->head = prev;
+    }
+}
+
+void *nexus_arena_alloc_aligned(nexus_arena *arena, size_t size, size_t align)
+{
+    nexus_arena_block *b = arena->head;
+    size_t offset;
+
+    if (align < 1u) align = 1u;
+    if (b) {
+        /* Payload base is NEXUS_ARENA_ALIGN-aligned; larger aligns use the address. */
+        size_t base = (size_t)nexus__arena_data(b);
+        offset = ((base + b->used + align - 1u) & ~(align - 1u)) - base;
+        if (offset <= b->capacity && size <= b->capacity - offset) {
+            b->used = offset + size;
+            return nexus__arena_data(b) + offset;
+        }
+    }
+
+    b = nexus__arena_grow(arena, size, align);
+    if (!b) return NULL;
+    {
+        size_t base = (size_t)nexus__arena_data(b);
+        offset = ((base + align - 1u) & ~(align - 1u)) - base;
+    }
+    b->used = offset + size;
+    return nexus__arena_data(b) + offset;
+}
+
+void *nexus_arena_alloc(nexus_arena *arena, size_t size)
+{
+    return nexus_arena_alloc_aligned(arena, size, NEXUS_ARENA_ALIGN);
+}
+
+nexus_arena_mark nexus_arena_get_mark(const nexus_arena *arena)
+{
+    nexus_arena_mark m;
+    m.block = arena->head;
+    m.used  = arena->head ? arena->head->used : 0u;
+    return m;
+}
+
+void nexus_arena_rewind(nexus_arena *arena, nexus_arena_mark mark)
+{
+    while (arena->head && arena->head != mark.block) {
+        nexus_arena_block *prev = arena->head->prev;
+        NEXUS_ALLOCATOR_FREE(arena->parent, arena->head);
+        arena->head = prev;
+    }
+    if (arena->head && mark.used < arena->head->used) {
+        nexus__arena_poison(arena->head, mark.used);
+        arena->head->used = mark.used;
+    }
+}
+
+void nexus_arena_reset(nexus_arena *arena)
+{
+    nexus_arena_block *keep = arena->head;
+    if (!keep) return;
+
+    while (keep->prev) {
+        nexus_arena_block *prev = keep->prev->prev;
+        NEXUS_ALLOCATOR_FREE(arena->parent, keep->prev);
+        keep->prev = prev;
+    }
+    nexus__arena_poison(keep, 0u);
+    keep->used = 0u;
+}
+
+size_t nexus_arena_used(const nexus_arena *arena)
+{
+    const nexus_arena_block *b;
+    size_t total = 0u;
+    for (b = arena->head; b; b = b->prev) total += b->used;
+    return total;
+}
+
+/* ------------------------------------------------------------------ */
+/* NexusAllocator adapter                                              */
+/* ------------------------------------------------------------------ */
+
+/* Each block carries its size in the NEXUS_ARENA_ALIGN bytes before it. */
+static size_t nexus__arena_vt_size(const void *ptr)
+{
+    size_t size;
+    memcpy(&size, (const nexus_u8*)ptr - sizeof size, sizeof size);
+    return size;
+}
+
+static void *nexus__arena_vt_alloc(void *ctx, size_t size, const char *file, unsigned line)
+{
+    nexus_u8 *p;
+    (void)file; (void)line;
+    if (size > (size_t)-1 - NEXUS_ARENA_ALIGN) return NULL;
+    p = (nexus_u8*)nexus_arena_alloc((nexus_arena*)ctx, NEXUS_ARENA_ALIGN + size);
+    if (!p) return NULL;
+    p += NEXUS_ARENA_ALIGN;
+    memcpy(p - sizeof size, &size, sizeof size);
+    return p;
+}
+
+static void *nexus__arena_vt_realloc(void *ctx, void *ptr, size_t size, const char *file, unsigned line)
+{
+    nexus_arena       *arena = (nexus_arena*)ctx;
+    nexus_arena_block *b     = arena->head;
+    size_t old = nexus__arena_vt_size(ptr);
+    nexus_u8 *p;
+
+    /* Newest allocation in the newest block: move the bump pointer. */
+    if (b && (nexus_u8*)ptr + old == nexus__arena_data(b) + b->used) {
+        size_t offset = (size_t)((nexus_u8*)ptr - nexus__arena_data(b));
+        if (size <= b->capacity - offset) {
+            if (size < old) nexus__arena_poison(b, offset + size);
+            b->used = offset + size;
+            memcpy((nexus_u8*)ptr - sizeof size, &size, sizeof size);
+            return ptr;
+        }
+    } else if (size <= old) {
+        return ptr;
+    }
+
+    p = (nexus_u8*)nexus__arena_vt_alloc(ctx, size, file, line);
+    if (p) memcpy(p, ptr, old < size ? old : size);
+    return p;
+}
+
+static void nexus__arena_vt_free(void *ctx, void *ptr)
+{
+    (void)ctx; (void)ptr;
+}
+
+static void *nexus__arena_vt_alloc_aligned(void *ctx, size_t size, size_t align,
+                                           const char *file, unsigned line)
+{
+    (void)file; (void)line;
+    return nexus_arena_alloc_aligned((nexus_arena*)ctx, size, align);
+}
+
+void nexus_arena_allocator(nexus_arena *arena, NexusAllocator *out)
+{
+    out->allocate           = nexus__arena_vt_alloc;
+    out->deallocate         = nexus__arena_vt_free;
+    out->reallocate         = nexus__arena_vt_realloc;
+    out->allocate_aligned   = nexus__arena_vt_alloc_aligned;
+    out->deallocate_aligned = nexus__arena_vt_free;
+    out->ctx                = arena;
+}
@@ -0,0 +1,245 @@
+/* nexus_atomic.h — internal atomics, TLS and spinlock shims (C89-compatible) */
+#ifndef NEXUS_ATOMIC_H
+#define NEXUS_ATOMIC_H
+
+#include <nexus/nexus.h>
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#  include <intrin.h>
+#else
+#  include <sched.h>
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Compiler shims                                                      */
+/* ------------------------------------------------------------------ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#  define NEXUS_INLINE       __inline
+#  define NEXUS_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#  define NEXUS_INLINE       __inline__
+#  define NEXUS_THREAD_LOCAL __thread
+#else
+#  error "nexus: no thread-local storage support for this compiler"
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Atomics (acquire/release unless noted)                              */
+/* ------------------------------------------------------------------ */
+#if defined(_MSC_VER) && !defined(__clang__)
+
+static NEXUS_INLINE void *nexus__atomic_load_ptr(void *volatile *p)
+{
+    void *v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+static NEXUS_INLINE void nexus__atomic_store_ptr(void *volatile *p, void *v)
+{
+    _ReadWriteBarrier();
+    *p = v;
+}
+static NEXUS_INLINE void *nexus__atomic_xchg_ptr(void *volatile *p, void *v)
+{
+    return _InterlockedExchangePointer(p, v);
+}
+/* Returns nonzero if *p was expected and is now desired. */
+static NEXUS_INLINE int nexus__atomic_cas_ptr(void *volatile *p, void *expected, void *desired)
+{
+    return _InterlockedCompareExchangePointer(p, desired, expected) == expected;
+}
+static NEXUS_INLINE nexus_u32 nexus__atomic_load_u32(volatile nexus_u32 *p)
+{
+    nexus_u32 v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+static NEXUS_INLINE void nexus__atomic_store_u32(volatile nexus_u32 *p, nexus_u32 v)
+{
+    _ReadWriteBarrier();
+    *p = v;
+}
+static NEXUS_INLINE nexus_u32 nexus__atomic_xchg_u32(volatile nexus_u32 *p, nexus_u32 v)
+{
+    return (nexus_u32)_InterlockedExchange((volatile long*)p, (long)v);
+}
+/* Returns the previous value. */
+static NEXUS_INLINE nexus_u32 nexus__atomic_add_u32(volatile nexus_u32 *p, nexus_u32 v)
+{
+    return (nexus_u32)_InterlockedExchangeAdd((volatile long*)p, (long)v);
+}
+static NEXUS_INLINE int nexus__atomic_cas_u32(volatile nexus_u32 *p, nexus_u32 expected, nexus_u32 desired)
+{
+    return (nexus_u32)_InterlockedCompareExchange((volatile long*)p, (long)desired,
+                                                  (long)expected) == expected;
+}
+static NEXUS_INLINE int nexus__atomic_cas_size(volatile size_t *p, size_t expected, size_t desired)
+{
+#  if defined(_WIN64)
+    return (size_t)_InterlockedCompareExchange64((volatile __int64*)p, (__int64)desired,
+                                                 (__int64)expected) == expected;
+#  else
+    return (size_t)_InterlockedCompareExchange((volatile long*)p, (long)desired,
+                                               (long)expected) == expected;
+#  endif
+}
+static NEXUS_INLINE size_t nexus__atomic_load_size(volatile size_t *p)
+{
+    size_t v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+static NEXUS_INLINE void nexus__atomic_store_size(volatile size_t *p, size_t v)
+{
+    _ReadWriteBarrier();
+    *p = v;
+}
+/* Returns the previous value. */
+static NEXUS_INLINE size_t nexus__atomic_add_size(volatile size_t *p, size_t v)
+{
+#  if defined(_WIN64)
+    return (size_t)_InterlockedExchangeAdd64((volatile __int64*)p, (__int64)v);
+#  else
+    return (size_t)_InterlockedExchangeAdd((volatile long*)p, (long)v);
+#  endif
+}
+/* Sequentially consistent: orders earlier stores before later loads. */
+static NEXUS_INLINE void nexus__atomic_fence(void)
+{
+    MemoryBarrier();
+}
+static NEXUS_INLINE void nexus__cpu_relax(void)
+{
+#  if defined(_M_IX86) || defined(_M_X64)
+    _mm_pause();
+#  else
+    YieldProcessor();
+#  endif
+}
+
+#else /* GCC / Clang builtins */
+
+static NEXUS_INLINE void *nexus__atomic_load_ptr(void *volatile *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static NEXUS_INLINE void nexus__atomic_store_ptr(void *volatile *p, void *v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+static NEXUS_INLINE void *nexus__atomic_xchg_ptr(void *volatile *p, void *v)
+{
+    return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+/* Returns nonzero if *p was expected and is now desired. */
+static NEXUS_INLINE int nexus__atomic_cas_ptr(void *volatile *p, void *expected, void *desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static NEXUS_INLINE nexus_u32 nexus__atomic_load_u32(volatile nexus_u32 *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static NEXUS_INLINE void nexus__atomic_store_u32(volatile nexus_u32 *p, nexus_u32 v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+static NEXUS_INLINE nexus_u32 nexus__atomic_xchg_u32(volatile nexus_u32 *p, nexus_u32 v)
+{
+    return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+/* Returns the previous value. */
+static NEXUS_INLINE nexus_u32 nexus__atomic_add_u32(volatile nexus_u32 *p, nexus_u32 v)
+{
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+static NEXUS_INLINE int nexus__atomic_cas_u32(volatile nexus_u32 *p, nexus_u32 expected, nexus_u32 desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static NEXUS_INLINE int nexus__atomic_cas_size(volatile size_t *p, size_t expected, size_t desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static NEXUS_INLINE size_t nexus__atomic_load_size(volatile size_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static NEXUS_INLINE void nexus__atomic_store_size(volatile size_t *p, size_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+/* Returns the previous value. */
+static NEXUS_INLINE size_t nexus__atomic_add_size(volatile size_t *p, size_t v)
+{
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+#if defined(__SANITIZE_THREAD__)
+#  define NEXUS_TSAN 1
+#elif defined(__has_feature)
+#  if __has_feature(thread_sanitizer)
+#    define NEXUS_TSAN 1
+#  endif
+#endif
+
+/* Sequentially consistent: orders earlier stores before later loads.
+   ThreadSanitizer does not model standalone fences, so under it every
+   fence is an RMW on one shared word instead (still a full barrier). */
+static NEXUS_INLINE void nexus__atomic_fence(void)
+{
+#  if defined(NEXUS_TSAN)
+    static volatile nexus_u32 fence_word = 0u;
+    __atomic_fetch_add(&fence_word, 0u, __ATOMIC_SEQ_CST);
+#  else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#  endif
+}
+static NEXUS_INLINE void nexus__cpu_relax(void)
+{
+#  if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#  elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#  endif
+}
+
+#endif
+
+static NEXUS_INLINE void nexus__thread_yield(void)
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/* Spinlock: test-and-test-and-set, yields after a short spin          */
+/* ------------------------------------------------------------------ */
+typedef volatile nexus_u32 NexusSpinLock;
+
+static NEXUS_INLINE void nexus__spin_lock(NexusSpinLock *l)
+{
+    unsigned spins = 0;
+    while (nexus__atomic_xchg_u32(l, 1u) != 0u) {
+        while (nexus__atomic_load_u32(l) != 0u) {
+            if (++spins < 64u) nexus__cpu_relax();
+            else { nexus__thread_yield(); spins = 0; }
+        }
+    }
+}
+
+static NEXUS_INLINE void nexus__spin_unlock(NexusSpinLock *l)
+{
+    nexus__atomic_store_u32(l, 0u);
+}
+
+#endif /* NEXUS_ATOMIC_H */
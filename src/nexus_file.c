@@ -0,0 +1,334 @@
+/* nexus_file.c — memory-mapped views, double-buffered reader, buffered writer */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* posix_madvise(), sysconf() under -std=c90 */
+#endif
+#if !defined(_WIN32) && !defined(_FILE_OFFSET_BITS)
+#  define _FILE_OFFSET_BITS 64    /* files over 2 GiB on 32-bit targets */
+#endif
+#if defined(_WIN32) && !defined(_WIN32_WINNT)
+#  define _WIN32_WINNT 0x0602     /* PrefetchVirtualMemory (Windows 8) */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <nexus/nexus_file.h>
+#include <nexus/nexus_sync.h>
+#include "nexus_atomic.h"
+
+#if !defined(_WIN32)
+#  include <pthread.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+#define NEXUS_FILE_CHUNK   (1024u * 1024u)   /* default reader chunk */
+#define NEXUS_FILE_BUFFER  (64u * 1024u)     /* default writer buffer */
+
+/* ------------------------------------------------------------------ */
+/* Mapped views                                                        */
+/* ------------------------------------------------------------------ */
+
+#if !defined(_WIN32)
+static int nexus__file_posix_advice(nexus_file_advice advice)
+{
+    switch (advice) {
+    case NEXUS_FILE_ADVICE_SEQUENTIAL: return POSIX_MADV_SEQUENTIAL;
+    case NEXUS_FILE_ADVICE_RANDOM:     return POSIX_MADV_RANDOM;
+    case NEXUS_FILE_ADVICE_WILLNEED:   return POSIX_MADV_WILLNEED;
+    case NEXUS_FILE_ADVICE_DONTNEED:   return POSIX_MADV_DONTNEED;
+    default:                           return POSIX_MADV_NORMAL;
+    }
+}
+#endif
+
+NEXUS_BOOL nexus_file_map_open(nexus_file_map *m, const char *path, nexus_file_advice advice)
+{
+#if defined(_WIN32)
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+
+    m->data = NULL;
+    m->size = 0u;
+    if (advice == NEXUS_FILE_ADVICE_SEQUENTIAL) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    if (advice == NEXUS_FILE_ADVICE_RANDOM)     flags |= FILE_FLAG_RANDOM_ACCESS;
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NEXUS_FALSE;
+    if (!GetFileSizeEx(file, &size) || (nexus_u64)size.QuadPart > (size_t)-1) {
+        CloseHandle(file);
+        return NEXUS_FALSE;
+    }
+    if (size.QuadPart == 0) {       /* cannot map an empty file */
+        CloseHandle(file);
+        return NEXUS_TRUE;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return NEXUS_FALSE;
+    m->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);           /* the view keeps the mapping alive */
+    if (!m->data) return NEXUS_FALSE;
+    m->size = (size_t)size.QuadPart;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+
+    m->data = NULL;
+    m->size = 0u;
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return NEXUS_FALSE;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (nexus_u64)st.st_size > (size_t)-1) {
+        close(fd);
+        return NEXUS_FALSE;
+    }
+    if (st.st_size == 0) {          /* cannot map an empty file */
+        close(fd);
+        return NEXUS_TRUE;
+    }
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                      /* the mapping keeps the file open */
+    if (p == MAP_FAILED) return NEXUS_FALSE;
+    m->data = p;
+    m->size = (size_t)st.st_size;
+#endif
+    if (advice != NEXUS_FILE_ADVICE_NORMAL) nexus_file_map_advise(m, 0u, m->size, advice);
+    return NEXUS_TRUE;
+}
+
+void nexus_file_map_advise(const nexus_file_map *m, size_t offset, size_t size, nexus_file_advice advice)
+{
+    size_t page, begin, end;
+
+    if (!m->data || offset >= m->size) return;
+    if (size > m->size - offset) size = m->size - offset;
+#if defined(_WIN32)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page = (size_t)info.dwPageSize;
+    }
+#else
+    page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    begin = (size_t)m->data + offset;
+    end   = begin + size;
+    begin &= ~(page - 1u);          /* the view itself starts on a page */
+#if defined(_WIN32)
+    if (advice == NEXUS_FILE_ADVICE_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = (PVOID)begin;
+        range.NumberOfBytes  = end - begin;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    posix_madvise((void*)begin, end - begin, nexus__file_posix_advice(advice));
+#endif
+}
+
+void nexus_file_map_close(nexus_file_map *m)
+{
+    if (m->data) {
+#if defined(_WIN32)
+        UnmapViewOfFile((LPCVOID)m->data);
+#else
+        munmap((void*)m->data, m->size);
+#endif
+    }
+    m->data = NULL;
+    m->size = 0u;
+}
+
+/* ------------------------------------------------------------------ */
+/* Streaming reader                                                    */
+/* ------------------------------------------------------------------ */
+
+/* Chunk i lives in buf[i & 1]. The thread may fill chunk i once the
+   caller has released chunk i - 2; the caller may take chunk i once the
+   thread has filled it. A short chunk (possibly empty) ends the stream. */
+struct nexus_file_reader {
+    FILE              *f;
+    void              *buf[2];
+    size_t             len[2];
+    size_t             chunk;
+    nexus_atomic_u32   filled;      /* chunks produced */
+    nexus_atomic_u32   released;    /* chunks the caller is done with */
+    nexus_atomic_u32   stop;
+    nexus_atomic_u32   failed;
+    nexus_u32          taken;       /* caller only: chunks handed out */
+    NEXUS_BOOL         done;        /* caller only: the short chunk was handed out */
+#if defined(_WIN32)
+    HANDLE             thread;
+#else
+    pthread_t          thread;
+#endif
+};
+
+static void nexus__file_reader_loop(nexus_file_reader *r)
+{
+    nexus_u32 i, rel;
+    size_t n;
+
+    for (i = 0u;; ++i) {
+        while ((rel = nexus_atomic_load_u32(&r->released)) + 2u == i && !nexus_atomic_load_u32(&r->stop))
+            nexus_futex_wait(&r->released, rel);
+        if (nexus_atomic_load_u32(&r->stop)) return;
+
+        n = fread(r->buf[i & 1u], 1u, r->chunk, r->f);
+        if (n < r->chunk && ferror(r->f)) nexus_atomic_store_u32(&r->failed, 1u);
+        r->len[i & 1u] = n;
+        nexus_atomic_add_u32(&r->filled, 1u);
+        nexus_futex_wake(&r->filled, NEXUS_FALSE);
+        if (n < r->chunk) return;
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI nexus__file_reader_main(LPVOID arg) { nexus__file_reader_loop((nexus_file_reader*)arg); return 0; }
+#else
+static void *nexus__file_reader_main(void *arg) { nexus__file_reader_loop((nexus_file_reader*)arg); return NULL; }
+#endif
+
+nexus_file_reader *nexus_file_reader_open(const char *path, size_t chunk_size, const char *file, unsigned line)
+{
+    nexus_file_reader *r;
+
+    if (!chunk_size) chunk_size = NEXUS_FILE_CHUNK;
+    r = (nexus_file_reader*)NEXUS_ALLOC_AT(sizeof *r, file, line);
+    if (!r) return NULL;
+    memset(r, 0, sizeof *r);
+    r->chunk  = chunk_size;
+    r->buf[0] = NEXUS_ALLOC_AT(chunk_size, file, line);
+    r->buf[1] = NEXUS_ALLOC_AT(chunk_size, file, line);
+    r->f      = fopen(path, "rb");
+    if (r->buf[0] && r->buf[1] && r->f) {
+        /* fread goes straight into our buffers; a stdio buffer would only add a copy. */
+        setvbuf(r->f, NULL, _IONBF, 0);
+#if defined(_WIN32)
+        r->thread = CreateThread(NULL, 0, nexus__file_reader_main, r, 0, NULL);
+        if (r->thread) return r;
+#else
+        if (pthread_create(&r->thread, NULL, nexus__file_reader_main, r) == 0) return r;
+#endif
+    }
+    if (r->f) fclose(r->f);
+    NEXUS_FREE(r->buf[0]);
+    NEXUS_FREE(r->buf[1]);
+    NEXUS_FREE(r);
+    return NULL;
+}
+
+const void *nexus_file_reader_next(nexus_file_reader *r, size_t *size)
+{
+    nexus_u32 k = r->taken, f;
+    size_t n;
+
+    *size = 0u;
+    if (r->done) return NULL;
+    if (k) {
+        /* Done with chunk k - 1: its buffer may take chunk k + 1. */
+        nexus_atomic_store_u32(&r->released, k);
+        nexus_futex_wake(&r->released, NEXUS_FALSE);
+    }
+    while ((f = nexus_atomic_load_u32(&r->filled)) == k)
+        nexus_futex_wait(&r->filled, f);
+    r->taken = k + 1u;
+    n = r->len[k & 1u];
+    if (n < r->chunk) r->done = NEXUS_TRUE;
+    if (!n) return NULL;
+    *size = n;
+    return r->buf[k & 1u];
+}
+
+NEXUS_BOOL nexus_file_reader_failed(const nexus_file_reader *r)
+{
+    return nexus_atomic_load_u32((nexus_atomic_u32*)&r->failed) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+void nexus_file_reader_close(nexus_file_reader *r)
+{
+    if (!r) return;
+    /* Moving `released` on makes a thread blocked on it wake and see stop. */
+    nexus_atomic_store_u32(&r->stop, 1u);
+    nexus_atomic_add_u32(&r->released, 2u);
+    nexus_futex_wake(&r->released, NEXUS_TRUE);
+#if defined(_WIN32)
+    WaitForSingleObject(r->thread, INFINITE);
+    CloseHandle(r->thread);
+#else
+    pthread_join(r->thread, NULL);
+#endif
+    fclose(r->f);
+    NEXUS_FREE(r->buf[0]);
+    NEXUS_FREE(r->buf[1]);
+    NEXUS_FREE(r);
+}
+
+/* ------------------------------------------------------------------ */
+/* Buffered writer                                                     */
+/* ------------------------------------------------------------------ */
+
+struct nexus_file_writer {
+    FILE          *f;
+    unsigned char *buf;
+    size_t         used;
+    size_t         capacity;
+    NEXUS_BOOL     failed;
+};
+
+nexus_file_writer *nexus_file_writer_open(const char *path, size_t buffer_size, const char *file, unsigned line)
+{
+    nexus_file_writer *w;
+
+    if (!buffer_size) buffer_size = NEXUS_FILE_BUFFER;
+    w = (nexus_file_writer*)NEXUS_ALLOC_AT(sizeof *w, file, line);
+    if (!w) return NULL;
+    memset(w, 0, sizeof *w);
+    w->capacity = buffer_size;
+    w->buf      = (unsigned char*)NEXUS_ALLOC_AT(buffer_size, file, line);
+    w->f        = w->buf ? fopen(path, "wb") : NULL;
+    if (!w->f) {
+        NEXUS_FREE(w->buf);
+        NEXUS_FREE(w);
+        return NULL;
+    }
+    setvbuf(w->f, NULL, _IONBF, 0);
+    return w;
+}
+
+NEXUS_BOOL nexus_file_writer_flush(nexus_file_writer *w)
+{
+    if (w->used && !w->failed && fwrite(w->buf, 1u, w->used, w->f) != w->used) w->failed = NEXUS_TRUE;
+    w->used = 0u;
+    return w->failed ? NEXUS_FALSE : NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_file_writer_write(nexus_file_writer *w, const void *data, size_t size)
+{
+    if (w->failed) return NEXUS_FALSE;
+    if (size > w->capacity - w->used) {
+        if (!nexus_file_writer_flush(w)) return NEXUS_FALSE;
+        if (size >= w->capacity) {
+            if (fwrite(data, 1u, size, w->f) != size) w->failed = NEXUS_TRUE;
+            return w->failed ? NEXUS_FALSE : NEXUS_TRUE;
+        }
+    }
+    memcpy(w->buf + w->used, data, size);
+    w->used += size;
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_file_writer_close(nexus_file_writer *w)
+{
+    NEXUS_BOOL ok;
+
+    if (!w) return NEXUS_FALSE;
+    ok = nexus_file_writer_flush(w);
+    if (fclose(w->f) != 0) ok = NEXUS_FALSE;
+    NEXUS_FREE(w->buf);
+    NEXUS_FREE(w);
+    return ok;
+}
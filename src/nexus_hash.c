@@ -0,0 +1,461 @@
+/* nexus_hash.c — striped 64-bit hashing and the process-wide string interner */
+
+#include <stdlib.h>
+#include <string.h>
+#include "nexus/nexus_hash.h"
+#include "nexus_atomic.h"
+#include "nexus_hash_impl.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define NEXUS_HASH_SSE2 1
+#endif
+
+/* Interned copies are bookkeeping: keep them out of the tracked heap. */
+#ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
+#  undef malloc
+#  undef realloc
+#  undef free
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Constants                                                           */
+/* ------------------------------------------------------------------ */
+#define NEXUS_HASH_U64(hi, lo) (((nexus_u64)(hi) << 32) | (nexus_u64)(lo))
+
+#define NEXUS_HASH_P1  NEXUS_HASH_U64(0x9E3779B1u, 0x85EBCA87u)
+#define NEXUS_HASH_P2  NEXUS_HASH_U64(0xC2B2AE3Du, 0x27D4EB4Fu)
+#define NEXUS_HASH_P3  NEXUS_HASH_U64(0x165667B1u, 0x9E3779F9u)
+#define NEXUS_HASH_P4  NEXUS_HASH_U64(0x85EBCA77u, 0xC2B2AE63u)
+#define NEXUS_HASH_P5  NEXUS_HASH_U64(0x27D4EB2Fu, 0x165667C5u)
+#define NEXUS_HASH_P32 0x9E3779B1u
+
+#define NEXUS_HASH_STRIPE 32u     /* bytes per step of the long path: 4 lanes of 8 */
+#define NEXUS_HASH_BLOCK  32u     /* stripes between scrambles (1 KiB) */
+#define NEXUS_HASH_SHORT  128u    /* longest input taking the two-lane path */
+
+/* Stripe s of a block XORs lane l with key[(s & 7) + l]; scrambles use
+   key[8..11], the final merge key[4..7]. */
+static const nexus_u64 g_hash_key[12] = {
+    NEXUS_HASH_U64(0xBE4BA423u, 0x396CFEB8u), NEXUS_HASH_U64(0x1CAD21F7u, 0x2C81017Cu),
+    NEXUS_HASH_U64(0xDB979083u, 0xE96DD4DEu), NEXUS_HASH_U64(0x1F67B3B7u, 0xA4A44072u),
+    NEXUS_HASH_U64(0x78E5C0CCu, 0x4EE679CBu), NEXUS_HASH_U64(0x2172FFCCu, 0x7DD05A82u),
+    NEXUS_HASH_U64(0x8E2443F7u, 0x744608B8u), NEXUS_HASH_U64(0x4C263A81u, 0xE69035E0u),
+    NEXUS_HASH_U64(0xCB00C391u, 0xBB52283Cu), NEXUS_HASH_U64(0xA32E531Bu, 0x8B65D088u),
+    NEXUS_HASH_U64(0x4EF90DA2u, 0x97486471u), NEXUS_HASH_U64(0xD8ACDEA9u, 0x46EF1938u)
+};
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Native-order unaligned loads; memcpy compiles to a single move. */
+static NEXUS_INLINE nexus_u64 nexus__hash_read64(const nexus_u8 *p)
+{
+    nexus_u64 v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static NEXUS_INLINE nexus_u64 nexus__hash_read32(const nexus_u8 *p)
+{
+    nexus_u32 v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static NEXUS_INLINE nexus_u64 nexus__hash_rotl(nexus_u64 v, unsigned r)
+{
+    return (v << r) | (v >> (64u - r));
+}
+
+static NEXUS_INLINE nexus_u64 nexus__hash_round(nexus_u64 acc, nexus_u64 v)
+{
+    acc += v * NEXUS_HASH_P2;
+    return nexus__hash_rotl(acc, 31u) * NEXUS_HASH_P1;
+}
+
+static nexus_u64 nexus__hash_final(nexus_u64 h)
+{
+    h ^= h >> 33; h *= NEXUS_HASH_P2;
+    h ^= h >> 29; h *= NEXUS_HASH_P3;
+    return h ^ (h >> 32);
+}
+
+/* Up to 128 bytes: two dependency chains over 16-byte chunks, the last
+   chunk overlapping its predecessor rather than looping over a tail. */
+static nexus_u64 nexus__hash_short(const nexus_u8 *p, size_t size, nexus_u64 seed)
+{
+    nexus_u64 a = seed + g_hash_key[0], b = seed ^ g_hash_key[1];
+    size_t i;
+
+    if (size > 16u) {
+        for (i = 0; i + 16u < size; i += 16u) {
+            a = nexus__hash_round(a, nexus__hash_read64(p + i));
+            b = nexus__hash_round(b, nexus__hash_read64(p + i + 8u));
+        }
+        a = nexus__hash_round(a, nexus__hash_read64(p + size - 16u));
+        b = nexus__hash_round(b, nexus__hash_read64(p + size - 8u));
+    } else if (size >= 8u) {
+        a = nexus__hash_round(a, nexus__hash_read64(p));
+        b = nexus__hash_round(b, nexus__hash_read64(p + size - 8u));
+    } else if (size >= 4u) {
+        a = nexus__hash_round(a, nexus__hash_read32(p));
+        b = nexus__hash_round(b, nexus__hash_read32(p + size - 4u));
+    } else if (size) {
+        a = nexus__hash_round(a, ((nexus_u64)p[0] << 16) | ((nexus_u64)p[size >> 1] << 8) | p[size - 1u]);
+    }
+    return nexus__hash_final(nexus__hash_rotl(a, 1u) + nexus__hash_rotl(b, 12u)
+                             + (nexus_u64)size * NEXUS_HASH_P5);
+}
+
+/* Four lanes per stripe: lane l adds lo32 * hi32 of (data ^ key) to itself
+   and its raw data to its neighbour, so no step waits on a 64-bit
+   multiply chain and no input bit is lost to a zero product. */
+static void nexus__hash_accumulate(nexus_u64 *acc, const nexus_u8 *p, size_t stripes, unsigned key)
+{
+#if defined(NEXUS_HASH_SSE2)
+    __m128i a0 = _mm_loadu_si128((const __m128i*)acc);
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(acc + 2));
+
+    for (; stripes; --stripes, p += NEXUS_HASH_STRIPE, key = (key + 1u) & 7u) {
+        __m128i d0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i d1 = _mm_loadu_si128((const __m128i*)(p + 16));
+        __m128i x0 = _mm_xor_si128(d0, _mm_loadu_si128((const __m128i*)(g_hash_key + key)));
+        __m128i x1 = _mm_xor_si128(d1, _mm_loadu_si128((const __m128i*)(g_hash_key + key + 2u)));
+
+        a0 = _mm_add_epi64(a0, _mm_mul_epu32(x0, _mm_shuffle_epi32(x0, _MM_SHUFFLE(3, 3, 1, 1))));
+        a1 = _mm_add_epi64(a1, _mm_mul_epu32(x1, _mm_shuffle_epi32(x1, _MM_SHUFFLE(3, 3, 1, 1))));
+        a0 = _mm_add_epi64(a0, _mm_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2)));
+        a1 = _mm_add_epi64(a1, _mm_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+    _mm_storeu_si128((__m128i*)acc, a0);
+    _mm_storeu_si128((__m128i*)(acc + 2), a1);
+#else
+    unsigned l;
+
+    for (; stripes; --stripes, p += NEXUS_HASH_STRIPE, key = (key + 1u) & 7u) {
+        for (l = 0; l < 4u; ++l) {
+            nexus_u64 d = nexus__hash_read64(p + 8u * l);
+            nexus_u64 x = d ^ g_hash_key[key + l];
+            acc[l ^ 1u] += d;
+            acc[l]      += (x & 0xFFFFFFFFu) * (x >> 32);
+        }
+    }
+#endif
+}
+
+/* Fold high bits back down between blocks so the lanes stay well mixed. */
+static void nexus__hash_scramble(nexus_u64 *acc)
+{
+#if defined(NEXUS_HASH_SSE2)
+    const __m128i k32 = _mm_set1_epi32((int)NEXUS_HASH_P32);
+    unsigned l;
+
+    for (l = 0; l < 4u; l += 2u) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + l));
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)(g_hash_key + 8u + l)));
+        /* 64 x 32-bit multiply from two 32 x 32 -> 64 products */
+        a = _mm_add_epi64(_mm_mul_epu32(a, k32),
+                          _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), k32), 32));
+        _mm_storeu_si128((__m128i*)(acc + l), a);
+    }
+#else
+    unsigned l;
+
+    for (l = 0; l < 4u; ++l) {
+        nexus_u64 a = acc[l];
+        a ^= a >> 47;
+        a ^= g_hash_key[8u + l];
+        acc[l] = a * NEXUS_HASH_P32;
+    }
+#endif
+}
+
+static nexus_u64 nexus__hash_long(const nexus_u8 *p, size_t size, nexus_u64 seed)
+{
+    const nexus_u8 *end = p + size;
+    nexus_u64 acc[4], h;
+    size_t stripes = (size - 1u) / NEXUS_HASH_STRIPE;   /* leaves 1..32 bytes for the last stripe */
+    unsigned l;
+
+    acc[0] = seed + NEXUS_HASH_P1;
+    acc[1] = seed ^ NEXUS_HASH_P2;
+    acc[2] = seed - NEXUS_HASH_P3;
+    acc[3] = seed ^ NEXUS_HASH_P4;
+
+    for (; stripes >= NEXUS_HASH_BLOCK; stripes -= NEXUS_HASH_BLOCK) {
+        nexus__hash_accumulate(acc, p, NEXUS_HASH_BLOCK, 0u);
+        nexus__hash_scramble(acc);
+        p += NEXUS_HASH_BLOCK * NEXUS_HASH_STRIPE;
+    }
+    nexus__hash_accumulate(acc, p, stripes, 0u);
+    /* The final stripe ends at the last byte, overlapping the one before. */
+    nexus__hash_accumulate(acc, end - NEXUS_HASH_STRIPE, 1u, 5u);
+
+    h = seed + (nexus_u64)size * NEXUS_HASH_P1;
+    for (l = 0; l < 4u; ++l) h = nexus__hash_round(h, acc[l] ^ g_hash_key[4u + l]);
+    return nexus__hash_final(h);
+}
+
+/* ------------------------------------------------------------------ */
+/* Hashing                                                             */
+/* ------------------------------------------------------------------ */
+
+nexus_u64 nexus_hash_bytes(const void *data, size_t size, nexus_u64 seed)
+{
+    const nexus_u8 *p = (const nexus_u8*)data;
+    return size <= NEXUS_HASH_SHORT ? nexus__hash_short(p, size, seed)
+                                    : nexus__hash_long(p, size, seed);
+}
+
+nexus_u64 nexus_hash_str(const char *str, nexus_u64 seed)
+{
+    return nexus_hash_bytes(str, strlen(str), seed);
+}
+
+nexus_u64 nexus_hash_u64(nexus_u64 value)
+{
+    /* splitmix64; the offset keeps 0 from mapping to 0 */
+    value += NEXUS_HASH_U64(0x9E3779B9u, 0x7F4A7C15u);
+    value ^= value >> 30; value *= NEXUS_HASH_U64(0xBF58476Du, 0x1CE4E5B9u);
+    value ^= value >> 27; value *= NEXUS_HASH_U64(0x94D049BBu, 0x133111EBu);
+    return value ^ (value >> 31);
+}
+
+nexus_u32 nexus_hash_u32(nexus_u32 value)
+{
+    /* lowbias32 */
+    value += 0x9E3779B9u;
+    value ^= value >> 16; value *= 0x7FEB352Du;
+    value ^= value >> 15; value *= 0x846CA68Bu;
+    return value ^ (value >> 16);
+}
+
+nexus_u64 nexus_hash_combine(nexus_u64 hash, nexus_u64 value)
+{
+    return nexus__hash_final(nexus__hash_round(hash, value));
+}
+
+/* ------------------------------------------------------------------ */
+/* Interner                                                            */
+/* ------------------------------------------------------------------ */
+#define NEXUS_INTERN_SHARDS 16u             /* picked by the top hash bits */
+#define NEXUS_INTERN_PAGE   1024u           /* IDs per page; pages never move */
+#define NEXUS_INTERN_PAGES  16384u
+#define NEXUS_INTERN_ARENA  (64u * 1024u)   /* bytes per block of copies */
+
+/* A copy is stored as [u32 length][bytes][NUL]; IDs resolve to the bytes. */
+typedef struct {
+    nexus_u32    hash;      /* low bits of the full hash */
+    nexus_str_id id;        /* 0 marks an empty slot */
+} NexusInternSlot;
+
+typedef struct {
+    NexusSpinLock    lock;
+    NexusInternSlot *slots;   /* open addressing, power of two */
+    unsigned         cap;
+    unsigned         len;
+    char            *arena;   /* current block; earlier ones are never freed */
+    size_t           arena_left;
+} NexusInternShard;
+
+static NexusInternShard  g_intern_shards[NEXUS_INTERN_SHARDS];
+static void *volatile    g_intern_pages[NEXUS_INTERN_PAGES];   /* each NEXUS_INTERN_PAGE char* */
+static volatile nexus_u32 g_intern_next  = 0u;                  /* last ID handed out */
+static volatile nexus_u32 g_intern_count = 0u;
+
+static nexus_u32 nexus__intern_len_of(const char *s)
+{
+    nexus_u32 len;
+    memcpy(&len, s - sizeof len, sizeof len);
+    return len;
+}
+
+/* Caller holds sh->lock. */
+static NEXUS_BOOL nexus__intern_grow(NexusInternShard *sh)
+{
+    unsigned cap = sh->cap ? sh->cap * 2u : 64u, mask = cap - 1u, k, i;
+    NexusInternSlot *slots = (NexusInternSlot*)calloc(cap, sizeof *slots);
+
+    if (!slots) return NEXUS_FALSE;
+    for (k = 0; k < sh->cap; ++k) {
+        if (!sh->slots[k].id) continue;
+        for (i = sh->slots[k].hash & mask; slots[i].id; i = (i + 1u) & mask) {
+            /* probe */
+        }
+        slots[i] = sh->slots[k];
+    }
+    free(sh->slots);
+    sh->slots = slots;
+    sh->cap   = cap;
+    return NEXUS_TRUE;
+}
+
+/* Caller holds sh->lock. Length-prefixed, NUL-terminated copy of str. */
+static char *nexus__intern_copy(NexusInternShard *sh, const char *str, size_t len)
+{
+    size_t need = (sizeof(nexus_u32) + len + 1u + 3u) & ~(size_t)3u;   /* keeps prefixes aligned */
+    nexus_u32 len32 = (nexus_u32)len;
+    char *out;
+
+    if (need > NEXUS_INTERN_ARENA / 4u) {
+        out = (char*)malloc(need);   /* big strings get their own block */
+    } else {
+        if (need > sh->arena_left) {
+            sh->arena = (char*)malloc(NEXUS_INTERN_ARENA);
+            sh->arena_left = sh->arena ? NEXUS_INTERN_ARENA : 0u;
+        }
+        out = sh->arena;
+        if (out) {
+            sh->arena      += need;
+            sh->arena_left -= need;
+        }
+    }
+    if (!out) return NULL;
+    memcpy(out, &len32, sizeof len32);
+    out += sizeof len32;
+    memcpy(out, str, len);
+    out[len] = '\0';
+    return out;
+}
+
+/* Caller holds sh->lock. Slot holding str, or the empty slot ending its probe. */
+static NexusInternSlot *nexus__intern_probe(NexusInternShard *sh, const char *str, size_t len,
+                                            nexus_u32 hash)
+{
+    unsigned mask = sh->cap - 1u, i;
+
+    for (i = hash & mask; sh->slots[i].id; i = (i + 1u) & mask) {
+        const char *s;
+        if (sh->slots[i].hash != hash) continue;
+        s = nexus_intern_str(sh->slots[i].id);
+        if (nexus__intern_len_of(s) == len && memcmp(s, str, len) == 0) break;
+    }
+    return &sh->slots[i];
+}
+
+static nexus_str_id nexus__intern(const char *str, size_t len, NEXUS_BOOL add)
+{
+    nexus_u64 h;
+    NexusInternShard *sh;
+    NexusInternSlot *slot;
+    nexus_str_id id;
+    char **page;
+    char *copy;
+
+    if (!str || len >= 0xFFFFFFFFu) return 0u;
+    h  = nexus_hash_bytes(str, len, 0u);
+    sh = &g_intern_shards[(unsigned)(h >> 60) % NEXUS_INTERN_SHARDS];
+
+    nexus__spin_lock(&sh->lock);
+    if (!sh->cap && (!add || !nexus__intern_grow(sh))) {
+        nexus__spin_unlock(&sh->lock);
+        return 0u;
+    }
+    slot = nexus__intern_probe(sh, str, len, (nexus_u32)h);
+    if (slot->id || !add) {
+        id = slot->id;
+        nexus__spin_unlock(&sh->lock);
+        return id;
+    }
+
+    if ((sh->len + 1u) * 2u > sh->cap) {
+        if (!nexus__intern_grow(sh)) {
+            nexus__spin_unlock(&sh->lock);
+            return 0u;
+        }
+        slot = nexus__intern_probe(sh, str, len, (nexus_u32)h);
+    }
+    /* Claim the ID first. Shards race for g_intern_next, so a plain add
+       after a separate check could step past the last page; the CAS only
+       moves it while it is still below the limit. */
+    do {
+        id = nexus__atomic_load_u32(&g_intern_next);
+        if (id >= NEXUS_INTERN_PAGE * NEXUS_INTERN_PAGES - 1u) {
+            nexus__spin_unlock(&sh->lock);
+            return 0u;
+        }
+    } while (!nexus__atomic_cas_u32(&g_intern_next, id, id + 1u));
+    id += 1u;
+    copy = nexus__intern_copy(sh, str, len);
+    if (!copy) {
+        nexus__spin_unlock(&sh->lock);
+        return 0u;   /* the ID stays unused */
+    }
+
+    /* IDs are global, so pages are shared between shards: the first shard
+       to need one installs it. A lost race just frees its candidate. */
+    page = (char**)nexus__atomic_load_ptr(&g_intern_pages[id / NEXUS_INTERN_PAGE]);
+    if (!page) {
+        page = (char**)calloc(NEXUS_INTERN_PAGE, sizeof *page);
+        if (!page) {
+            nexus__spin_unlock(&sh->lock);
+            return 0u;   /* the copy and the ID stay unused */
+        }
+        if (!nexus__atomic_cas_ptr(&g_intern_pages[id / NEXUS_INTERN_PAGE], NULL, page)) {
+            free(page);
+            page = (char**)nexus__atomic_load_ptr(&g_intern_pages[id / NEXUS_INTERN_PAGE]);
+        }
+    }
+    nexus__atomic_store_ptr((void *volatile*)&page[id % NEXUS_INTERN_PAGE], copy);
+    slot->hash = (nexus_u32)h;
+    slot->id   = id;
+    sh->len   += 1u;
+    nexus__atomic_add_u32(&g_intern_count, 1u);
+    nexus__spin_unlock(&sh->lock);
+    return id;
+}
+
+nexus_str_id nexus_intern(const char *str)
+{
+    return str ? nexus__intern(str, strlen(str), NEXUS_TRUE) : 0u;
+}
+
+nexus_str_id nexus_intern_n(const char *str, size_t len)
+{
+    return nexus__intern(str, len, NEXUS_TRUE);
+}
+
+nexus_str_id nexus_intern_find(const char *str, size_t len)
+{
+    return nexus__intern(str, len, NEXUS_FALSE);
+}
+
+const char *nexus_intern_str(nexus_str_id id)
+{
+    char **page;
+
+    if (!id || id / NEXUS_INTERN_PAGE >= NEXUS_INTERN_PAGES) return NULL;
+    page = (char**)nexus__atomic_load_ptr(&g_intern_pages[id / NEXUS_INTERN_PAGE]);
+    return page ? (const char*)nexus__atomic_load_ptr((void *volatile*)&page[id % NEXUS_INTERN_PAGE])
+                : NULL;
+}
+
+size_t nexus_intern_len(nexus_str_id id)
+{
+    const char *s = nexus_intern_str(id);
+    return s ? nexus__intern_len_of(s) : 0u;
+}
+
+size_t nexus_intern_count(void)
+{
+    return nexus__atomic_load_u32(&g_intern_count);
+}
+
+/* ------------------------------------------------------------------ */
+/* Internal API (nexus_hash_impl.h)                                    */
+/* ------------------------------------------------------------------ */
+
+void nexus__intern_lock(void)
+{
+    unsigned n;
+    for (n = 0; n < NEXUS_INTERN_SHARDS; ++n) nexus__spin_lock(&g_intern_shards[n].lock);
+}
+
+void nexus__intern_unlock(void)
+{
+    unsigned n;
+    for (n = NEXUS_INTERN_SHARDS; n-- > 0;) nexus__spin_unlock(&g_intern_shards[n].lock);
+}
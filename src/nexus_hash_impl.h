@@ -0,0 +1,12 @@
+/* nexus_hash_impl.h — internal interner hooks for the debug allocator */
+#ifndef NEXUS_HASH_IMPL_H
+#define NEXUS_HASH_IMPL_H
+
+#include <nexus/nexus.h>
+
+/* Hold every interner shard lock, e.g. across fork(). The interner takes
+   no other lock while holding one of its own. */
+void nexus__intern_lock(void);
+void nexus__intern_unlock(void);
+
+#endif /* NEXUS_HASH_IMPL_H */
@@ -0,0 +1,379 @@
+/* nexus_hashmap.c — open-addressing hash map with grouped metadata probing */
+
+#include <string.h>
+#include "nexus/nexus_hashmap.h"
+#include "nexus/nexus_hash.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define NEXUS_HASHMAP_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Metadata bytes                                                      */
+/* ------------------------------------------------------------------ */
+/* A full slot's byte is the low 7 bits of its hash (high bit clear);
+   empty and deleted slots have the high bit set, and only deleted has
+   bit 1 set. */
+#define NEXUS_HASHMAP_EMPTY   0x80u
+#define NEXUS_HASHMAP_DELETED 0xFEu
+
+/* Matches within a group come back as a bitmask with NEXUS_HASHMAP_SHIFT
+   bits per byte; iterate with nexus__hashmap_lowest and m &= m - 1. */
+#if defined(NEXUS_HASHMAP_SSE2)
+#  define NEXUS_HASHMAP_GROUP 16u
+#  define NEXUS_HASHMAP_SHIFT 0
+typedef unsigned NexusHashMask;
+typedef __m128i  NexusHashGroup;
+
+static NexusHashGroup nexus__hashmap_load(const nexus_u8 *ctrl)
+{
+    return _mm_loadu_si128((const __m128i*)ctrl);
+}
+
+static NexusHashMask nexus__hashmap_match(NexusHashGroup g, unsigned h2)
+{
+    return (NexusHashMask)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)h2)));
+}
+
+static NexusHashMask nexus__hashmap_match_empty(NexusHashGroup g)
+{
+    return (NexusHashMask)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)NEXUS_HASHMAP_EMPTY)));
+}
+
+static NexusHashMask nexus__hashmap_match_free(NexusHashGroup g)
+{
+    return (NexusHashMask)_mm_movemask_epi8(g);   /* empty or deleted: high bit */
+}
+#else
+/* Portable fallback: eight bytes per 64-bit word, compared with bit
+   tricks. match() may report a false positive next to a true match;
+   callers compare keys anyway. */
+#  define NEXUS_HASHMAP_GROUP 8u
+#  define NEXUS_HASHMAP_SHIFT 3
+#  define NEXUS_HASHMAP_LSBS  (((nexus_u64)0x01010101u << 32) | 0x01010101u)
+#  define NEXUS_HASHMAP_MSBS  (((nexus_u64)0x80808080u << 32) | 0x80808080u)
+typedef nexus_u64 NexusHashMask;
+typedef nexus_u64 NexusHashGroup;
+
+/* Byte i lands in bits 8i..8i+7 regardless of endianness. */
+static NexusHashGroup nexus__hashmap_load(const nexus_u8 *ctrl)
+{
+    NexusHashGroup g = 0;
+    unsigned i;
+    for (i = 0; i < 8u; ++i) g |= (NexusHashGroup)ctrl[i] << (8u * i);
+    return g;
+}
+
+static NexusHashMask nexus__hashmap_match(NexusHashGroup g, unsigned h2)
+{
+    NexusHashGroup x = g ^ (NEXUS_HASHMAP_LSBS * h2);
+    return (x - NEXUS_HASHMAP_LSBS) & ~x & NEXUS_HASHMAP_MSBS;
+}
+
+static NexusHashMask nexus__hashmap_match_empty(NexusHashGroup g)
+{
+    return g & ~(g << 6) & NEXUS_HASHMAP_MSBS;
+}
+
+static NexusHashMask nexus__hashmap_match_free(NexusHashGroup g)
+{
+    return g & NEXUS_HASHMAP_MSBS;
+}
+#endif
+
+/* Byte index of the lowest match in a non-zero mask. */
+static unsigned nexus__hashmap_lowest(NexusHashMask m)
+{
+#if defined(NEXUS_HASHMAP_SSE2) && (defined(__GNUC__) || defined(__clang__))
+    return (unsigned)__builtin_ctz(m);
+#elif defined(NEXUS_HASHMAP_SSE2) && defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return (unsigned)i;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(m) >> NEXUS_HASHMAP_SHIFT;
+#else
+    unsigned i = 0;
+    while (!(m & 1u)) { m >>= 1; ++i; }
+    return i >> NEXUS_HASHMAP_SHIFT;
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/* Hashing                                                             */
+/* ------------------------------------------------------------------ */
+static nexus_u64 nexus__hashmap_hash(const nexus_hashmap *m, const void *key)
+{
+    /* User hashes go through a full-avalanche mixer: both the probe
+       position (high bits) and the metadata byte (low 7 bits) need to be
+       usable, and callers often return the key itself. */
+    return m->hash ? nexus_hash_u64(m->hash(key, m->key_size))
+                   : nexus_hash_bytes(key, m->key_size, 0u);
+}
+
+static NEXUS_BOOL nexus__hashmap_eq(const nexus_hashmap *m, const void *a, const void *b)
+{
+    return m->eq ? m->eq(a, b, m->key_size) : (NEXUS_BOOL)(memcmp(a, b, m->key_size) == 0);
+}
+
+/* ------------------------------------------------------------------ */
+/* Table                                                               */
+/* ------------------------------------------------------------------ */
+
+static nexus_u8 *nexus__hashmap_slot(const nexus_hashmap *m, size_t i)
+{
+    return m->slots + i * m->stride;
+}
+
+static size_t nexus__hashmap_max_load(size_t capacity)
+{
+    return capacity - capacity / 8u;
+}
+
+/* Set slot i's byte and its copy past the end, which lets a group load
+   starting near the end wrap without a second read. */
+static void nexus__hashmap_set_ctrl(nexus_hashmap *m, size_t i, unsigned c)
+{
+    m->ctrl[i] = (nexus_u8)c;
+    if (i < NEXUS_HASHMAP_GROUP - 1u) m->ctrl[m->capacity + i] = (nexus_u8)c;
+}
+
+/* Slot index holding key, or m->capacity. Probing visits groups at
+   triangular offsets, which covers the whole power-of-two table; a group
+   with an empty byte ends the chain. */
+static size_t nexus__hashmap_find(const nexus_hashmap *m, const void *key, nexus_u64 h)
+{
+    size_t mask = m->capacity - 1u, pos, step = 0u, i;
+    unsigned h2 = (unsigned)(h & 0x7Fu);
+    NexusHashGroup g;
+    NexusHashMask match;
+
+    if (!m->capacity) return 0u;
+    pos = (size_t)(h >> 7) & mask;
+    for (;;) {
+        g = nexus__hashmap_load(m->ctrl + pos);
+        for (match = nexus__hashmap_match(g, h2); match; match &= match - 1u) {
+            i = (pos + nexus__hashmap_lowest(match)) & mask;
+            if (nexus__hashmap_eq(m, nexus__hashmap_slot(m, i), key)) return i;
+        }
+        if (nexus__hashmap_match_empty(g)) return m->capacity;
+        step += NEXUS_HASHMAP_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+/* First empty or deleted slot on h's probe sequence. */
+static size_t nexus__hashmap_find_free(const nexus_hashmap *m, nexus_u64 h)
+{
+    size_t mask = m->capacity - 1u, pos = (size_t)(h >> 7) & mask, step = 0u;
+    NexusHashMask free_mask;
+
+    for (;;) {
+        free_mask = nexus__hashmap_match_free(nexus__hashmap_load(m->ctrl + pos));
+        if (free_mask) return (pos + nexus__hashmap_lowest(free_mask)) & mask;
+        step += NEXUS_HASHMAP_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+/* Move every entry into a fresh table of `capacity` slots; this also
+   clears deleted marks. */
+static NEXUS_BOOL nexus__hashmap_rehash(nexus_hashmap *m, size_t capacity)
+{
+    nexus_hashmap old = *m;
+    size_t ctrl_bytes = capacity + NEXUS_HASHMAP_GROUP - 1u, i, j;
+    nexus_u8 *block;
+
+    if (capacity > ((size_t)-1 - ctrl_bytes) / m->stride) return NEXUS_FALSE;
+    block = (nexus_u8*)nexus_allocator_alloc(m->allocator, capacity * m->stride + ctrl_bytes,
+                                             m->file, m->line);
+    if (!block) return NEXUS_FALSE;
+
+    m->slots       = block;
+    m->ctrl        = block + capacity * m->stride;
+    m->capacity    = capacity;
+    m->growth_left = nexus__hashmap_max_load(capacity) - m->count;
+    memset(m->ctrl, NEXUS_HASHMAP_EMPTY, ctrl_bytes);
+
+    for (i = 0; i < old.capacity; ++i) {
+        if (old.ctrl[i] & 0x80u) continue;
+        {
+            const nexus_u8 *src = nexus__hashmap_slot(&old, i);
+            nexus_u64 h = nexus__hashmap_hash(m, src);
+            j = nexus__hashmap_find_free(m, h);
+            nexus__hashmap_set_ctrl(m, j, (unsigned)(h & 0x7Fu));
+            memcpy(nexus__hashmap_slot(m, j), src, m->stride);
+        }
+    }
+    nexus_allocator_free(m->allocator, old.slots);
+    return NEXUS_TRUE;
+}
+
+/* Smallest table keeping `count` entries under the load limit. */
+static size_t nexus__hashmap_capacity_for(size_t count)
+{
+    size_t cap = NEXUS_HASHMAP_GROUP;
+    while (nexus__hashmap_max_load(cap) < count) {
+        if (cap > (size_t)-1 / 2u) return 0u;
+        cap *= 2u;
+    }
+    return cap;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+void nexus_hashmap_init(nexus_hashmap *m, size_t key_size, size_t value_size,
+                        nexus_hashmap_hash_fn hash, nexus_hashmap_eq_fn eq,
+                        const NexusAllocator *allocator, const char *file, unsigned line)
+{
+    /* Align the value (and the slot stride) to the largest power of two
+       dividing its size, capped at 16; that is enough for any C type. */
+    size_t align = 1u, key_align = 1u;
+
+    while (align < 16u && value_size % (align * 2u) == 0u && value_size >= align * 2u) align *= 2u;
+    while (key_align < 16u && key_size % (key_align * 2u) == 0u && key_size >= key_align * 2u) key_align *= 2u;
+
+    m->ctrl         = NULL;
+    m->slots        = NULL;
+    m->count        = 0u;
+    m->capacity     = 0u;
+    m->growth_left  = 0u;
+    m->key_size     = key_size;
+    m->value_size   = value_size;
+    m->value_offset = (key_size + align - 1u) & ~(align - 1u);
+    if (align < key_align) align = key_align;
+    m->stride       = (m->value_offset + value_size + align - 1u) & ~(align - 1u);
+    if (!m->stride) m->stride = 1u;
+    m->hash         = hash;
+    m->eq           = eq;
+    m->allocator    = allocator;
+    m->file         = file;
+    m->line         = line;
+}
+
+void nexus_hashmap_free(nexus_hashmap *m)
+{
+    nexus_allocator_free(m->allocator, m->slots);
+    m->ctrl        = NULL;
+    m->slots       = NULL;
+    m->count       = 0u;
+    m->capacity    = 0u;
+    m->growth_left = 0u;
+}
+
+void nexus_hashmap_clear(nexus_hashmap *m)
+{
+    if (!m->capacity) return;
+    memset(m->ctrl, NEXUS_HASHMAP_EMPTY, m->capacity + NEXUS_HASHMAP_GROUP - 1u);
+    m->count       = 0u;
+    m->growth_left = nexus__hashmap_max_load(m->capacity);
+}
+
+NEXUS_BOOL nexus_hashmap_reserve(nexus_hashmap *m, size_t count)
+{
+    size_t cap = nexus__hashmap_capacity_for(count);
+
+    if (!cap) return NEXUS_FALSE;
+    if (cap <= m->capacity) return NEXUS_TRUE;
+    return nexus__hashmap_rehash(m, cap);
+}
+
+void *nexus_hashmap_get(const nexus_hashmap *m, const void *key)
+{
+    size_t i;
+
+    if (!m->count) return NULL;
+    i = nexus__hashmap_find(m, key, nexus__hashmap_hash(m, key));
+    return i < m->capacity ? nexus__hashmap_slot(m, i) + m->value_offset : NULL;
+}
+
+void *nexus_hashmap_emplace(nexus_hashmap *m, const void *key, NEXUS_BOOL *inserted)
+{
+    nexus_u64 h = nexus__hashmap_hash(m, key);
+    size_t i = nexus__hashmap_find(m, key, h);
+    nexus_u8 *slot;
+
+    if (inserted) *inserted = NEXUS_FALSE;
+    if (i < m->capacity) return nexus__hashmap_slot(m, i) + m->value_offset;
+
+    i = m->capacity ? nexus__hashmap_find_free(m, h) : 0u;
+    if (!m->capacity || (m->growth_left == 0u && m->ctrl[i] == NEXUS_HASHMAP_EMPTY)) {
+        /* Out of room: drop deleted marks in place if they are what fills
+           the table, else double it. */
+        size_t cap = m->capacity;
+        if (!cap) cap = NEXUS_HASHMAP_GROUP;
+        else if (m->count * 2u > nexus__hashmap_max_load(cap)) cap = cap <= (size_t)-1 / 2u ? cap * 2u : 0u;
+        if (!cap || !nexus__hashmap_rehash(m, cap)) return NULL;
+        i = nexus__hashmap_find_free(m, h);
+    }
+
+    if (m->ctrl[i] == NEXUS_HASHMAP_EMPTY) m->growth_left -= 1u;
+    nexus__hashmap_set_ctrl(m, i, (unsigned)(h & 0x7Fu));
+    m->count += 1u;
+    slot = nexus__hashmap_slot(m, i);
+    memcpy(slot, key, m->key_size);
+    memset(slot + m->value_offset, 0, m->value_size);
+    if (inserted) *inserted = NEXUS_TRUE;
+    return slot + m->value_offset;
+}
+
+void *nexus_hashmap_put(nexus_hashmap *m, const void *key, const void *value)
+{
+    void *v = nexus_hashmap_emplace(m, key, NULL);
+    if (v && value) memcpy(v, value, m->value_size);
+    return v;
+}
+
+NEXUS_BOOL nexus_hashmap_remove(nexus_hashmap *m, const void *key)
+{
+    size_t i;
+
+    if (!m->count) return NEXUS_FALSE;
+    i = nexus__hashmap_find(m, key, nexus__hashmap_hash(m, key));
+    if (i == m->capacity) return NEXUS_FALSE;
+    /* A probe chain may run through this slot, so it cannot go back to
+       empty; the next rehash reclaims it. */
+    nexus__hashmap_set_ctrl(m, i, NEXUS_HASHMAP_DELETED);
+    m->count -= 1u;
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_hashmap_next(const nexus_hashmap *m, size_t *it, const void **key, void **value)
+{
+    size_t i;
+
+    for (i = *it; i < m->capacity; ++i) {
+        if (!(m->ctrl[i] & 0x80u)) {
+            nexus_u8 *slot = nexus__hashmap_slot(m, i);
+            if (key)   *key   = slot;
+            if (value) *value = slot + m->value_offset;
+            *it = i + 1u;
+            return NEXUS_TRUE;
+        }
+    }
+    *it = m->capacity;
+    return NEXUS_FALSE;
+}
+
+nexus_u64 nexus_hashmap_str_hash(const void *key, size_t key_size)
+{
+    const char *s;
+    (void)key_size;
+    memcpy(&s, key, sizeof s);
+    return nexus_hash_str(s, 0u);
+}
+
+NEXUS_BOOL nexus_hashmap_str_eq(const void *a, const void *b, size_t key_size)
+{
+    const char *sa, *sb;
+    (void)key_size;
+    memcpy(&sa, a, sizeof sa);
+    memcpy(&sb, b, sizeof sb);
+    return (NEXUS_BOOL)(sa == sb || strcmp(sa, sb) == 0);
+}
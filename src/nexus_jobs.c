@@ -0,0 +1,474 @@
+/* nexus_jobs.c — work-stealing job system: Chase-Lev deques, shared queue, futex parking */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* sched_yield() under -std=c90 */
+#endif
+
+#include <string.h>
+#include <nexus/nexus_jobs.h>
+#include <nexus/nexus_pool.h>
+#include "nexus_atomic.h"
+
+#if !defined(_WIN32)
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Config                                                              */
+/* ------------------------------------------------------------------ */
+#define NEXUS_JOBS_DEQUE       1024u  /* jobs per worker deque (power of two); overflow goes to the shared queue */
+#define NEXUS_JOBS_IDLE_SPINS  64u    /* failed searches before sleeping */
+#define NEXUS_JOBS_CHUNKS      4u     /* parallel-for chunks per thread when grain == 0 */
+#define NEXUS_JOBS_CACHE_LINE  64u
+#define NEXUS_JOBS_WAITING     0x80000000u  /* counter bit: a waiter sleeps on it */
+
+/* ------------------------------------------------------------------ */
+/* Types                                                               */
+/* ------------------------------------------------------------------ */
+typedef struct NexusJob {
+    struct NexusJob    *next;           /* shared queue link */
+    nexus_job_fn        fn;             /* either fn(arg) ... */
+    nexus_job_range_fn  range_fn;       /* ... or range_fn(arg, begin, end) */
+    void               *arg;
+    size_t              begin;
+    size_t              end;
+    nexus_job_counter  *counter;
+} NexusJob;
+
+/* Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for
+   Weak Memory Models"). The owner pushes and takes at bottom; thieves
+   take at top with a CAS. Indices only grow and are compared by signed
+   difference, so wrap-around is harmless. top and bottom sit on their
+   own cache lines since thieves hammer one and the owner the other. */
+typedef struct {
+    volatile size_t top;
+    char            pad0[NEXUS_JOBS_CACHE_LINE - sizeof(size_t)];
+    volatile size_t bottom;
+    char            pad1[NEXUS_JOBS_CACHE_LINE - sizeof(size_t)];
+    void *volatile  slots[NEXUS_JOBS_DEQUE];
+
+    nexus_jobs     *jobs;
+    unsigned        index;
+    nexus_u32       rng;                /* victim selection */
+#if defined(_WIN32)
+    HANDLE          thread;
+#else
+    pthread_t       thread;
+#endif
+} NexusJobWorker;
+
+struct nexus_jobs {
+    NexusJobWorker   *workers;
+    unsigned          worker_count;
+    nexus_pool       *pool;             /* NexusJob records */
+
+    /* Jobs from threads outside the pool, FIFO */
+    nexus_mutex       queue_lock;
+    void *volatile    queue_head;       /* NexusJob*; read unlocked to skip empty queues */
+    NexusJob         *queue_tail;
+
+    /* Parking: idle workers sleep on epoch, which every submit bumps */
+    volatile nexus_u32 epoch;
+    volatile nexus_u32 sleepers;
+    volatile nexus_u32 shutdown;
+
+    const char       *file;
+    unsigned          line;
+};
+
+static NEXUS_THREAD_LOCAL NexusJobWorker *t_jobs_worker = NULL;
+static NEXUS_THREAD_LOCAL nexus_u32       t_jobs_rng    = 0u;   /* non-worker threads */
+
+/* ------------------------------------------------------------------ */
+/* Deque                                                               */
+/* ------------------------------------------------------------------ */
+
+static NEXUS_BOOL nexus__deque_push(NexusJobWorker *w, NexusJob *job)
+{
+    size_t b = nexus__atomic_load_size(&w->bottom);
+    size_t t = nexus__atomic_load_size(&w->top);
+
+    if (b - t >= NEXUS_JOBS_DEQUE) return NEXUS_FALSE;
+    nexus__atomic_store_ptr(&w->slots[b & (NEXUS_JOBS_DEQUE - 1u)], job);
+    nexus__atomic_store_size(&w->bottom, b + 1u);      /* publishes the slot */
+    return NEXUS_TRUE;
+}
+
+static NexusJob *nexus__deque_take(NexusJobWorker *w)
+{
+    size_t b = nexus__atomic_load_size(&w->bottom) - 1u, t;
+    NexusJob *job;
+
+    /* Claim the bottom slot before looking at top; the fence pairs with
+       the one in steal so the two cannot both miss each other's claim. */
+    nexus__atomic_store_size(&w->bottom, b);
+    nexus__atomic_fence();
+    t = nexus__atomic_load_size(&w->top);
+    if ((ptrdiff_t)(b - t) < 0) {
+        nexus__atomic_store_size(&w->bottom, b + 1u);   /* was empty */
+        return NULL;
+    }
+    job = (NexusJob*)nexus__atomic_load_ptr(&w->slots[b & (NEXUS_JOBS_DEQUE - 1u)]);
+    if (b == t) {
+        /* Last job: race the thieves for it through top. */
+        if (!nexus__atomic_cas_size(&w->top, t, t + 1u)) job = NULL;
+        nexus__atomic_store_size(&w->bottom, b + 1u);
+    }
+    return job;
+}
+
+static NexusJob *nexus__deque_steal(NexusJobWorker *w)
+{
+    size_t t = nexus__atomic_load_size(&w->top), b;
+    NexusJob *job;
+
+    nexus__atomic_fence();
+    b = nexus__atomic_load_size(&w->bottom);
+    if ((ptrdiff_t)(b - t) <= 0) return NULL;
+    job = (NexusJob*)nexus__atomic_load_ptr(&w->slots[t & (NEXUS_JOBS_DEQUE - 1u)]);
+    /* Losing the CAS means the owner or another thief got it first. */
+    return nexus__atomic_cas_size(&w->top, t, t + 1u) ? job : NULL;
+}
+
+static NEXUS_BOOL nexus__deque_empty(NexusJobWorker *w)
+{
+    size_t t = nexus__atomic_load_size(&w->top);
+    return (ptrdiff_t)(nexus__atomic_load_size(&w->bottom) - t) <= 0 ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+/* ------------------------------------------------------------------ */
+/* Scheduling                                                          */
+/* ------------------------------------------------------------------ */
+
+static nexus_u32 nexus__jobs_random(nexus_u32 *state)
+{
+    nexus_u32 x = *state ? *state : 0x9E3779B9u;   /* xorshift32 */
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *state = x;
+}
+
+/* The calling thread's worker in `jobs`, or NULL. */
+static NexusJobWorker *nexus__jobs_self(const nexus_jobs *jobs)
+{
+    return (t_jobs_worker && t_jobs_worker->jobs == jobs) ? t_jobs_worker : NULL;
+}
+
+static void nexus__jobs_notify(nexus_jobs *jobs)
+{
+    nexus__atomic_add_u32(&jobs->epoch, 1u);
+    nexus__atomic_fence();
+    if (nexus__atomic_load_u32(&jobs->sleepers)) nexus_futex_wake(&jobs->epoch, NEXUS_FALSE);
+}
+
+static void nexus__jobs_enqueue(nexus_jobs *jobs, NexusJob *job)
+{
+    NexusJobWorker *self = nexus__jobs_self(jobs);
+
+    if (!self || !nexus__deque_push(self, job)) {
+        job->next = NULL;
+        nexus_mutex_lock(&jobs->queue_lock);
+        if (jobs->queue_head) jobs->queue_tail->next = job;
+        else nexus__atomic_store_ptr(&jobs->queue_head, job);
+        jobs->queue_tail = job;
+        nexus_mutex_unlock(&jobs->queue_lock);
+    }
+    nexus__jobs_notify(jobs);
+}
+
+/* Own deque first, then the shared queue, then steal from a random
+   starting victim. */
+static NexusJob *nexus__jobs_find(nexus_jobs *jobs, NexusJobWorker *self)
+{
+    NexusJob *job;
+    unsigned i, start, n = jobs->worker_count;
+
+    if (self && (job = nexus__deque_take(self)) != NULL) return job;
+
+    if (nexus__atomic_load_ptr(&jobs->queue_head)) {
+        nexus_mutex_lock(&jobs->queue_lock);
+        job = (NexusJob*)jobs->queue_head;
+        if (job) nexus__atomic_store_ptr(&jobs->queue_head, job->next);
+        nexus_mutex_unlock(&jobs->queue_lock);
+        if (job) return job;
+    }
+
+    start = (unsigned)(nexus__jobs_random(self ? &self->rng : &t_jobs_rng) % n);
+    for (i = 0; i < n; ++i) {
+        NexusJobWorker *victim = &jobs->workers[(start + i) % n];
+        if (victim != self && (job = nexus__deque_steal(victim)) != NULL) return job;
+    }
+    return NULL;
+}
+
+/* Conservative re-check before sleeping: anything queued anywhere. */
+static NEXUS_BOOL nexus__jobs_has_work(nexus_jobs *jobs)
+{
+    unsigned i;
+
+    if (nexus__atomic_load_ptr(&jobs->queue_head)) return NEXUS_TRUE;
+    for (i = 0; i < jobs->worker_count; ++i)
+        if (!nexus__deque_empty(&jobs->workers[i])) return NEXUS_TRUE;
+    return NEXUS_FALSE;
+}
+
+static void nexus__jobs_done(nexus_job_counter *counter)
+{
+    nexus_u32 prev;
+
+    if (!counter) return;
+    prev = nexus__atomic_add_u32(&counter->pending, (nexus_u32)-1);
+    if (prev == (NEXUS_JOBS_WAITING | 1u)) nexus_futex_wake(&counter->pending, NEXUS_TRUE);
+}
+
+static void nexus__jobs_run(nexus_jobs *jobs, NexusJob *job)
+{
+    nexus_job_counter *counter = job->counter;
+
+    if (job->range_fn) job->range_fn(job->arg, job->begin, job->end);
+    else               job->fn(job->arg);
+    nexus_pool_free(jobs->pool, job);
+    nexus__jobs_done(counter);
+}
+
+static void nexus__jobs_push(nexus_jobs *jobs, nexus_job_fn fn, nexus_job_range_fn range_fn, void *arg,
+                             size_t begin, size_t end, nexus_job_counter *counter)
+{
+    NexusJob *job = (NexusJob*)nexus_pool_alloc(jobs->pool);
+
+    if (!job) {
+        if (range_fn) range_fn(arg, begin, end);
+        else          fn(arg);
+        nexus__jobs_done(counter);
+        return;
+    }
+    job->next     = NULL;
+    job->fn       = fn;
+    job->range_fn = range_fn;
+    job->arg      = arg;
+    job->begin    = begin;
+    job->end      = end;
+    job->counter  = counter;
+    nexus__jobs_enqueue(jobs, job);
+}
+
+/* ------------------------------------------------------------------ */
+/* Workers                                                             */
+/* ------------------------------------------------------------------ */
+
+static void nexus__jobs_worker_loop(NexusJobWorker *w)
+{
+    nexus_jobs *jobs = w->jobs;
+    unsigned idle = 0;
+    nexus_u32 epoch;
+    NexusJob *job;
+
+    t_jobs_worker = w;
+    for (;;) {
+        if ((job = nexus__jobs_find(jobs, w)) != NULL) {
+            nexus__jobs_run(jobs, job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < NEXUS_JOBS_IDLE_SPINS) {
+            nexus__cpu_relax();
+            continue;
+        }
+        /* Announce the sleep, then re-check: a submit either sees us in
+           sleepers and wakes epoch, or we see its work or its epoch bump. */
+        nexus__atomic_add_u32(&jobs->sleepers, 1u);
+        nexus__atomic_fence();
+        epoch = nexus__atomic_load_u32(&jobs->epoch);
+        if (!nexus__jobs_has_work(jobs)) {
+            if (nexus__atomic_load_u32(&jobs->shutdown)) {
+                nexus__atomic_add_u32(&jobs->sleepers, (nexus_u32)-1);
+                break;
+            }
+            nexus_futex_wait(&jobs->epoch, epoch);
+        }
+        nexus__atomic_add_u32(&jobs->sleepers, (nexus_u32)-1);
+        idle = 0;
+    }
+    t_jobs_worker = NULL;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI nexus__jobs_worker_main(LPVOID arg) { nexus__jobs_worker_loop((NexusJobWorker*)arg); return 0; }
+#else
+static void *nexus__jobs_worker_main(void *arg) { nexus__jobs_worker_loop((NexusJobWorker*)arg); return NULL; }
+#endif
+
+static unsigned nexus__jobs_cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (unsigned)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1u;
+#else
+    return 1u;
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+nexus_jobs *nexus_jobs_create(unsigned workers, const char *file, unsigned line)
+{
+    nexus_jobs *jobs;
+    unsigned i;
+
+    if (!workers) {
+        workers = nexus__jobs_cpu_count();
+        workers = workers > 1u ? workers - 1u : 1u;
+    }
+    jobs = (nexus_jobs*)NEXUS_ALLOC_AT(sizeof *jobs, file, line);
+    if (!jobs) return NULL;
+    memset(jobs, 0, sizeof *jobs);
+    jobs->file = file;
+    jobs->line = line;
+    jobs->pool = nexus_pool_create(sizeof(NexusJob), 0u, file, line);
+    jobs->workers = (NexusJobWorker*)NEXUS_ALLOC_ALIGNED_AT(workers * sizeof(NexusJobWorker),
+                                                           NEXUS_JOBS_CACHE_LINE, file, line);
+    if (!jobs->pool || !jobs->workers) {
+        if (jobs->pool) nexus_pool_destroy(jobs->pool);
+        NEXUS_FREE_ALIGNED(jobs->workers);
+        NEXUS_FREE(jobs);
+        return NULL;
+    }
+    memset(jobs->workers, 0, workers * sizeof(NexusJobWorker));
+
+    for (i = 0; i < workers; ++i) {
+        NexusJobWorker *w = &jobs->workers[i];
+        w->jobs  = jobs;
+        w->index = i;
+        w->rng   = 0x9E3779B9u * (i + 1u);
+    }
+    /* Workers steal from every slot up to worker_count, so publish the
+       count before the first thread starts and trim it if one fails. */
+    jobs->worker_count = workers;
+    for (i = 0; i < workers; ++i) {
+#if defined(_WIN32)
+        jobs->workers[i].thread = CreateThread(NULL, 0, nexus__jobs_worker_main, &jobs->workers[i], 0, NULL);
+        if (!jobs->workers[i].thread) break;
+#else
+        if (pthread_create(&jobs->workers[i].thread, NULL, nexus__jobs_worker_main, &jobs->workers[i]) != 0) break;
+#endif
+    }
+    if (i < workers) {
+        unsigned started = i;
+        nexus__atomic_store_u32(&jobs->shutdown, 1u);
+        nexus__atomic_add_u32(&jobs->epoch, 1u);
+        nexus_futex_wake(&jobs->epoch, NEXUS_TRUE);
+        for (i = 0; i < started; ++i) {
+#if defined(_WIN32)
+            WaitForSingleObject(jobs->workers[i].thread, INFINITE);
+            CloseHandle(jobs->workers[i].thread);
+#else
+            pthread_join(jobs->workers[i].thread, NULL);
+#endif
+        }
+        nexus_pool_destroy(jobs->pool);
+        NEXUS_FREE_ALIGNED(jobs->workers);
+        NEXUS_FREE(jobs);
+        return NULL;
+    }
+    return jobs;
+}
+
+void nexus_jobs_destroy(nexus_jobs *jobs)
+{
+    unsigned i;
+
+    if (!jobs) return;
+    nexus__atomic_store_u32(&jobs->shutdown, 1u);
+    nexus__atomic_add_u32(&jobs->epoch, 1u);
+    nexus_futex_wake(&jobs->epoch, NEXUS_TRUE);
+    for (i = 0; i < jobs->worker_count; ++i) {
+#if defined(_WIN32)
+        WaitForSingleObject(jobs->workers[i].thread, INFINITE);
+        CloseHandle(jobs->workers[i].thread);
+#else
+        pthread_join(jobs->workers[i].thread, NULL);
+#endif
+    }
+    nexus_pool_destroy(jobs->pool);
+    NEXUS_FREE_ALIGNED(jobs->workers);
+    NEXUS_FREE(jobs);
+}
+
+unsigned nexus_jobs_worker_count(const nexus_jobs *jobs)
+{
+    return jobs->worker_count;
+}
+
+int nexus_jobs_worker_index(const nexus_jobs *jobs)
+{
+    NexusJobWorker *self = nexus__jobs_self(jobs);
+    return self ? (int)self->index : -1;
+}
+
+void nexus_jobs_submit(nexus_jobs *jobs, nexus_job_fn fn, void *arg, nexus_job_counter *counter)
+{
+    if (counter) nexus__atomic_add_u32(&counter->pending, 1u);
+    nexus__jobs_push(jobs, fn, NULL, arg, 0u, 0u, counter);
+}
+
+void nexus_jobs_submit_range(nexus_jobs *jobs, size_t begin, size_t end, size_t grain,
+                             nexus_job_range_fn fn, void *arg, nexus_job_counter *counter)
+{
+    size_t n, chunks, at;
+
+    if (end <= begin) return;
+    n = end - begin;
+    if (!grain) {
+        size_t target = (size_t)(jobs->worker_count + 1u) * NEXUS_JOBS_CHUNKS;
+        grain = (n + target - 1u) / target;
+    }
+    chunks = n / grain + (n % grain != 0u);
+    if (counter) nexus__atomic_add_u32(&counter->pending, (nexus_u32)chunks);
+    for (at = begin; at < end; ) {
+        size_t stop = (end - at > grain) ? at + grain : end;
+        nexus__jobs_push(jobs, NULL, fn, arg, at, stop, counter);
+        at = stop;
+    }
+}
+
+void nexus_jobs_wait(nexus_jobs *jobs, nexus_job_counter *counter)
+{
+    NexusJobWorker *self = nexus__jobs_self(jobs);
+    unsigned idle = 0;
+    nexus_u32 v;
+    NexusJob *job;
+
+    while (((v = nexus__atomic_load_u32(&counter->pending)) & ~NEXUS_JOBS_WAITING) != 0u) {
+        if ((job = nexus__jobs_find(jobs, self)) != NULL) {
+            nexus__jobs_run(jobs, job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < NEXUS_JOBS_IDLE_SPINS || nexus__jobs_has_work(jobs)) {
+            nexus__cpu_relax();
+            continue;
+        }
+        /* Nothing left to help with: the counter's jobs are running on
+           other threads. Flag it so the last one wakes us. */
+        if (!(v & NEXUS_JOBS_WAITING)
+            && !nexus__atomic_cas_u32(&counter->pending, v, v | NEXUS_JOBS_WAITING)) continue;
+        nexus_futex_wait(&counter->pending, v | NEXUS_JOBS_WAITING);
+    }
+    /* Leave it reading zero for reuse. */
+    if (v == NEXUS_JOBS_WAITING) nexus__atomic_cas_u32(&counter->pending, v, 0u);
+}
+
+void nexus_jobs_parallel_for(nexus_jobs *jobs, size_t begin, size_t end, size_t grain,
+                             nexus_job_range_fn fn, void *arg)
+{
+    nexus_job_counter counter = NEXUS_JOB_COUNTER_INIT;
+
+    nexus_jobs_submit_range(jobs, begin, end, grain, fn, arg, &counter);
+    nexus_jobs_wait(jobs, &counter);
+}
@@ -0,0 +1,205 @@
+/* nexus_mem_snapshot.c — heap snapshot file format (write, read, free) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <nexus/nexus_mem_snapshot.h>
+
+/* Snapshots are bookkeeping, not user data: keep them out of the tracked heap. */
+#ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
+#  undef malloc
+#  undef realloc
+#  undef free
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Format                                                              */
+/* ------------------------------------------------------------------ */
+/* magic[6] "NXSNAP", u16 version
+   u64 timestamp, u64 sample_rate, u32 file_count, u32 site_count, u64 alloc_count
+   file_count x { u32 length, bytes (no terminator) }
+   site_count x { u32 file index, u32 line, u64 live_count, bytes_live, alloc_total,
+                  free_total, est_bytes_live, est_alloc_total, est_free_total }
+   alloc_count x { u64 address, u64 size, u32 site }
+   All integers little-endian. */
+#define NEXUS_SNAPSHOT_MAGIC   "NXSNAP"
+#define NEXUS_SNAPSHOT_VERSION 1u
+
+static void nexus__put_u32(FILE *f, nexus_u32 v)
+{
+    unsigned char b[4];
+    b[0] = (unsigned char)v;         b[1] = (unsigned char)(v >> 8);
+    b[2] = (unsigned char)(v >> 16); b[3] = (unsigned char)(v >> 24);
+    fwrite(b, 1u, sizeof b, f);
+}
+
+static void nexus__put_u64(FILE *f, nexus_u64 v)
+{
+    nexus__put_u32(f, (nexus_u32)v);
+    nexus__put_u32(f, (nexus_u32)(v >> 32));
+}
+
+static NEXUS_BOOL nexus__get_u32(FILE *f, nexus_u32 *v)
+{
+    unsigned char b[4];
+    if (fread(b, 1u, sizeof b, f) != sizeof b) return NEXUS_FALSE;
+    *v = (nexus_u32)b[0] | ((nexus_u32)b[1] << 8) | ((nexus_u32)b[2] << 16) | ((nexus_u32)b[3] << 24);
+    return NEXUS_TRUE;
+}
+
+static NEXUS_BOOL nexus__get_u64(FILE *f, nexus_u64 *v)
+{
+    nexus_u32 lo, hi;
+    if (!nexus__get_u32(f, &lo) || !nexus__get_u32(f, &hi)) return NEXUS_FALSE;
+    *v = (nexus_u64)lo | ((nexus_u64)hi << 32);
+    return NEXUS_TRUE;
+}
+
+/* Sites are sorted by file, so a new name starts wherever it changes. */
+static NEXUS_BOOL nexus__new_file(const nexus_mem_snapshot *snap, unsigned i)
+{
+    return !i || strcmp(snap->sites[i].file, snap->sites[i - 1u].file) != 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+void nexus_mem_snapshot_free(nexus_mem_snapshot *snap)
+{
+    if (!snap) return;
+    free(snap->sites);
+    free(snap->allocs);
+    free(snap->strings);
+    free(snap);
+}
+
+int nexus_mem_snapshot_write(const nexus_mem_snapshot *snap, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    nexus_u32 files = 0u, file_index = 0u;
+    nexus_u64 a;
+    unsigned i;
+    int failed;
+
+    if (!f) return -1;
+    for (i = 0; i < snap->site_count; ++i) files += nexus__new_file(snap, i);
+
+    fwrite(NEXUS_SNAPSHOT_MAGIC, 1u, 6u, f);
+    fputc((int)(NEXUS_SNAPSHOT_VERSION & 0xFFu), f);
+    fputc((int)(NEXUS_SNAPSHOT_VERSION >> 8), f);
+    nexus__put_u64(f, snap->timestamp);
+    nexus__put_u64(f, snap->sample_rate);
+    nexus__put_u32(f, files);
+    nexus__put_u32(f, snap->site_count);
+    nexus__put_u64(f, snap->alloc_count);
+
+    for (i = 0; i < snap->site_count; ++i) {
+        if (nexus__new_file(snap, i)) {
+            size_t len = strlen(snap->sites[i].file);
+            nexus__put_u32(f, (nexus_u32)len);
+            fwrite(snap->sites[i].file, 1u, len, f);
+        }
+    }
+    for (i = 0; i < snap->site_count; ++i) {
+        const nexus_mem_snapshot_site *s = &snap->sites[i];
+        if (i && nexus__new_file(snap, i)) file_index += 1u;
+        nexus__put_u32(f, file_index);
+        nexus__put_u32(f, s->line);
+        nexus__put_u64(f, s->live_count);
+        nexus__put_u64(f, s->bytes_live);
+        nexus__put_u64(f, s->alloc_total);
+        nexus__put_u64(f, s->free_total);
+        nexus__put_u64(f, s->est_bytes_live);
+        nexus__put_u64(f, s->est_alloc_total);
+        nexus__put_u64(f, s->est_free_total);
+    }
+    for (a = 0; a < snap->alloc_count; ++a) {
+        nexus__put_u64(f, snap->allocs[a].address);
+        nexus__put_u64(f, snap->allocs[a].size);
+        nexus__put_u32(f, snap->allocs[a].site);
+    }
+
+    failed = ferror(f);
+    if (fclose(f) != 0) failed = 1;
+    return failed ? -1 : 0;
+}
+
+nexus_mem_snapshot *nexus_mem_snapshot_read(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    nexus_mem_snapshot *snap = NULL;
+    size_t *offsets = NULL, used = 0u, cap = 0u;
+    nexus_u32 files = 0u, sites = 0u, i, u32;
+    nexus_u64 a;
+    char magic[8];
+
+    if (!f) return NULL;
+    if (fread(magic, 1u, sizeof magic, f) != sizeof magic
+        || memcmp(magic, NEXUS_SNAPSHOT_MAGIC, 6u) != 0
+        || ((unsigned)(unsigned char)magic[6] | ((unsigned)(unsigned char)magic[7] << 8)) != NEXUS_SNAPSHOT_VERSION)
+        goto fail;
+
+    snap = (nexus_mem_snapshot*)calloc(1u, sizeof *snap);
+    if (!snap) goto fail;
+    if (!nexus__get_u64(f, &snap->timestamp) || !nexus__get_u64(f, &snap->sample_rate)
+        || !nexus__get_u32(f, &files) || !nexus__get_u32(f, &sites)
+        || !nexus__get_u64(f, &snap->alloc_count))
+        goto fail;
+
+    /* File names into one store; pointers are fixed up once it stops moving. */
+    offsets = (size_t*)malloc((files ? files : 1u) * sizeof *offsets);
+    if (!offsets) goto fail;
+    for (i = 0; i < files; ++i) {
+        if (!nexus__get_u32(f, &u32)) goto fail;
+        if (used + u32 + 1u > cap) {
+            char *p;
+            cap = (used + u32 + 1u) * 2u;
+            p = (char*)realloc(snap->strings, cap);
+            if (!p) goto fail;
+            snap->strings = p;
+        }
+        if (fread(snap->strings + used, 1u, u32, f) != u32) goto fail;
+        snap->strings[used + u32] = '\0';
+        offsets[i] = used;
+        used += u32 + 1u;
+    }
+
+    snap->sites = (nexus_mem_snapshot_site*)malloc((sites ? sites : 1u) * sizeof *snap->sites);
+    if (!snap->sites) goto fail;
+    for (i = 0; i < sites; ++i) {
+        nexus_mem_snapshot_site *s = &snap->sites[i];
+        if (!nexus__get_u32(f, &u32) || u32 >= files) goto fail;
+        s->file = snap->strings + offsets[u32];
+        if (!nexus__get_u32(f, &u32)) goto fail;
+        s->line = u32;
+        if (!nexus__get_u64(f, &s->live_count) || !nexus__get_u64(f, &s->bytes_live)
+            || !nexus__get_u64(f, &s->alloc_total) || !nexus__get_u64(f, &s->free_total)
+            || !nexus__get_u64(f, &s->est_bytes_live) || !nexus__get_u64(f, &s->est_alloc_total)
+            || !nexus__get_u64(f, &s->est_free_total))
+            goto fail;
+        snap->site_count = i + 1u;
+    }
+
+    if (snap->alloc_count > (size_t)-1 / sizeof *snap->allocs) goto fail;
+    snap->allocs = (nexus_mem_snapshot_alloc*)malloc(
+        (size_t)(snap->alloc_count ? snap->alloc_count : 1u) * sizeof *snap->allocs);
+    if (!snap->allocs) goto fail;
+    for (a = 0; a < snap->alloc_count; ++a) {
+        nexus_mem_snapshot_alloc *o = &snap->allocs[a];
+        if (!nexus__get_u64(f, &o->address) || !nexus__get_u64(f, &o->size)
+            || !nexus__get_u32(f, &u32) || u32 >= sites)
+            goto fail;
+        o->site = u32;
+    }
+
+    free(offsets);
+    fclose(f);
+    return snap;
+
+fail:
+    free(offsets);
+    nexus_mem_snapshot_free(snap);
+    fclose(f);
+    return NULL;
+}
@@ -0,0 +1,549 @@
+/* nexus_mem_stats.c — lock-free allocation counters behind NEXUS_MEMORY_STATS */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* sched_yield() under -std=c90 */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <nexus/nexus.h>
+#include <nexus/nexus_mem_stats.h>
+#include <nexus/nexus_sync.h>
+#include "nexus_atomic.h"
+
+/* Stats records and backing blocks must come from the real CRT. */
+#ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
+#  undef malloc
+#  undef realloc
+#  undef free
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Config                                                              */
+/* ------------------------------------------------------------------ */
+#define NEXUS_STATS_SITES        4096u   /* power of two; slot 0 is the overflow bucket */
+#define NEXUS_STATS_PROBES       64u
+#define NEXUS_STATS_FLUSH_OPS    64u     /* allocations between flushes to the shared peak/rate */
+#define NEXUS_STATS_FLUSH_BYTES  (64u * 1024u)
+
+/* ------------------------------------------------------------------ */
+/* Types & globals                                                     */
+/* ------------------------------------------------------------------ */
+
+/* In front of every block: what free needs to undo the counts. */
+typedef struct {
+    size_t size;
+    size_t site;
+} NexusStatsHeader;
+
+#define NEXUS_STATS_HEADER_SIZE (((sizeof(NexusStatsHeader) + 15u) / 16u) * 16u)
+
+/* One per thread that ever allocated; written only by its owner. Records
+   are never freed, so counts survive the thread. */
+typedef struct NexusStatsThread {
+    struct NexusStatsThread *next;
+    volatile size_t alloc_count;
+    volatile size_t free_count;
+    volatile size_t bytes_alloc;
+    volatile size_t bytes_free;
+    volatile size_t classes[NEXUS_MEM_STATS_CLASSES];
+
+    /* Not yet folded into g_live / the rate series (owner only) */
+    size_t   pending_live;     /* wraps; read as signed */
+    unsigned pending_allocs;
+} NexusStatsThread;
+
+typedef struct {
+    volatile size_t  tag;      /* 0 = empty; claimed by CAS */
+    const char      *file;
+    unsigned         line;
+    volatile nexus_u32 ready;  /* file/line published */
+    volatile nexus_u32 budget; /* most specific budget covering the site; 0 = none */
+    volatile size_t  bytes_live;
+    volatile size_t  alloc_total;
+    volatile size_t  free_total;
+} NexusStatsSite;
+
+typedef struct {
+    volatile size_t second;
+    volatile size_t count;
+} NexusStatsRate;
+
+static void *volatile g_threads = NULL;                 /* NexusStatsThread stack */
+static NEXUS_THREAD_LOCAL NexusStatsThread *t_stats = NULL;
+
+static volatile size_t g_live = 0u;                     /* flushed live bytes */
+static volatile size_t g_peak = 0u;
+
+static NexusStatsSite g_sites[NEXUS_STATS_SITES];
+static NexusStatsRate g_rate[NEXUS_MEM_STATS_RATE_SECONDS];
+
+/* Slot 0 is the process-wide budget, checked against g_live. Scopes are
+   written once before `used` is published and slots are never reused;
+   limits change atomically, the callback under g_budget_lock. */
+typedef struct {
+    volatile nexus_u32    used;
+    const char           *file;
+    unsigned              line;     /* 0: every site in file */
+    volatile size_t       soft;
+    volatile size_t       hard;
+    volatile size_t       live;     /* bytes at attached sites (wraps; read as signed) */
+    nexus_mem_pressure_fn fn;
+    void                 *user;
+} NexusStatsBudget;
+
+static NexusStatsBudget   g_budgets[NEXUS_MEM_BUDGETS];
+static nexus_mutex        g_budget_lock = NEXUS_MUTEX_INIT;   /* writers, and callback reads */
+static NEXUS_THREAD_LOCAL unsigned t_pressure = 0u;          /* inside a pressure callback */
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static NexusStatsThread *nexus__stats_thread(void)
+{
+    NexusStatsThread *t = t_stats;
+    void *head;
+
+    if (t) return t;
+    t = (NexusStatsThread*)calloc(1u, sizeof *t);
+    if (!t) return NULL;
+    do {
+        head = nexus__atomic_load_ptr(&g_threads);
+        t->next = (NexusStatsThread*)head;
+    } while (!nexus__atomic_cas_ptr(&g_threads, head, t));
+    return t_stats = t;
+}
+
+static unsigned nexus__stats_class(size_t size)
+{
+    unsigned k = 0u;
+    while (size && k < NEXUS_MEM_STATS_CLASSES - 1u) {
+        size >>= 1;
+        k += 1u;
+    }
+    return k;
+}
+
+/* Most specific budget covering file:line; 0 for none. */
+static nexus_u32 nexus__budget_find(const char *file, unsigned line)
+{
+    nexus_u32 i, best = 0u;
+
+    if (!file) return 0u;
+    for (i = 1u; i < NEXUS_MEM_BUDGETS; ++i) {
+        const NexusStatsBudget *b = &g_budgets[i];
+        if (!nexus__atomic_load_u32((volatile nexus_u32*)&b->used)) break;
+        if (strcmp(b->file, file) != 0) continue;
+        if (b->line == line) return i;
+        if (!b->line) best = i;
+    }
+    return best;
+}
+
+/* Find or claim the slot for (file, line); 0 when the table is full. */
+static size_t nexus__stats_site(const char *file, unsigned line)
+{
+    size_t tag = (((size_t)file >> 3) ^ ((size_t)line * 0x9E3779B1u)) | 1u;
+    size_t i = tag & (NEXUS_STATS_SITES - 1u);
+    unsigned probe;
+
+    for (probe = 0u; probe < NEXUS_STATS_PROBES; ++probe, i = (i + 1u) & (NEXUS_STATS_SITES - 1u)) {
+        NexusStatsSite *s = &g_sites[i];
+        size_t seen;
+
+        if (!i) continue;
+        seen = nexus__atomic_load_size(&s->tag);
+        if (!seen) {
+            if (nexus__atomic_cas_size(&s->tag, 0u, tag)) {
+                s->file = file;
+                s->line = line;
+                nexus__atomic_store_u32(&s->budget, nexus__budget_find(file, line));
+                nexus__atomic_store_u32(&s->ready, 1u);
+                return i;
+            }
+            seen = nexus__atomic_load_size(&s->tag);
+        }
+        if (seen == tag) {
+            while (!nexus__atomic_load_u32(&s->ready)) nexus__cpu_relax();
+            if (s->file == file && s->line == line) return i;
+        }
+    }
+    return 0u;
+}
+
+static void nexus__stats_rate_add(size_t allocs)
+{
+    size_t now = (size_t)time(NULL);
+    NexusStatsRate *r = &g_rate[now % NEXUS_MEM_STATS_RATE_SECONDS];
+    size_t seen = nexus__atomic_load_size(&r->second);
+
+    /* First flush of a new second recycles the slot. Adds racing the reset
+       can be lost; flushes are rare enough that this stays in the noise. */
+    if (seen != now && nexus__atomic_cas_size(&r->second, seen, now))
+        nexus__atomic_store_size(&r->count, 0u);
+    nexus__atomic_add_size(&r->count, allocs);
+}
+
+/* ------------------------------------------------------------------ */
+/* Budget checks                                                       */
+/* ------------------------------------------------------------------ */
+
+static size_t nexus__budget_clamp(size_t live)
+{
+    return (ptrdiff_t)live < 0 ? 0u : live;
+}
+
+/* Call budget `id`'s callback, unless this thread is already inside one. */
+static void nexus__budget_pressure(nexus_u32 id, size_t site, size_t live, size_t request,
+                                   size_t limit, NEXUS_BOOL hard)
+{
+    nexus_mem_pressure    p;
+    nexus_mem_pressure_fn fn;
+    void *user;
+
+    if (t_pressure) return;
+    nexus_mutex_lock(&g_budget_lock);
+    fn   = g_budgets[id].fn;
+    user = g_budgets[id].user;
+    nexus_mutex_unlock(&g_budget_lock);
+    if (!fn) return;
+
+    p.budget     = (int)id;
+    p.file       = site ? g_sites[site].file : NULL;
+    p.line       = site ? g_sites[site].line : 0u;
+    p.bytes_live = live;
+    p.request    = request;
+    p.limit      = limit;
+    p.hard       = hard;
+    t_pressure = 1u;
+    fn(user, &p);
+    t_pressure = 0u;
+}
+
+static void nexus__budget_adjust(size_t site, size_t delta)
+{
+    nexus_u32 id = nexus__atomic_load_u32(&g_sites[site].budget);
+    if (id) nexus__atomic_add_size(&g_budgets[id].live, delta);
+}
+
+/* Admit `size` more bytes at `site` under its budget and the process-wide
+   one. Each hard limit gets one callback to make room before it refuses. */
+static NEXUS_BOOL nexus__budget_charge(size_t site, size_t size)
+{
+    nexus_u32 id = nexus__atomic_load_u32(&g_sites[site].budget);
+    size_t hard = nexus__atomic_load_size(&g_budgets[0].hard);
+    size_t soft, before, live;
+    NexusStatsThread *t;
+    int tries;
+
+    if (id) {
+        NexusStatsBudget *b = &g_budgets[id];
+        size_t limit;
+
+        for (tries = 0;; ++tries) {
+            before = nexus__budget_clamp(nexus__atomic_add_size(&b->live, size));
+            limit  = nexus__atomic_load_size(&b->hard);
+            if (!limit || (size <= limit && before <= limit - size)) break;
+            nexus__atomic_add_size(&b->live, (size_t)0 - size);
+            if (tries) return NEXUS_FALSE;
+            nexus__budget_pressure(id, site, before, size, limit, NEXUS_TRUE);
+        }
+        soft = nexus__atomic_load_size(&b->soft);
+        if (soft && before < soft && before + size >= soft)
+            nexus__budget_pressure(id, site, before + size, size, soft, NEXUS_FALSE);
+    }
+
+    for (tries = 0; hard; ++tries) {
+        t = nexus__stats_thread();
+        live = nexus__budget_clamp(nexus__atomic_load_size(&g_live) + (t ? t->pending_live : 0u));
+        if (size <= hard && live <= hard - size) break;
+        if (tries) {
+            nexus__budget_adjust(site, (size_t)0 - size);
+            return NEXUS_FALSE;
+        }
+        nexus__budget_pressure(0u, site, live, size, hard, NEXUS_TRUE);
+        hard = nexus__atomic_load_size(&g_budgets[0].hard);
+    }
+    return NEXUS_TRUE;
+}
+
+/* Move a site's live bytes under budget `id`. */
+static void nexus__budget_attach(NexusStatsSite *s, nexus_u32 id)
+{
+    nexus_u32 old = nexus__atomic_load_u32(&s->budget);
+    size_t live;
+
+    if (!id || old == id) return;
+    nexus__atomic_store_u32(&s->budget, id);
+    live = nexus__atomic_load_size(&s->bytes_live);
+    if (old) nexus__atomic_add_size(&g_budgets[old].live, (size_t)0 - live);
+    nexus__atomic_add_size(&g_budgets[id].live, live);
+}
+
+/* ------------------------------------------------------------------ */
+/* Counting                                                            */
+/* ------------------------------------------------------------------ */
+
+/* Fold the thread's pending delta into the shared live/peak and rate;
+   returns the shared live count. */
+static size_t nexus__stats_flush(NexusStatsThread *t)
+{
+    size_t live = nexus__atomic_add_size(&g_live, t->pending_live) + t->pending_live;
+    size_t peak = nexus__atomic_load_size(&g_peak);
+
+    while ((ptrdiff_t)live > 0 && live > peak && !nexus__atomic_cas_size(&g_peak, peak, live))
+        peak = nexus__atomic_load_size(&g_peak);
+    if (t->pending_allocs) nexus__stats_rate_add(t->pending_allocs);
+    t->pending_live   = 0u;
+    t->pending_allocs = 0u;
+    return live;
+}
+
+static void nexus__stats_on_alloc(size_t size, size_t site)
+{
+    NexusStatsThread *t = nexus__stats_thread();
+
+    nexus__atomic_add_size(&g_sites[site].bytes_live, size);
+    nexus__atomic_add_size(&g_sites[site].alloc_total, 1u);
+    if (!t) return;
+    t->alloc_count += 1u;
+    t->bytes_alloc += size;
+    t->classes[nexus__stats_class(size)] += 1u;
+    t->pending_live += size;
+    t->pending_allocs += 1u;
+    if (t->pending_allocs >= NEXUS_STATS_FLUSH_OPS || (ptrdiff_t)t->pending_live > (ptrdiff_t)NEXUS_STATS_FLUSH_BYTES) {
+        size_t grew = t->pending_live;
+        size_t live = nexus__budget_clamp(nexus__stats_flush(t));
+        size_t soft = nexus__atomic_load_size(&g_budgets[0].soft);
+
+        /* The process-wide soft limit is only seen crossing at a flush. */
+        if (soft && (ptrdiff_t)grew > 0 && live >= soft && live - grew < soft)
+            nexus__budget_pressure(0u, site, live, 0u, soft, NEXUS_FALSE);
+    }
+}
+
+static void nexus__stats_on_free(size_t size, size_t site)
+{
+    NexusStatsThread *t = nexus__stats_thread();
+
+    nexus__atomic_add_size(&g_sites[site].bytes_live, (size_t)0 - size);
+    nexus__atomic_add_size(&g_sites[site].free_total, 1u);
+    nexus__budget_adjust(site, (size_t)0 - size);
+    if (!t) return;
+    t->free_count += 1u;
+    t->bytes_free += size;
+    t->pending_live -= size;
+    if ((ptrdiff_t)t->pending_live < -(ptrdiff_t)NEXUS_STATS_FLUSH_BYTES) nexus__stats_flush(t);
+}
+
+/* Backing allocator: the debug allocator when it is on, the CRT otherwise. */
+#ifdef NEXUS_MEMORY_DEBUG
+#  define NEXUS__STATS_BACK_ALLOC(n, file, line)      nexus_debug_mem_malloc((n), (file), (line))
+#  define NEXUS__STATS_BACK_REALLOC(p, n, file, line) nexus_debug_mem_realloc((p), (n), (file), (line))
+#  define NEXUS__STATS_BACK_FREE(p)                   nexus_debug_mem_free((p))
+#else
+#  define NEXUS__STATS_BACK_ALLOC(n, file, line)      malloc((n))
+#  define NEXUS__STATS_BACK_REALLOC(p, n, file, line) realloc((p), (n))
+#  define NEXUS__STATS_BACK_FREE(p)                   free((p))
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Allocation entry points (NEXUS_ALLOC & co. with NEXUS_MEMORY_STATS) */
+/* ------------------------------------------------------------------ */
+
+void *nexus_mem_stats_malloc(size_t size, const char *file, unsigned line)
+{
+    NexusStatsHeader *h;
+    size_t site;
+
+    if (size > (size_t)-1 - NEXUS_STATS_HEADER_SIZE) return NULL;
+    site = nexus__stats_site(file, line);
+    if (!nexus__budget_charge(site, size)) return NULL;
+    h = (NexusStatsHeader*)NEXUS__STATS_BACK_ALLOC(NEXUS_STATS_HEADER_SIZE + size, file, line);
+    (void)file; (void)line;
+    if (!h) {
+        nexus__budget_adjust(site, (size_t)0 - size);
+        return NULL;
+    }
+    h->size = size;
+    h->site = site;
+    nexus__stats_on_alloc(size, site);
+    return (nexus_u8*)h + NEXUS_STATS_HEADER_SIZE;
+}
+
+void *nexus_mem_stats_realloc(void *ptr, size_t size, const char *file, unsigned line)
+{
+    NexusStatsHeader *h;
+    size_t old_size, old_site, site;
+
+    if (!ptr) return nexus_mem_stats_malloc(size, file, line);
+    if (size > (size_t)-1 - NEXUS_STATS_HEADER_SIZE) return NULL;
+
+    h = (NexusStatsHeader*)((nexus_u8*)ptr - NEXUS_STATS_HEADER_SIZE);
+    old_size = h->size;
+    old_site = h->site;
+    site     = nexus__stats_site(file, line);
+
+    /* The new size is judged without the old block; on refusal it is
+       charged back and the block stays as it was. */
+    nexus__budget_adjust(old_site, (size_t)0 - old_size);
+    if (!nexus__budget_charge(site, size)) {
+        nexus__budget_adjust(old_site, old_size);
+        return NULL;
+    }
+    h = (NexusStatsHeader*)NEXUS__STATS_BACK_REALLOC(h, NEXUS_STATS_HEADER_SIZE + size, file, line);
+    (void)file; (void)line;
+    if (!h) {
+        nexus__budget_adjust(site, (size_t)0 - size);
+        nexus__budget_adjust(old_site, old_size);
+        return NULL;
+    }
+
+    /* Counted as a free of the old block and an allocation at this site;
+       on_free takes the old charge off again, so put it back first. */
+    nexus__budget_adjust(old_site, old_size);
+    nexus__stats_on_free(old_size, old_site);
+    h->size = size;
+    h->site = site;
+    nexus__stats_on_alloc(size, site);
+    return (nexus_u8*)h + NEXUS_STATS_HEADER_SIZE;
+}
+
+void nexus_mem_stats_free(void *ptr)
+{
+    NexusStatsHeader *h;
+
+    if (!ptr) return;
+    h = (NexusStatsHeader*)((nexus_u8*)ptr - NEXUS_STATS_HEADER_SIZE);
+    nexus__stats_on_free(h->size, h->site);
+    NEXUS__STATS_BACK_FREE(h);
+}
+
+/* ------------------------------------------------------------------ */
+/* Queries                                                             */
+/* ------------------------------------------------------------------ */
+
+void nexus_mem_stats_get(nexus_mem_stats *out)
+{
+    const NexusStatsThread *t;
+    size_t bytes_alloc = 0u, bytes_free = 0u, allocs = 0u, frees = 0u, peak;
+    unsigned k;
+
+    memset(out, 0, sizeof *out);
+    for (t = (const NexusStatsThread*)nexus__atomic_load_ptr(&g_threads); t; t = t->next) {
+        allocs      += t->alloc_count;
+        frees       += t->free_count;
+        bytes_alloc += t->bytes_alloc;
+        bytes_free  += t->bytes_free;
+        for (k = 0; k < NEXUS_MEM_STATS_CLASSES; ++k) out->size_classes[k] += t->classes[k];
+    }
+    out->alloc_total       = allocs;
+    out->free_total        = frees;
+    out->bytes_alloc_total = bytes_alloc;
+    out->allocs_live       = allocs - frees;
+    out->bytes_live        = bytes_alloc - bytes_free;
+    peak = nexus__atomic_load_size(&g_peak);
+    out->bytes_peak = peak > out->bytes_live ? peak : out->bytes_live;
+}
+
+static int nexus__stats_site_cmp(const void *a, const void *b)
+{
+    const nexus_mem_stats_site *x = (const nexus_mem_stats_site*)a;
+    const nexus_mem_stats_site *y = (const nexus_mem_stats_site*)b;
+    return (x->bytes_live < y->bytes_live) - (x->bytes_live > y->bytes_live);
+}
+
+unsigned nexus_mem_stats_sites(nexus_mem_stats_site *out, unsigned max)
+{
+    nexus_mem_stats_site *all;
+    unsigned i, n = 0u;
+
+    all = (nexus_mem_stats_site*)malloc(NEXUS_STATS_SITES * sizeof *all);
+    if (!all) return 0u;
+    for (i = 0; i < NEXUS_STATS_SITES; ++i) {
+        const NexusStatsSite *s = &g_sites[i];
+        size_t alloc_total = nexus__atomic_load_size((volatile size_t*)&s->alloc_total);
+        if (!alloc_total) continue;
+        if (i && !nexus__atomic_load_u32((volatile nexus_u32*)&s->ready)) continue;
+        all[n].file        = i ? s->file : NULL;
+        all[n].line        = i ? s->line : 0u;
+        all[n].bytes_live  = nexus__atomic_load_size((volatile size_t*)&s->bytes_live);
+        all[n].alloc_total = alloc_total;
+        all[n].free_total  = nexus__atomic_load_size((volatile size_t*)&s->free_total);
+        n += 1u;
+    }
+    qsort(all, n, sizeof *all, nexus__stats_site_cmp);
+    if (n > max) n = max;
+    if (n) memcpy(out, all, n * sizeof *all);
+    free(all);
+    return n;
+}
+
+unsigned nexus_mem_stats_rate(nexus_u64 *out, unsigned seconds)
+{
+    size_t now = (size_t)time(NULL);
+    unsigned i;
+
+    if (seconds > NEXUS_MEM_STATS_RATE_SECONDS - 1u) seconds = NEXUS_MEM_STATS_RATE_SECONDS - 1u;
+    for (i = 0; i < seconds; ++i) {
+        size_t when = now - seconds + i;
+        const NexusStatsRate *r = &g_rate[when % NEXUS_MEM_STATS_RATE_SECONDS];
+        out[i] = nexus__atomic_load_size((volatile size_t*)&r->second) == when
+               ? nexus__atomic_load_size((volatile size_t*)&r->count) : 0u;
+    }
+    return seconds;
+}
+
+/* ------------------------------------------------------------------ */
+/* Budgets                                                             */
+/* ------------------------------------------------------------------ */
+
+int nexus_mem_budget_set(const char *file, unsigned line, size_t soft_limit, size_t hard_limit,
+                         nexus_mem_pressure_fn fn, void *user)
+{
+    NexusStatsBudget *b;
+    nexus_u32 id = 0u;
+    size_t i;
+
+    nexus_mutex_lock(&g_budget_lock);
+    if (file) {
+        for (id = 1u; id < NEXUS_MEM_BUDGETS; ++id) {
+            b = &g_budgets[id];
+            if (!b->used || (b->line == line && strcmp(b->file, file) == 0)) break;
+        }
+        if (id == NEXUS_MEM_BUDGETS) {
+            nexus_mutex_unlock(&g_budget_lock);
+            return -1;
+        }
+    }
+    b = &g_budgets[id];
+    b->fn   = fn;
+    b->user = user;
+    nexus__atomic_store_size(&b->soft, soft_limit);
+    nexus__atomic_store_size(&b->hard, hard_limit);
+
+    if (file && !b->used) {
+        b->file = file;
+        b->line = line;
+        nexus__atomic_store_u32(&b->used, 1u);
+        /* Sites seen before now move under the new scope if it is the
+           most specific one covering them. */
+        for (i = 1u; i < NEXUS_STATS_SITES; ++i) {
+            NexusStatsSite *s = &g_sites[i];
+            if (!nexus__atomic_load_size(&s->tag)) continue;
+            while (!nexus__atomic_load_u32(&s->ready)) nexus__cpu_relax();
+            nexus__budget_attach(s, nexus__budget_find(s->file, s->line));
+        }
+    }
+    nexus_mutex_unlock(&g_budget_lock);
+    return (int)id;
+}
+
+size_t nexus_mem_budget_live(int budget)
+{
+    if (budget < 0 || budget >= NEXUS_MEM_BUDGETS) return 0u;
+    if (!budget) return nexus__budget_clamp(nexus__atomic_load_size(&g_live));
+    return nexus__budget_clamp(nexus__atomic_load_size(&g_budgets[budget].live));
+}
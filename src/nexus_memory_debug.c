@@ -1,9 +1,29 @@
 /* nexus_debug_alloc.c — C89-compatible debug allocator for nexus.h */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* sched_yield(), posix_memalign() under -std=c90 */
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
 #include <nexus/nexus.h>
+#include <nexus/nexus_mem_snapshot.h>
+#include <nexus/nexus_sync.h>
+#include <nexus/nexus_hash.h>
+#include "nexus_atomic.h"
+#include "nexus_stack.h"
+#include "nexus_hash_impl.h"
+#include "nexus_memory_debug.h"
+#include "nexus_profile_impl.h"
+
+#if !defined(_WIN32)
+#  include <pthread.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
 
 /* If the header asked to override stdlib symbols for general code,
    we must call the real CRT here to avoid recursion. */
@@ -19,65 +39,530 @@
 /* ------------------------------------------------------------------ */
 /* Config                                                              */
 /* ------------------------------------------------------------------ */
-#define NEXUS_MEMORY_OVER_ALLOC   32
-#define NEXUS_MEMORY_MAGIC_NUMBER 132
+#define NEXUS_MEMORY_OVER_ALLOC    32
+#define NEXUS_MEMORY_MAGIC_NUMBER  132
+#define NEXUS_MEMORY_HEADER_MAGIC  ((size_t)0x4E58A11Cu) /* "NX ALloC" */
+#define NEXUS_MEMORY_HEADER_REMOTE ((size_t)0x4E58F4EEu) /* handed off, awaiting owner */
+#define NEXUS_MEMORY_TAG_MAGIC     ((size_t)0x4E587A67u) /* unsampled; xor'ed with the payload address */
+#define NEXUS_MEMORY_HEADER_FREED  ((size_t)0x4E58DEADu) /* freed, held in quarantine */
+#define NEXUS_MEMORY_FREED_BYTE    0xDD                  /* poison for quarantined payloads */
+#define NEXUS_MEMORY_QUARANTINE_BATCH 32                 /* frees staged per thread before publishing */
+#define NEXUS_MEMORY_ALIGN         16
+#define NEXUS_MEMORY_SHARDS        64 /* threads map round-robin onto shards */
 
 /* ------------------------------------------------------------------ */
 /* Types & globals                                                     */
 /* ------------------------------------------------------------------ */
 typedef struct {
     size_t size;     /* requested size (no guards) */
-    void  *buf;      /* start of the raw allocation (guarded) */
+    void  *buf;      /* start of the payload (header in front, guards behind) */
 } NexusAllocBuf;
 
+/* Hidden header placed directly in front of every payload. It maps a user
+   pointer back to its NexusAllocBuf in O(1):
+   g_shards[shard].lines[site].allocs[slot]. */
+typedef struct NexusAllocHeader {
+    struct NexusAllocHeader *next;  /* remote-free chain while handed off,
+                                       quarantine FIFO once freed */
+    size_t   size;   /* requested size, mirrors NexusAllocBuf.size */
+    size_t   weight; /* estimated bytes this block stands for (== size unsampled) */
+    unsigned shard;  /* owning shard; only its owner touches the tables */
+    unsigned site;   /* index into the shard's lines */
+    unsigned slot;   /* index into lines[site].allocs */
+    unsigned front;  /* raw block start to payload; larger than the header
+                        for aligned blocks (front guard) and paged ones */
+    unsigned pages;  /* page-guarded: pages in the mapping, last one
+                        inaccessible; 0 for heap blocks */
+    size_t   magic;  /* NEXUS_MEMORY_HEADER_MAGIC while live; keep last */
+} NexusAllocHeader;
+
+/* Header footprint rounded up so the payload keeps malloc's alignment. */
+#define NEXUS_MEMORY_HEADER_SIZE \
+    (((sizeof(NexusAllocHeader) + NEXUS_MEMORY_ALIGN - 1) / NEXUS_MEMORY_ALIGN) * NEXUS_MEMORY_ALIGN)
+#define NEXUS_MEMORY_RAW_SIZE(n)  (NEXUS_MEMORY_HEADER_SIZE + (n) + NEXUS_MEMORY_OVER_ALLOC)
+
+
+/* Tag in front of allocations the sampler skipped: no guards, no fill, no
+   bookkeeping. Its last word lines up with NexusAllocHeader.magic so free
+   can tell the two apart from ((size_t*)ptr)[-1]. */
+typedef struct {
+    size_t size;
+    size_t magic;    /* NEXUS_MEMORY_TAG_MAGIC ^ payload address; keep last */
+} NexusAllocTag;
+
+#define NEXUS_MEMORY_TAG_SIZE \
+    (((sizeof(NexusAllocTag) + NEXUS_MEMORY_ALIGN - 1) / NEXUS_MEMORY_ALIGN) * NEXUS_MEMORY_ALIGN)
+
 typedef struct {
     unsigned       line;
-    char           file[256];
+    const char    *file;         /* canonical copy from nexus_intern() */
+    nexus_u32      stack;        /* call path (nexus_stack.h); 0 when not captured */
     NexusAllocBuf *allocs;
     unsigned       alloc_count;
     unsigned       alloc_capacity;
 
-    /* Stats */
+    /* Stats (tracked allocations only) */
     size_t         bytes_live;   /* sum of live payload bytes for this site */
     unsigned       alloc_total;  /* total alloc calls at this site */
     unsigned       free_total;   /* total frees at this site */
+
+    /* Scaled by each sample's weight; equal to the above when not sampling */
+    size_t         est_bytes_live;
+    size_t         est_alloc_total;
+    size_t         est_free_total;
 } NexusAllocLine;
 
-static NexusAllocLine g_lines[1024];
-static unsigned       g_line_count = 0;
+/* Site index entry: (file pointer, line, stack) -> lines index. Every site is
+   reachable through its interned file pointer, and through each distinct
+   __FILE__ pointer seen for it (string literals are not merged across TUs). */
+typedef struct {
+    const char *file;            /* NULL marks an empty slot */
+    unsigned    line;
+    nexus_u32   stack;
+    unsigned    site;
+} NexusSiteSlot;
+
+/* FIFO of freed blocks chained through NexusAllocHeader.next. */
+typedef struct {
+    NexusAllocHeader *head;          /* oldest */
+    NexusAllocHeader *tail;
+    size_t            bytes;         /* payload bytes held */
+    unsigned          count;
+} NexusQuarantine;
+
+/* One shard of bookkeeping. A thread only ever adds to and removes from
+   its own shard; frees from other threads are pushed onto `remote`
+   without locking and unlinked by the owner on its next visit. The lock
+   is uncontended unless more threads than shards exist or a report runs. */
+typedef struct {
+    NexusSpinLock   lock;
+    NexusAllocLine *lines;            /* grows; indices stay stable */
+    unsigned        line_count;
+    unsigned        line_capacity;
+    NexusSiteSlot  *site_index;       /* open addressing, power of two */
+    unsigned        site_index_cap;
+    unsigned        site_index_len;
+    void *volatile  remote;           /* NexusAllocHeader stack (lock-free push) */
+    NexusQuarantine staged;           /* frees not yet moved to g_quarantine */
+} NexusMemShard;
+
+/* Merged per-site numbers, used when shards meet for reporting. */
+typedef struct {
+    const char *file;
+    unsigned    line;
+    nexus_u32   stack;
+    unsigned    origin;          /* index before merging, for remapping allocations */
+    size_t      live_count;
+    size_t      bytes_live;
+    unsigned    alloc_total;
+    unsigned    free_total;
+    size_t      est_bytes_live;
+    size_t      est_alloc_total;
+    size_t      est_free_total;
+} NexusSiteStat;
+
+static NexusMemShard     g_shards[NEXUS_MEMORY_SHARDS];
+static volatile nexus_u32 g_shard_next = 0u;
+static NEXUS_THREAD_LOCAL unsigned t_shard = 0u;  /* 1-based; 0 = unassigned */
+
+/* Sampling: track roughly one allocation per g_sample_rate bytes (0 = all).
+   Each thread counts down its own exponentially distributed interval. */
+static volatile size_t g_sample_rate = 0u;
+
+/* Frames captured per tracked allocation (0 = sites are file:line only). */
+static volatile unsigned g_stack_depth = 0u;
+static NEXUS_THREAD_LOCAL size_t    t_sample_left = 0u;
+static NEXUS_THREAD_LOCAL size_t    t_sample_rate = 0u;   /* rate t_sample_left was drawn for */
+static NEXUS_THREAD_LOCAL nexus_u32 t_sample_rng  = 0u;
+
+/* Page guards: blocks of at least g_page_min bytes end flush against an
+   inaccessible page while g_page_used stays within g_page_budget. */
+static volatile size_t g_page_min    = 0u;    /* 0 = off */
+static volatile size_t g_page_budget = 0u;
+static volatile size_t g_page_used   = 0u;
+static size_t          g_page_size   = 0u;
+
+/* Quarantine: freed blocks are poisoned and parked in a FIFO of at most
+   g_quarantine_max payload bytes. Shards stage their frees and move them
+   over a batch at a time; the oldest blocks are then checked for writes
+   after free and released. */
+static volatile size_t g_quarantine_max  = 0u;    /* 0 = off */
+static volatile size_t g_quarantine_errors = 0u;  /* write-after-free reports */
+static NexusSpinLock   g_quarantine_lock = 0u;
+static NexusQuarantine g_quarantine;
+
+/* Incremental checker cursor (shard, site, slot), shared by all callers.
+   Lock order: g_check_lock, then a shard lock. */
+static NexusSpinLock g_check_lock  = 0u;
+static unsigned      g_check_shard = 0u;
+static unsigned      g_check_site  = 0u;
+static unsigned      g_check_slot  = 0u;
+
+/* Background checker */
+static volatile nexus_u32 g_checker_run    = 0u;
+static volatile nexus_u32 g_checker_errors = 0u;
+static unsigned           g_checker_interval_ms = 0u;
+static unsigned           g_checker_budget      = 0u;
+#if defined(_WIN32)
+static HANDLE             g_checker_thread = NULL;
+#else
+static pthread_t          g_checker_thread;
+#endif
 
 static void *g_mutex = NULL;
 static void (*g_lock)(void *mutex)   = NULL;
 static void (*g_unlock)(void *mutex) = NULL;
+static nexus_mutex g_global_mutex = NEXUS_MUTEX_INIT;   /* used when no user lock is installed */
 
 /* ------------------------------------------------------------------ */
 /* Helpers                                                             */
 /* ------------------------------------------------------------------ */
 
+/* Lock order: a shard lock may be held while taking the global lock,
+   never the other way round. */
 static void nexus__lock(void)
 {
     if (g_lock && g_mutex) g_lock(g_mutex);
+    else nexus_mutex_lock(&g_global_mutex);
 }
 static void nexus__unlock(void)
 {
     if (g_unlock && g_mutex) g_unlock(g_mutex);
+    else nexus_mutex_unlock(&g_global_mutex);
 }
 
-/* Return index of (file,line) entry, or g_line_count if not found. */
-static unsigned nexus__find_site(const char *file, unsigned line)
+static NexusMemShard *nexus__shard(void)
 {
-    unsigned i, j;
-    for (i = 0; i < g_line_count; ++i) {
-        if (g_lines[i].line == line) {
-            for (j = 0; g_lines[i].file[j] == file[j] && file[j] != '\0'; ++j) {
-                /* compare */
-            }
-            if (g_lines[i].file[j] == file[j]) {
-                return i;
-            }
+    if (!t_shard) t_shard = nexus__atomic_add_u32(&g_shard_next, 1u) % NEXUS_MEMORY_SHARDS + 1u;
+    return &g_shards[t_shard - 1u];
+}
+
+static NexusAllocHeader *nexus__header(void *ptr)
+{
+    return (NexusAllocHeader*)ptr - 1;
+}
+
+static void *nexus__raw(void *ptr)
+{
+    return (nexus_u8*)ptr - nexus__header(ptr)->front;
+}
+
+static void *nexus__payload(void *raw)
+{
+    return (nexus_u8*)raw + NEXUS_MEMORY_HEADER_SIZE;
+}
+
+static NexusAllocTag *nexus__tag(void *ptr)
+{
+    return (NexusAllocTag*)ptr - 1;
+}
+
+static size_t nexus__tag_magic(const void *ptr)
+{
+    return NEXUS_MEMORY_TAG_MAGIC ^ (size_t)ptr;
+}
+
+/* Blocks from nexus_debug_mem_malloc_aligned (paged ones also sit past the header). */
+static NEXUS_BOOL nexus__is_aligned(const NexusAllocHeader *h)
+{
+    return h->front != NEXUS_MEMORY_HEADER_SIZE && !h->pages;
+}
+
+/* Tail guard length: short for paged blocks, whose guard is the slack
+   before the protected page. */
+static size_t nexus__tail_guard(const NexusAllocHeader *h)
+{
+    if (!h->pages) return NEXUS_MEMORY_OVER_ALLOC;
+    return (size_t)(h->pages - 1u) * g_page_size - h->front - h->size;
+}
+
+static size_t nexus__page_size(void)
+{
+    if (!g_page_size) {
+#if defined(_WIN32)
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        g_page_size = si.dwPageSize;
+#else
+        long n = sysconf(_SC_PAGESIZE);
+        g_page_size = n > 0 ? (size_t)n : 4096u;
+#endif
+    }
+    return g_page_size;
+}
+
+/* Map `pages` pages and make the last one inaccessible; NULL on failure. */
+static void *nexus__page_map(size_t pages)
+{
+    size_t page = nexus__page_size(), len = pages * page;
+    void *base;
+#if defined(_WIN32)
+    DWORD old;
+    base = VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (base && !VirtualProtect((nexus_u8*)base + len - page, page, PAGE_NOACCESS, &old)) {
+        VirtualFree(base, 0, MEM_RELEASE);
+        base = NULL;
+    }
+#else
+    if (posix_memalign(&base, page, len) != 0) return NULL;
+    if (mprotect((nexus_u8*)base + len - page, page, PROT_NONE) != 0) {
+        free(base);
+        base = NULL;
+    }
+#endif
+    return base;
+}
+
+static void nexus__page_unmap(void *base, size_t pages)
+{
+    size_t page = nexus__page_size();
+#if defined(_WIN32)
+    (void)pages; (void)page;
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    mprotect((nexus_u8*)base + (pages - 1u) * page, page, PROT_READ | PROT_WRITE);
+    free(base);
+#endif
+    nexus__atomic_add_size(&g_page_used, (size_t)0 - pages * page);
+}
+
+/* Give a tracked block's memory back, heap or pages. */
+static void nexus__release(void *ptr)
+{
+    unsigned pages = nexus__header(ptr)->pages;
+    if (pages) nexus__page_unmap(nexus__raw(ptr), pages);
+    else free(nexus__raw(ptr));
+}
+
+/* Page-guarded block for `size` bytes if the mode is on and the budget
+   allows; returns the payload with *front / *pages filled, else NULL. The
+   payload keeps NEXUS_MEMORY_ALIGN, so up to that many bytes of slack sit
+   between its end and the protected page. */
+static void *nexus__page_alloc(size_t size, unsigned *front, unsigned *pages)
+{
+    size_t min = g_page_min, page, n, len, used;
+    nexus_u8 *base, *end, *p;
+
+    if (!min || size < min) return NULL;
+    page = nexus__page_size();
+    if (size > (size_t)-1 / 2u - NEXUS_MEMORY_HEADER_SIZE - 2u * page) return NULL;
+    n   = (NEXUS_MEMORY_HEADER_SIZE + NEXUS_MEMORY_ALIGN + size + page - 1u) / page + 1u;
+    len = n * page;
+    do {
+        used = nexus__atomic_load_size(&g_page_used);
+        if (g_page_budget && used + len > g_page_budget) return NULL;
+    } while (!nexus__atomic_cas_size(&g_page_used, used, used + len));
+
+    base = (nexus_u8*)nexus__page_map(n);
+    if (!base) {
+        nexus__atomic_add_size(&g_page_used, (size_t)0 - len);
+        return NULL;
+    }
+    end = base + len - page;
+    p   = (nexus_u8*)((size_t)(end - size) & ~(size_t)(NEXUS_MEMORY_ALIGN - 1));
+    *front = (unsigned)(p - base);
+    *pages = (unsigned)n;
+    return p;
+}
+
+/* Next exponentially distributed sampling interval with mean `rate`. */
+static size_t nexus__sample_interval(size_t rate)
+{
+    double u;
+    if (!t_sample_rng) t_sample_rng = (nexus_u32)(size_t)&t_sample_rng ^ 0x9E3779B9u;
+    /* xorshift32 */
+    t_sample_rng ^= t_sample_rng << 13;
+    t_sample_rng ^= t_sample_rng >> 17;
+    t_sample_rng ^= t_sample_rng << 5;
+    u = ((double)(t_sample_rng >> 8) + 1.0) / 16777216.0;   /* (0, 1] */
+    return (size_t)(-log(u) * (double)rate) + 1u;
+}
+
+/* Estimated bytes a tracked block of `size` bytes stands for. Poisson
+   sampling picks this size with p = 1 - e^(-n/rate); scale by 1/p. */
+static size_t nexus__sample_weight(size_t size)
+{
+    size_t rate = g_sample_rate, n = size ? size : 1u;
+    if (!rate) return n;
+    return (size_t)((double)n / (1.0 - exp(-(double)n / (double)rate)));
+}
+
+/* Decide whether to track an allocation of `size` bytes. Returns the
+   estimated bytes it stands for, or 0 to let it through untracked. */
+static size_t nexus__sample(size_t size)
+{
+    size_t rate = g_sample_rate, n = size ? size : 1u;
+
+    if (!rate) return n;
+    if (t_sample_rate != rate) {
+        t_sample_rate = rate;
+        t_sample_left = nexus__sample_interval(rate);
+    }
+    if (n < t_sample_left) {
+        t_sample_left -= n;
+        return 0u;
+    }
+    t_sample_left = nexus__sample_interval(rate);
+    return nexus__sample_weight(size);
+}
+
+/* Allocation count one sample stands for; same answer at alloc and free. */
+static size_t nexus__weight_count(size_t weight, size_t size)
+{
+    size_t n = size ? size : 1u;
+    size_t c = (weight + n / 2u) / n;
+    return c ? c : 1u;
+}
+
+static void nexus__out_of_memory(const char *what, size_t size, const char *file, unsigned line)
+{
+    fprintf(stderr, "MEM ERROR: %s returned NULL for %lu bytes at %s:%u\n",
+            what, (unsigned long)size, file, line);
+    nexus_debug_mem_print(0u);
+    exit(1);
+}
+
+/* Stack ID for an allocation being tracked; call straight from the
+   public entry point so the skipped frames are ours. */
+static nexus_u32 nexus__site_stack(void)
+{
+    void *frames[NEXUS_STACK_MAX_FRAMES];
+    unsigned depth = g_stack_depth;
+
+    if (!depth) return 0u;
+    depth = nexus__stack_capture(frames, depth, 2u);
+    return nexus__stack_intern(frames, depth);
+}
+
+/* Resolve a user pointer to its bookkeeping entry in sh, or NULL if the
+   header is not in the expected state or does not point back at ptr. */
+static NexusAllocBuf *nexus__lookup(NexusMemShard *sh, void *ptr, size_t magic,
+                                    NexusAllocLine **out_site)
+{
+    const NexusAllocHeader *h = nexus__header(ptr);
+    NexusAllocLine *s;
+
+    if (h->magic != magic || h->site >= sh->line_count) return NULL;
+    s = &sh->lines[h->site];
+    if (h->slot >= s->alloc_count || s->allocs[h->slot].buf != ptr) return NULL;
+
+    if (out_site) *out_site = s;
+    return &s->allocs[h->slot];
+}
+
+static void *nexus__bookkeeping_calloc(size_t count, size_t size)
+{
+    void *p = calloc(count, size);
+    if (!p) {
+        fprintf(stderr, "MEM ERROR: calloc failed while growing bookkeeping\n");
+        exit(1);
+    }
+    return p;
+}
+
+static nexus_u32 nexus__hash_site(const char *file, unsigned line, nexus_u32 stack)
+{
+    nexus_u64 h = nexus_hash_combine(nexus_hash_u64((nexus_u64)(size_t)file),
+                                     ((nexus_u64)stack << 32) | line);
+    return (nexus_u32)h;
+}
+
+/* Return the site index for (file,line,stack), or sh->line_count if not indexed. */
+static unsigned nexus__site_index_get(const NexusMemShard *sh, const char *file, unsigned line,
+                                      nexus_u32 stack)
+{
+    unsigned mask, i;
+    if (!sh->site_index_cap) return sh->line_count;
+
+    mask = sh->site_index_cap - 1u;
+    for (i = nexus__hash_site(file, line, stack) & mask; sh->site_index[i].file; i = (i + 1u) & mask) {
+        const NexusSiteSlot *slot = &sh->site_index[i];
+        if (slot->file == file && slot->line == line && slot->stack == stack) return slot->site;
+    }
+    return sh->line_count;
+}
+
+static void nexus__site_index_put(NexusMemShard *sh, const char *file, unsigned line,
+                                  nexus_u32 stack, unsigned site)
+{
+    unsigned mask, i;
+
+    if ((sh->site_index_len + 1u) * 2u > sh->site_index_cap) {
+        NexusSiteSlot *old = sh->site_index;
+        unsigned old_cap = sh->site_index_cap, k;
+
+        sh->site_index_cap = old_cap ? old_cap * 2u : 256u;
+        sh->site_index     = nexus__bookkeeping_calloc(sh->site_index_cap, sizeof *sh->site_index);
+        sh->site_index_len = 0u;
+        for (k = 0; k < old_cap; ++k) {
+            if (old[k].file) nexus__site_index_put(sh, old[k].file, old[k].line, old[k].stack, old[k].site);
         }
+        free(old);
+    }
+
+    mask = sh->site_index_cap - 1u;
+    for (i = nexus__hash_site(file, line, stack) & mask; sh->site_index[i].file; i = (i + 1u) & mask) {
+        /* probe */
     }
-    return g_line_count;
+    sh->site_index[i].file  = file;
+    sh->site_index[i].line  = line;
+    sh->site_index[i].stack = stack;
+    sh->site_index[i].site  = site;
+    sh->site_index_len += 1u;
+}
+
+/* Return index of (file,line,stack) entry in sh, creating the site if needed. */
+static unsigned nexus__find_site(NexusMemShard *sh, const char *file, unsigned line, nexus_u32 stack)
+{
+    const char *canon;
+    unsigned i = nexus__site_index_get(sh, file, line, stack);
+    NexusAllocLine *s;
+
+    if (i < sh->line_count) return i;
+
+    /* Unseen pointer: the same name may arrive through another copy of
+       __FILE__, so look again under the canonical one before creating. */
+    canon = NEXUS_INTERN_CSTR(file);
+    if (!canon) {
+        fprintf(stderr, "MEM ERROR: out of memory while interning %s\n", file);
+        exit(1);
+    }
+    i = nexus__site_index_get(sh, canon, line, stack);
+    if (i < sh->line_count) {
+        nexus__site_index_put(sh, file, line, stack, i);
+        return i;
+    }
+
+    if (sh->line_count == sh->line_capacity) {
+        unsigned new_cap = sh->line_capacity ? sh->line_capacity * 2u : 64u;
+        NexusAllocLine *p = realloc(sh->lines, (size_t)new_cap * sizeof *p);
+        if (!p) {
+            fprintf(stderr, "MEM ERROR: realloc failed while growing bookkeeping\n");
+            exit(1);
+        }
+        sh->lines = p;
+        sh->line_capacity = new_cap;
+    }
+
+    i = sh->line_count;
+    s = &sh->lines[i];
+    s->line = line;
+    s->file = canon;
+    s->stack = stack;
+    s->allocs = NULL;
+    s->alloc_count = 0u;
+    s->alloc_capacity = 0u;
+    s->bytes_live = 0u;
+    s->alloc_total = 0u;
+    s->free_total  = 0u;
+    s->est_bytes_live  = 0u;
+    s->est_alloc_total = 0u;
+    s->est_free_total  = 0u;
+    sh->line_count += 1u;
+
+    nexus__site_index_put(sh, canon, line, stack, i);
+    nexus__site_index_put(sh, file, line, stack, i);
+    return i;
 }
 
 static void nexus__ensure_capacity(NexusAllocLine *site)
@@ -95,78 +580,379 @@ static void nexus__ensure_capacity(NexusAllocLine *site)
     }
 }
 
-static void nexus__site_add(const char *file, unsigned line, void *ptr, size_t size)
+/* Caller holds sh->lock. */
+static void nexus__site_add(NexusMemShard *sh, const char *file, unsigned line, nexus_u32 stack,
+                            void *ptr, size_t size, size_t weight, unsigned front, unsigned pages)
 {
-    unsigned i, j;
+    NexusAllocHeader *h = nexus__header(ptr);
+    NexusAllocLine   *s;
+    unsigned i;
 
+    h->size  = size;
+    h->front = front;
+    h->pages = pages;
     /* Tail-guard the allocation with the magic byte. */
-    for (i = 0; i < NEXUS_MEMORY_OVER_ALLOC; ++i) {
-        ((nexus_u8*)ptr)[size + i] = (nexus_u8)NEXUS_MEMORY_MAGIC_NUMBER;
-    }
-
-    i = nexus__find_site(file, line);
-    if (i < g_line_count) {
-        NexusAllocLine *s = &g_lines[i];
-        nexus__ensure_capacity(s);
-        s->allocs[s->alloc_count].size = size;
-        s->allocs[s->alloc_count].buf  = ptr;
-        s->alloc_count += 1;
-        s->bytes_live  += size;
-        s->alloc_total += 1;
-        return;
+    memset((nexus_u8*)ptr + size, NEXUS_MEMORY_MAGIC_NUMBER, nexus__tail_guard(h));
+
+    i = nexus__find_site(sh, file, line, stack);
+    s = &sh->lines[i];
+    nexus__ensure_capacity(s);
+    s->allocs[s->alloc_count].size = size;
+    s->allocs[s->alloc_count].buf  = ptr;
+    h->next  = NULL;
+    h->weight = weight;
+    h->shard = (unsigned)(sh - g_shards);
+    h->site  = i;
+    h->slot  = s->alloc_count;
+    h->magic = NEXUS_MEMORY_HEADER_MAGIC;
+    s->alloc_count += 1u;
+    s->bytes_live  += size;
+    s->alloc_total += 1u;
+    s->est_bytes_live  += weight;
+    s->est_alloc_total += nexus__weight_count(weight, size);
+}
+
+/* Offset of the first of n bytes that is not `byte`, or n if all are.
+   Blocks start at arbitrary offsets, so words are loaded with memcpy (a
+   plain unaligned load on the targets we build for). */
+static size_t nexus__pattern_find(const nexus_u8 *p, size_t n, nexus_u8 byte)
+{
+    size_t pattern = ((size_t)-1 / 0xFFu) * byte, w, k;
+
+    for (k = 0; k + sizeof w <= n; k += sizeof w) {
+        memcpy(&w, p + k, sizeof w);
+        if (w != pattern) break;
+    }
+    while (k < n && p[k] == byte) ++k;
+    return k;
+}
+
+/* Nonzero if any of the n guard bytes was overwritten. */
+static NEXUS_BOOL nexus__guard_diff(const nexus_u8 *guard, size_t n)
+{
+    return nexus__pattern_find(guard, n, (nexus_u8)NEXUS_MEMORY_MAGIC_NUMBER) != n;
+}
+
+/* Report overwritten guards; returns NEXUS_TRUE if intact. Aligned blocks
+   also have a front guard ahead of the header; paged blocks only have the
+   slack in front of their protected page to look at. */
+static NEXUS_BOOL nexus__check_guard(const NexusAllocLine *s, const NexusAllocBuf *b)
+{
+    const nexus_u8 *p = (const nexus_u8*)b->buf;
+    const NexusAllocHeader *h = nexus__header(b->buf);
+    NEXUS_BOOL ok = NEXUS_TRUE;
+
+    if (nexus__guard_diff(p + b->size, nexus__tail_guard(h))) {
+        fprintf(stderr, "MEM ERROR: Overshoot at line %u in file %s\n", s->line, s->file);
+        ok = NEXUS_FALSE;
     }
+    if (nexus__is_aligned(h)
+        && nexus__guard_diff(p - h->front, h->front - NEXUS_MEMORY_HEADER_SIZE)) {
+        fprintf(stderr, "MEM ERROR: Undershoot at line %u in file %s\n", s->line, s->file);
+        ok = NEXUS_FALSE;
+    }
+    return ok;
+}
+
+/* Release quarantined blocks, reporting any written after their free.
+   Call without holding locks: a report takes the owning shard's lock to
+   name the site. */
+static void nexus__quarantine_release(NexusAllocHeader *h)
+{
+    while (h) {
+        NexusAllocHeader *next = h->next;
+        void  *ptr = h + 1;
+        size_t at  = nexus__pattern_find((const nexus_u8*)ptr, h->size, (nexus_u8)NEXUS_MEMORY_FREED_BYTE);
+
+        if (at != h->size || h->magic != NEXUS_MEMORY_HEADER_FREED) {
+            NexusMemShard *sh = &g_shards[h->shard % NEXUS_MEMORY_SHARDS];
+            nexus__atomic_add_size(&g_quarantine_errors, 1u);
+            nexus__spin_lock(&sh->lock);
+            if (h->site < sh->line_count) {
+                fprintf(stderr, "MEM ERROR: write after free at offset %lu of a %lu-byte block from %s:%u\n",
+                        (unsigned long)at, (unsigned long)h->size,
+                        sh->lines[h->site].file, sh->lines[h->site].line);
+                nexus__stack_print(stderr, sh->lines[h->site].stack, "    ");
+            } else {
+                fprintf(stderr, "MEM ERROR: write after free at offset %lu of a %lu-byte block\n",
+                        (unsigned long)at, (unsigned long)h->size);
+            }
+            nexus__spin_unlock(&sh->lock);
+        }
+        h->magic = 0u;
+        nexus__release(ptr);
+        h = next;
+    }
+}
 
-    /* New site */
-    if (g_line_count < (sizeof g_lines / sizeof g_lines[0])) {
-        NexusAllocLine *s = &g_lines[g_line_count];
-        s->line = line;
-        for (j = 0; j < 255 && file[j] != '\0'; ++j) s->file[j] = file[j];
-        s->file[j] = '\0';
-        s->allocs = NULL;
-        s->alloc_count = 0u;
-        s->alloc_capacity = 0u;
-        s->bytes_live = 0u;
-        s->alloc_total = 0u;
-        s->free_total  = 0u;
-
-        nexus__ensure_capacity(s);
-        s->allocs[0].size = size;
-        s->allocs[0].buf  = ptr;
-        s->alloc_count = 1u;
-        s->bytes_live  = size;
-        s->alloc_total = 1u;
-
-        g_line_count += 1u;
-    }
-}
-
-/* Remove a tracked allocation; returns NEXUS_TRUE if found, sets *out_size. */
-static NEXUS_BOOL nexus__site_remove(void *ptr, size_t *out_size)
-{
-    unsigned i, j, k;
-    for (i = 0; i < g_line_count; ++i) {
-        NexusAllocLine *s = &g_lines[i];
-        for (j = 0; j < s->alloc_count; ++j) {
-            if (s->allocs[j].buf == ptr) {
-                /* Check guard band */
-                for (k = 0; k < NEXUS_MEMORY_OVER_ALLOC; ++k) {
-                    if (((nexus_u8*)ptr)[s->allocs[j].size + k] != (nexus_u8)NEXUS_MEMORY_MAGIC_NUMBER) {
-                        fprintf(stderr, "MEM ERROR: Overshoot at line %u in file %s\n",
-                                s->line, s->file);
-                        break;
-                    }
+/* Poison a block that has left the tables and stage it on its shard.
+   Returns NEXUS_FALSE, leaving the block alone, when the quarantine is off
+   or the block would take more than a quarter of it. Caller holds sh->lock. */
+static NEXUS_BOOL nexus__quarantine_stage(NexusMemShard *sh, void *ptr)
+{
+    NexusAllocHeader *h = nexus__header(ptr);
+    size_t max = g_quarantine_max;
+
+    if (!max || h->size > max / 4u) return NEXUS_FALSE;
+    memset(ptr, NEXUS_MEMORY_FREED_BYTE, h->size);
+    h->magic = NEXUS_MEMORY_HEADER_FREED;
+    h->next  = NULL;
+    if (sh->staged.tail) sh->staged.tail->next = h;
+    else sh->staged.head = h;
+    sh->staged.tail   = h;
+    sh->staged.bytes += h->size;
+    sh->staged.count += 1u;
+    return NEXUS_TRUE;
+}
+
+/* Detach sh's staged frees once a batch is full (always when `all`).
+   Caller holds sh->lock; hand the result to nexus__quarantine_publish. */
+static NexusQuarantine nexus__quarantine_take(NexusMemShard *sh, NEXUS_BOOL all)
+{
+    NexusQuarantine batch;
+
+    memset(&batch, 0, sizeof batch);
+    if (all || sh->staged.count >= NEXUS_MEMORY_QUARANTINE_BATCH
+        || sh->staged.bytes >= g_quarantine_max / 8u) {
+        batch = sh->staged;
+        memset(&sh->staged, 0, sizeof sh->staged);
+    }
+    return batch;
+}
+
+/* Append a batch to the FIFO, then evict the oldest blocks down to the
+   budget. Call without holding locks. */
+static void nexus__quarantine_publish(NexusQuarantine batch)
+{
+    NexusAllocHeader *evict = NULL, *last = NULL;
+
+    nexus__spin_lock(&g_quarantine_lock);
+    if (batch.head) {
+        if (g_quarantine.tail) g_quarantine.tail->next = batch.head;
+        else g_quarantine.head = batch.head;
+        g_quarantine.tail   = batch.tail;
+        g_quarantine.bytes += batch.bytes;
+        g_quarantine.count += batch.count;
+    }
+    while (g_quarantine.head && g_quarantine.bytes > g_quarantine_max) {
+        NexusAllocHeader *h = g_quarantine.head;
+        g_quarantine.head   = h->next;
+        g_quarantine.bytes -= h->size;
+        g_quarantine.count -= 1u;
+        h->next = NULL;
+        if (last) last->next = h; else evict = h;
+        last = h;
+    }
+    if (!g_quarantine.head) g_quarantine.tail = NULL;
+    nexus__spin_unlock(&g_quarantine_lock);
+
+    nexus__quarantine_release(evict);
+}
+
+/* Drop entry b of site s from the tables and count it as freed. Removes by
+   swap-with-last, re-pointing the moved entry's header. Caller holds the
+   shard lock. */
+static void nexus__site_unlink(NexusAllocLine *s, NexusAllocBuf *b)
+{
+    NexusAllocHeader *h = nexus__header(b->buf);
+    unsigned j = (unsigned)(b - s->allocs);
+
+    s->bytes_live -= b->size;
+    s->free_total += 1u;
+    s->est_bytes_live -= h->weight;
+    s->est_free_total += nexus__weight_count(h->weight, h->size);
+    s->alloc_count -= 1u;
+    s->allocs[j] = s->allocs[s->alloc_count];
+    if (j < s->alloc_count) nexus__header(s->allocs[j].buf)->slot = j;
+    h->magic = 0u;
+}
+
+/* Remove a tracked allocation; returns NEXUS_TRUE if found, sets *out_size.
+   Caller holds sh->lock. */
+static NEXUS_BOOL nexus__site_remove(NexusMemShard *sh, void *ptr, size_t magic, size_t *out_size)
+{
+    NexusAllocLine *s = NULL;
+    NexusAllocBuf  *b = nexus__lookup(sh, ptr, magic, &s);
+
+    if (!b) return NEXUS_FALSE;
+    nexus__check_guard(s, b);
+    if (out_size) *out_size = b->size;
+    nexus__site_unlink(s, b);
+    return NEXUS_TRUE;
+}
+
+/* Hand a block to its owning shard (any thread, no lock). */
+static void nexus__shard_push_remote(NexusMemShard *sh, NexusAllocHeader *h)
+{
+    void *head;
+    do {
+        head = nexus__atomic_load_ptr(&sh->remote);
+        h->next = (NexusAllocHeader*)head;
+    } while (!nexus__atomic_cas_ptr(&sh->remote, head, h));
+}
+
+/* Release blocks other threads freed on sh's behalf. Caller holds sh->lock.
+   The owner takes the whole chain at once, so pushes never see ABA. */
+static void nexus__shard_drain(NexusMemShard *sh)
+{
+    NexusAllocHeader *h;
+
+    if (!nexus__atomic_load_ptr(&sh->remote)) return;
+    h = (NexusAllocHeader*)nexus__atomic_xchg_ptr(&sh->remote, NULL);
+    while (h) {
+        NexusAllocHeader *next = h->next;
+        void *ptr = h + 1;
+        if (nexus__site_remove(sh, ptr, NEXUS_MEMORY_HEADER_REMOTE, NULL)) {
+            if (!nexus__quarantine_stage(sh, ptr)) nexus__release(ptr);
+        } else {
+            fprintf(stderr, "MEM ERROR: corrupt header on cross-thread free of %p\n", ptr);
+        }
+        h = next;
+    }
+}
+
+/* Diagnostics for a pointer that is not the start of a tracked allocation.
+   Takes each shard lock in turn; call without holding any. */
+static void nexus__report_untracked(void *ptr)
+{
+    unsigned i_shard, i_site, j_ent;
+    const nexus_u8 *p = (const nexus_u8*)ptr;
+
+    /* Attempt to locate pointer inside a known allocation */
+    for (i_shard = 0; i_shard < NEXUS_MEMORY_SHARDS; ++i_shard) {
+        NexusMemShard *sh = &g_shards[i_shard];
+        nexus__spin_lock(&sh->lock);
+        for (i_site = 0; i_site < sh->line_count; ++i_site) {
+            const NexusAllocLine *s = &sh->lines[i_site];
+            for (j_ent = 0; j_ent < s->alloc_count; ++j_ent) {
+                const nexus_u8 *b = s->allocs[j_ent].buf;
+                if (p > b && p < b + s->allocs[j_ent].size) {
+                    fprintf(stderr,
+                            "Note: pointer is %lu bytes into an allocation from %s:%u\n",
+                            (unsigned long)(p - b), s->file, s->line);
+                    nexus__spin_unlock(&sh->lock);
+                    return;
+                }
+            }
+        }
+        nexus__spin_unlock(&sh->lock);
+    }
+}
+
+static int nexus__site_stat_cmp(const void *a, const void *b)
+{
+    const NexusSiteStat *x = (const NexusSiteStat*)a;
+    const NexusSiteStat *y = (const NexusSiteStat*)b;
+    int c = strcmp(x->file, y->file);
+    if (c) return c;
+    if (x->line != y->line) return (x->line > y->line) - (x->line < y->line);
+    return (x->stack > y->stack) - (x->stack < y->stack);
+}
+
+/* Merge per-site stats from every shard into *out (caller frees) and set
+   *out_count to the number of distinct sites. Sites differing only in call
+   stack stay apart when `by_stack`, else fold into one with stack 0. With
+   `allocs` non-NULL, also copies every live allocation, its site index
+   referring to *out. Returns NEXUS_FALSE on out-of-memory, with nothing
+   to free. */
+static NEXUS_BOOL nexus__collect_sites(NexusSiteStat **out, unsigned *out_count, NEXUS_BOOL by_stack,
+                                       nexus_mem_snapshot_alloc **allocs, size_t *alloc_count)
+{
+    NexusSiteStat *all = NULL;
+    nexus_mem_snapshot_alloc *live = NULL;
+    unsigned *remap = NULL;
+    size_t live_count = 0u, live_cap = 0u;
+    unsigned count = 0u, cap = 0u, i, j, k, n;
+
+    for (i = 0; i < NEXUS_MEMORY_SHARDS; ++i) {
+        NexusMemShard *sh = &g_shards[i];
+        nexus__spin_lock(&sh->lock);
+        nexus__shard_drain(sh);
+        if (count + sh->line_count > cap) {
+            NexusSiteStat *p;
+            cap = (count + sh->line_count) * 2u;
+            p = realloc(all, (size_t)cap * sizeof *p);
+            if (!p) goto oom_locked;
+            all = p;
+        }
+        if (allocs) {
+            size_t need = live_count;
+            for (j = 0; j < sh->line_count; ++j) need += sh->lines[j].alloc_count;
+            if (need > live_cap) {
+                nexus_mem_snapshot_alloc *p;
+                live_cap = need * 2u;
+                p = realloc(live, live_cap * sizeof *p);
+                if (!p) goto oom_locked;
+                live = p;
+            }
+        }
+        for (j = 0; j < sh->line_count; ++j) {
+            if (allocs) {
+                const NexusAllocLine *s = &sh->lines[j];
+                for (k = 0; k < s->alloc_count; ++k, ++live_count) {
+                    live[live_count].address = (nexus_u64)(size_t)s->allocs[k].buf;
+                    live[live_count].size    = s->allocs[k].size;
+                    live[live_count].site    = count;
                 }
-                if (out_size) *out_size = s->allocs[j].size;
-
-                /* Remove by swap-with-last */
-                s->bytes_live -= s->allocs[j].size;
-                s->free_total += 1u;
-                s->alloc_count -= 1u;
-                s->allocs[j] = s->allocs[s->alloc_count];
-                return NEXUS_TRUE;
             }
+            all[count].file        = sh->lines[j].file;
+            all[count].line        = sh->lines[j].line;
+            all[count].stack       = by_stack ? sh->lines[j].stack : 0u;
+            all[count].origin      = count;
+            all[count].live_count  = sh->lines[j].alloc_count;
+            all[count].bytes_live  = sh->lines[j].bytes_live;
+            all[count].alloc_total = sh->lines[j].alloc_total;
+            all[count].free_total  = sh->lines[j].free_total;
+            all[count].est_bytes_live  = sh->lines[j].est_bytes_live;
+            all[count].est_alloc_total = sh->lines[j].est_alloc_total;
+            all[count].est_free_total  = sh->lines[j].est_free_total;
+            count += 1u;
         }
+        nexus__spin_unlock(&sh->lock);
     }
+
+    if (count) qsort(all, count, sizeof *all, nexus__site_stat_cmp);
+    if (allocs && count) {
+        remap = (unsigned*)malloc((size_t)count * sizeof *remap);
+        if (!remap) goto oom;
+    }
+
+    /* Fold shards' copies of the same site together. */
+    for (i = 0, n = 0; i < count; ++i) {
+        if (n && all[n - 1u].file == all[i].file && all[n - 1u].line == all[i].line
+            && all[n - 1u].stack == all[i].stack) {
+            if (remap) remap[all[i].origin] = n - 1u;
+            all[n - 1u].live_count  += all[i].live_count;
+            all[n - 1u].bytes_live  += all[i].bytes_live;
+            all[n - 1u].alloc_total += all[i].alloc_total;
+            all[n - 1u].free_total  += all[i].free_total;
+            all[n - 1u].est_bytes_live  += all[i].est_bytes_live;
+            all[n - 1u].est_alloc_total += all[i].est_alloc_total;
+            all[n - 1u].est_free_total  += all[i].est_free_total;
+        } else {
+            if (remap) remap[all[i].origin] = n;
+            all[n++] = all[i];
+        }
+    }
+
+    if (allocs) {
+        size_t a;
+        for (a = 0; a < live_count; ++a) live[a].site = remap[live[a].site];
+        free(remap);
+        *allocs = live;
+        *alloc_count = live_count;
+    }
+    *out = all;
+    *out_count = n;
+    return NEXUS_TRUE;
+
+oom_locked:
+    nexus__spin_unlock(&g_shards[i].lock);
+oom:
+    free(all);
+    free(live);
+    *out = NULL;
+    *out_count = 0u;
     return NEXUS_FALSE;
 }
 
@@ -186,167 +972,594 @@ void nexus_debug_memory_init(void (*lock)(void *mutex),
 NEXUS_BOOL nexus_debug_memory(void)
 {
     NEXUS_BOOL any_error = NEXUS_FALSE;
-    unsigned i, j, k;
+    unsigned i, j, n;
 
-    nexus__lock();
-    for (i = 0; i < g_line_count; ++i) {
-        const NexusAllocLine *s = &g_lines[i];
-        for (j = 0; j < s->alloc_count; ++j) {
-            const nexus_u8 *buf  = s->allocs[j].buf;
-            size_t          size = s->allocs[j].size;
-            for (k = 0; k < NEXUS_MEMORY_OVER_ALLOC; ++k) {
-                if (buf[size + k] != (nexus_u8)NEXUS_MEMORY_MAGIC_NUMBER) {
-                    fprintf(stderr, "MEM ERROR: Overshoot at line %u in file %s\n",
-                            s->line, s->file);
-                    any_error = NEXUS_TRUE;
-                    break;
-                }
+    for (n = 0; n < NEXUS_MEMORY_SHARDS; ++n) {
+        NexusMemShard *sh = &g_shards[n];
+        nexus__spin_lock(&sh->lock);
+        nexus__shard_drain(sh);
+        for (i = 0; i < sh->line_count; ++i) {
+            const NexusAllocLine *s = &sh->lines[i];
+            for (j = 0; j < s->alloc_count; ++j) {
+                if (!nexus__check_guard(s, &s->allocs[j])) any_error = NEXUS_TRUE;
             }
         }
+        nexus__spin_unlock(&sh->lock);
     }
-    nexus__unlock();
     return any_error;
 }
 
+NEXUS_BOOL nexus_debug_memory_step(unsigned budget)
+{
+    NEXUS_BOOL any_error = NEXUS_FALSE;
+    unsigned shards_left = NEXUS_MEMORY_SHARDS + 1u;   /* at most one full lap */
+
+    nexus__spin_lock(&g_check_lock);
+    while (budget && shards_left--) {
+        NexusMemShard *sh = &g_shards[g_check_shard];
+        nexus__spin_lock(&sh->lock);
+        nexus__shard_drain(sh);
+        /* Frees since the last call may have swapped entries behind the
+           cursor; those are picked up on the next lap. */
+        while (budget && g_check_site < sh->line_count) {
+            const NexusAllocLine *s = &sh->lines[g_check_site];
+            for (; budget && g_check_slot < s->alloc_count; ++g_check_slot, --budget) {
+                if (!nexus__check_guard(s, &s->allocs[g_check_slot])) any_error = NEXUS_TRUE;
+            }
+            if (g_check_slot >= s->alloc_count) {
+                g_check_site += 1u;
+                g_check_slot  = 0u;
+            }
+        }
+        if (g_check_site >= sh->line_count) {
+            g_check_shard = (g_check_shard + 1u) % NEXUS_MEMORY_SHARDS;
+            g_check_site  = g_check_slot = 0u;
+        }
+        nexus__spin_unlock(&sh->lock);
+    }
+    nexus__spin_unlock(&g_check_lock);
+    return any_error;
+}
+
+static void nexus__checker_loop(void)
+{
+    while (nexus__atomic_load_u32(&g_checker_run)) {
+        if (nexus_debug_memory_step(g_checker_budget)) nexus__atomic_store_u32(&g_checker_errors, 1u);
+#if defined(_WIN32)
+        Sleep(g_checker_interval_ms);
+#else
+        {
+            struct timespec ts;
+            ts.tv_sec  = (time_t)(g_checker_interval_ms / 1000u);
+            ts.tv_nsec = (long)(g_checker_interval_ms % 1000u) * 1000000L;
+            nanosleep(&ts, NULL);
+        }
+#endif
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI nexus__checker_main(LPVOID arg) { (void)arg; nexus__checker_loop(); return 0; }
+#else
+static void *nexus__checker_main(void *arg) { (void)arg; nexus__checker_loop(); return NULL; }
+#endif
+
+NEXUS_BOOL nexus_debug_memory_checker_start(unsigned interval_ms, unsigned budget)
+{
+    if (nexus__atomic_load_u32(&g_checker_run)) return NEXUS_FALSE;
+    g_checker_interval_ms = interval_ms;
+    g_checker_budget      = budget ? budget : 1u;
+    nexus__atomic_store_u32(&g_checker_errors, 0u);
+    nexus__atomic_store_u32(&g_checker_run, 1u);
+#if defined(_WIN32)
+    g_checker_thread = CreateThread(NULL, 0, nexus__checker_main, NULL, 0, NULL);
+    if (!g_checker_thread) {
+#else
+    if (pthread_create(&g_checker_thread, NULL, nexus__checker_main, NULL) != 0) {
+#endif
+        nexus__atomic_store_u32(&g_checker_run, 0u);
+        return NEXUS_FALSE;
+    }
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_debug_memory_checker_stop(void)
+{
+    if (!nexus__atomic_xchg_u32(&g_checker_run, 0u)) return NEXUS_FALSE;
+#if defined(_WIN32)
+    WaitForSingleObject(g_checker_thread, INFINITE);
+    CloseHandle(g_checker_thread);
+    g_checker_thread = NULL;
+#else
+    pthread_join(g_checker_thread, NULL);
+#endif
+    return nexus__atomic_load_u32(&g_checker_errors) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+void nexus_debug_mem_set_sample_rate(size_t bytes_per_sample)
+{
+    g_sample_rate = bytes_per_sample;
+}
+
+void nexus_debug_mem_set_stack_depth(unsigned frames)
+{
+    g_stack_depth = frames < NEXUS_STACK_MAX_FRAMES ? frames : NEXUS_STACK_MAX_FRAMES;
+}
+
+size_t nexus_debug_mem_quarantine_errors(void)
+{
+    return nexus__atomic_load_size(&g_quarantine_errors);
+}
+
+void nexus_debug_mem_set_quarantine(size_t max_bytes)
+{
+    NexusQuarantine batch;
+    unsigned n;
+
+    g_quarantine_max = max_bytes;
+    for (n = 0; n < NEXUS_MEMORY_SHARDS; ++n) {
+        NexusMemShard *sh = &g_shards[n];
+        nexus__spin_lock(&sh->lock);
+        batch = nexus__quarantine_take(sh, NEXUS_TRUE);
+        nexus__spin_unlock(&sh->lock);
+        nexus__quarantine_publish(batch);
+    }
+}
+
+void nexus_debug_mem_set_page_guard(size_t min_size, size_t max_bytes)
+{
+    g_page_budget = max_bytes;
+    g_page_min    = min_size;
+}
+
+static void nexus__debug_free(void *ptr, NEXUS_BOOL aligned);
+
+static void *nexus__debug_malloc(size_t size, const char *file, unsigned line)
+{
+    NexusMemShard *sh;
+    nexus_u32 stack;
+    size_t weight;
+    unsigned front = NEXUS_MEMORY_HEADER_SIZE, pages = 0u;
+    void *raw, *p;
+
+    /* Page-guarded blocks are always tracked (the guard page is the point),
+       so each stands for itself only rather than for a sampled interval. */
+    p = nexus__page_alloc(size, &front, &pages);
+    if (p) {
+        stack = nexus__site_stack();
+        memset(p, NEXUS_MEMORY_MAGIC_NUMBER + 1, size);
+        sh = nexus__shard();
+        nexus__spin_lock(&sh->lock);
+        nexus__shard_drain(sh);
+        nexus__site_add(sh, file, line, stack, p, size, size ? size : 1u, front, pages);
+        nexus__spin_unlock(&sh->lock);
+        return p;
+    }
+
+    weight = nexus__sample(size);
+    if (!weight) {
+        /* Not sampled: plain malloc plus a tag so free/realloc know its shape. */
+        raw = malloc(NEXUS_MEMORY_TAG_SIZE + size);
+        if (raw) {
+            p = (nexus_u8*)raw + NEXUS_MEMORY_TAG_SIZE;
+            nexus__tag(p)->size  = size;
+            nexus__tag(p)->magic = nexus__tag_magic(p);
+            return p;
+        }
+    } else {
+        raw = malloc(NEXUS_MEMORY_RAW_SIZE(size));
+    }
+    if (!raw) nexus__out_of_memory("malloc", size, file, line);
+
+    /* Fill the payload with (MAGIC+1); add() stamps the tail guard with MAGIC. */
+    p = nexus__payload(raw);
+    memset(p, NEXUS_MEMORY_MAGIC_NUMBER + 1, size);
+    stack = nexus__site_stack();
+
+    sh = nexus__shard();
+    nexus__spin_lock(&sh->lock);
+    nexus__shard_drain(sh);
+    nexus__site_add(sh, file, line, stack, p, size, weight, front, pages);
+    nexus__spin_unlock(&sh->lock);
+    return p;
+}
+
 void *nexus_debug_mem_malloc(size_t size, const char *file, unsigned line)
 {
-    size_t i;
-    void *p;
+    void *p = nexus__debug_malloc(size, file, line);
+    if (nexus__atomic_load_u32(&nexus__profile_active)) nexus__profile_alloc(p, size, file, line);
+    return p;
+}
 
-    nexus__lock();
+void *nexus_debug_mem_malloc_aligned(size_t size, size_t align, const char *file, unsigned line)
+{
+    NexusMemShard *sh;
+    nexus_u8 *raw, *p;
+    nexus_u32 stack;
+    size_t extra;
+    unsigned front;
 
-    p = malloc(size + NEXUS_MEMORY_OVER_ALLOC);
-    if (!p) {
-        fprintf(stderr, "MEM ERROR: malloc returned NULL for %lu bytes at %s:%u\n",
-                (unsigned long)size, file, line);
-        nexus__unlock();
-        nexus_debug_mem_print(0u);
+    if (!align || (align & (align - 1u))) {
+        fprintf(stderr, "MEM ERROR: alignment %lu is not a power of two at %s:%u\n",
+                (unsigned long)align, file, line);
         exit(1);
     }
+    if (align < NEXUS_MEMORY_ALIGN) align = NEXUS_MEMORY_ALIGN;
 
-    /* Fill whole region with (MAGIC+1), we’ll set the tail guards to MAGIC in add() */
-    for (i = 0; i < size + NEXUS_MEMORY_OVER_ALLOC; ++i)
-        ((nexus_u8*)p)[i] = (nexus_u8)(NEXUS_MEMORY_MAGIC_NUMBER + 1);
+    /* Always tracked: front guard, header, padding up to the boundary, payload, tail guard. */
+    extra = NEXUS_MEMORY_OVER_ALLOC + NEXUS_MEMORY_HEADER_SIZE + (align - 1u);
+    raw = size <= (size_t)-1 - extra - NEXUS_MEMORY_OVER_ALLOC
+        ? (nexus_u8*)malloc(extra + size + NEXUS_MEMORY_OVER_ALLOC) : NULL;
+    if (!raw) nexus__out_of_memory("malloc", size, file, line);
 
-    nexus__site_add(file, line, p, size);
-    nexus__unlock();
+    p = (nexus_u8*)(((size_t)raw + NEXUS_MEMORY_OVER_ALLOC + NEXUS_MEMORY_HEADER_SIZE + align - 1u)
+                    & ~(align - 1u));
+    front = (unsigned)(p - raw);
+    memset(raw, NEXUS_MEMORY_MAGIC_NUMBER, front - NEXUS_MEMORY_HEADER_SIZE);
+    memset(p, NEXUS_MEMORY_MAGIC_NUMBER + 1, size);
+    stack = nexus__site_stack();
+
+    sh = nexus__shard();
+    nexus__spin_lock(&sh->lock);
+    nexus__shard_drain(sh);
+    /* Tracked without going through the sampler, so it stands for itself only. */
+    nexus__site_add(sh, file, line, stack, p, size, size ? size : 1u, front, 0u);
+    nexus__spin_unlock(&sh->lock);
+    if (nexus__atomic_load_u32(&nexus__profile_active)) nexus__profile_alloc(p, size, file, line);
     return p;
 }
 
-void *nexus_debug_mem_realloc(void *ptr, size_t size, const char *file, unsigned line)
+static void *nexus__debug_realloc(void *ptr, size_t size, const char *file, unsigned line)
 {
-    size_t old_sz = 0u, move, i;
-    void *p2;
+    NexusMemShard    *sh;
+    NexusAllocHeader *h;
+    NexusAllocLine   *s = NULL;
+    NexusAllocBuf    *b;
+    nexus_u32 stack;
+    size_t old_sz = 0u, old_weight = 0u, weight;
+    void *raw, *p2;
 
     if (!ptr) {
-        return nexus_debug_mem_malloc(size, file, line);
+        return nexus__debug_malloc(size, file, line);
     }
 
-    nexus__lock();
+    /* Unsampled blocks stay unsampled; the CRT resizes them in place when it can. */
+    if (nexus__tag(ptr)->magic == nexus__tag_magic(ptr)) {
+        raw = realloc((nexus_u8*)ptr - NEXUS_MEMORY_TAG_SIZE, NEXUS_MEMORY_TAG_SIZE + size);
+        if (!raw) nexus__out_of_memory("realloc", size, file, line);
+        p2 = (nexus_u8*)raw + NEXUS_MEMORY_TAG_SIZE;
+        nexus__tag(p2)->size  = size;
+        nexus__tag(p2)->magic = nexus__tag_magic(p2);
+        return p2;
+    }
 
-    if (!nexus__site_remove(ptr, &old_sz)) {
-        unsigned i_site, j_ent, k_off;
-        fprintf(stderr, "MEM ERROR: realloc on untracked pointer %p at %s:%u\n", ptr, file, line);
-        /* Attempt to locate pointer inside a known allocation for diagnostics */
-        for (i_site = 0; i_site < g_line_count; ++i_site) {
-            NexusAllocLine *s = &g_lines[i_site];
-            for (j_ent = 0; j_ent < s->alloc_count; ++j_ent) {
-                nexus_u8 *b = s->allocs[j_ent].buf;
-                for (k_off = 0; k_off < s->allocs[j_ent].size; ++k_off) {
-                    if ((void*)(b + k_off) == ptr) {
-                        fprintf(stderr,
-                                "Note: pointer is %u bytes into an allocation from %s:%u\n",
-                                k_off, s->file, s->line);
-                        break;
-                    }
-                }
-            }
-        }
-        nexus__unlock();
+    sh = nexus__shard();
+    h  = nexus__header(ptr);
+
+    if (h->magic == NEXUS_MEMORY_HEADER_MAGIC && nexus__is_aligned(h)) {
+        /* The CRT cannot keep the alignment, and neither could a release build. */
+        fprintf(stderr, "MEM ERROR: realloc on aligned allocation %p at %s:%u\n", ptr, file, line);
         exit(1);
     }
+    if (h->magic == NEXUS_MEMORY_HEADER_MAGIC && h->shard < NEXUS_MEMORY_SHARDS
+        && (&g_shards[h->shard] != sh || h->pages
+            || (g_quarantine_max && h->size <= g_quarantine_max / 4u))) {
+        /* Another shard owns the entry, the block is page-guarded, or the
+           quarantine would hold it: move the data into a fresh block (which
+           gets a guard page again if it qualifies) and release the old one
+           through the normal free path, which quarantines it so writes
+           through stale pointers are reported like any use after free. */
+        old_sz = h->size;
+        p2 = nexus__debug_malloc(size, file, line);
+        memcpy(p2, ptr, (old_sz < size) ? old_sz : size);
+        nexus__debug_free(ptr, NEXUS_FALSE);
+        return p2;
+    }
 
-    move = (old_sz < size) ? old_sz : size;
+    nexus__spin_lock(&sh->lock);
+    nexus__shard_drain(sh);
+    b = nexus__lookup(sh, ptr, NEXUS_MEMORY_HEADER_MAGIC, &s);
+    if (b) {
+        old_sz = b->size;
+        old_weight = h->weight;
+        nexus__check_guard(s, b);
+        nexus__site_unlink(s, b);
+    }
+    nexus__spin_unlock(&sh->lock);
 
-    p2 = malloc(size + NEXUS_MEMORY_OVER_ALLOC);
-    if (!p2) {
-        fprintf(stderr, "MEM ERROR: realloc malloc failed for %lu bytes at %s:%u\n",
-                (unsigned long)size, file, line);
-        nexus__unlock();
-        nexus_debug_mem_print(0u);
+    if (!b) {
+        fprintf(stderr, "MEM ERROR: realloc on untracked pointer %p at %s:%u\n", ptr, file, line);
+        nexus__report_untracked(ptr);
         exit(1);
     }
-    for (i = 0; i < size + NEXUS_MEMORY_OVER_ALLOC; ++i)
-        ((nexus_u8*)p2)[i] = (nexus_u8)(NEXUS_MEMORY_MAGIC_NUMBER + 1);
 
-    memcpy(p2, ptr, move);
-    nexus__site_add(file, line, p2, size);
-    free(ptr);
+    /* Resize outside the lock, in place when the CRT can. Only bytes that
+       become visible get the fill pattern; site_add moves the guard to the
+       new end and files the block under the realloc site. */
+    raw = realloc(nexus__raw(ptr), NEXUS_MEMORY_RAW_SIZE(size));
+    if (!raw) nexus__out_of_memory("realloc", size, file, line);
+    p2 = nexus__payload(raw);
+    if (size > old_sz) memset((nexus_u8*)p2 + old_sz, NEXUS_MEMORY_MAGIC_NUMBER + 1, size - old_sz);
+    stack = nexus__site_stack();
+    /* The block was picked (or passed over) at its old size, so it keeps
+       that scale: reweighting at the new size would count only the old
+       bytes of every block that grows. */
+    weight = (size_t)((double)(size ? size : 1u) * (double)old_weight
+                      / (double)(old_sz ? old_sz : 1u));
 
-    nexus__unlock();
+    nexus__spin_lock(&sh->lock);
+    nexus__site_add(sh, file, line, stack, p2, size, weight ? weight : 1u,
+                    NEXUS_MEMORY_HEADER_SIZE, 0u);
+    nexus__spin_unlock(&sh->lock);
     return p2;
 }
 
-void nexus_debug_mem_free(void *ptr)
+/* The profiler sees a resize as the old block going and the new one
+   arriving, even when the CRT grew it in place. */
+void *nexus_debug_mem_realloc(void *ptr, size_t size, const char *file, unsigned line)
 {
-    size_t sz_dummy;
-    nexus__lock();
-    if (!nexus__site_remove(ptr, &sz_dummy)) {
+    NEXUS_BOOL aligned;
+    size_t old_sz;
+    void *p2;
+
+    if (!nexus__atomic_load_u32(&nexus__profile_active)) return nexus__debug_realloc(ptr, size, file, line);
+    old_sz = ptr ? nexus__debug_mem_block(ptr, &aligned) : 0u;
+    p2 = nexus__debug_realloc(ptr, size, file, line);
+    if (ptr) nexus__profile_free(ptr, old_sz);
+    nexus__profile_alloc(p2, size, file, line);
+    return p2;
+}
+
+/* Shared by both frees; `aligned` says which one the caller used. A
+   mismatch is reported (it breaks release builds on Windows) and the block
+   is released correctly anyway. */
+static void nexus__debug_free(void *ptr, NEXUS_BOOL aligned)
+{
+    NexusMemShard    *sh;
+    NexusAllocHeader *h;
+    NexusQuarantine   batch;
+    NEXUS_BOOL        found = NEXUS_FALSE, parked = NEXUS_FALSE;
+
+    if (!ptr) return;
+    if (nexus__tag(ptr)->magic == nexus__tag_magic(ptr)) {
+        if (aligned) fprintf(stderr, "MEM ERROR: aligned free on pointer %p from NEXUS_ALLOC\n", ptr);
+        nexus__tag(ptr)->magic = 0u;
+        free((nexus_u8*)ptr - NEXUS_MEMORY_TAG_SIZE);
+        return;
+    }
+    sh = nexus__shard();
+    h  = nexus__header(ptr);
+
+    if (h->magic == NEXUS_MEMORY_HEADER_MAGIC && nexus__is_aligned(h) != (aligned != NEXUS_FALSE)) {
+        fprintf(stderr, "MEM ERROR: %s on pointer %p from %s\n",
+                aligned ? "aligned free" : "free", ptr,
+                aligned ? "NEXUS_ALLOC" : "NEXUS_ALLOC_ALIGNED");
+    }
+
+    if (h->magic == NEXUS_MEMORY_HEADER_MAGIC && h->shard < NEXUS_MEMORY_SHARDS
+        && &g_shards[h->shard] != sh) {
+        /* Lock-free hand-off; claiming the header also catches racing double frees. */
+        if (nexus__atomic_cas_size(&h->magic, NEXUS_MEMORY_HEADER_MAGIC, NEXUS_MEMORY_HEADER_REMOTE)) {
+            nexus__shard_push_remote(&g_shards[h->shard], h);
+            return;
+        }
+    } else {
+        nexus__spin_lock(&sh->lock);
+        nexus__shard_drain(sh);
+        found = nexus__site_remove(sh, ptr, NEXUS_MEMORY_HEADER_MAGIC, NULL);
+        if (found && nexus__quarantine_stage(sh, ptr)) {
+            parked = NEXUS_TRUE;
+            batch  = nexus__quarantine_take(sh, NEXUS_FALSE);
+        }
+        nexus__spin_unlock(&sh->lock);
+    }
+
+    if (!found) {
         /* Double free or foreign pointer */
-        fprintf(stderr, "MEM ERROR: free on untracked pointer %p\n", ptr);
+        if (h->magic == NEXUS_MEMORY_HEADER_FREED)
+            fprintf(stderr, "MEM ERROR: double free of %p (still in quarantine)\n", ptr);
+        else
+            fprintf(stderr, "MEM ERROR: free on untracked pointer %p\n", ptr);
+        nexus__report_untracked(ptr);
         /* Force a crash to ease debugging, matching original intent */
         { volatile unsigned *X = (unsigned*)0; *X = 0; }
     }
-    free(ptr);
-    nexus__unlock();
+    if (parked) nexus__quarantine_publish(batch);
+    else nexus__release(ptr);
+}
+
+/* Reported before the block goes; its size cannot be read afterwards. */
+static void nexus__debug_profile_free(void *ptr)
+{
+    NEXUS_BOOL aligned;
+    if (ptr && nexus__atomic_load_u32(&nexus__profile_active))
+        nexus__profile_free(ptr, nexus__debug_mem_block(ptr, &aligned));
+}
+
+void nexus_debug_mem_free(void *ptr)
+{
+    nexus__debug_profile_free(ptr);
+    nexus__debug_free(ptr, NEXUS_FALSE);
+}
+
+void nexus_debug_mem_free_aligned(void *ptr)
+{
+    nexus__debug_profile_free(ptr);
+    nexus__debug_free(ptr, NEXUS_TRUE);
 }
 
 void nexus_debug_mem_print(unsigned min_allocs)
 {
-    unsigned i;
+    NexusSiteStat *sites;
+    unsigned count, i;
+    size_t rate = g_sample_rate;
 
-    nexus__lock();
-    printf("Memory report:\n----------------------------------------------\n");
-    for (i = 0; i < g_line_count; ++i) {
-        const NexusAllocLine *s = &g_lines[i];
-        if (s->alloc_total > min_allocs) {
+    if (!nexus__collect_sites(&sites, &count, NEXUS_TRUE, NULL, NULL)) {
+        fprintf(stderr, "MEM ERROR: out of memory while collecting the report\n");
+        return;
+    }
+
+    if (rate) {
+        printf("Memory report (sampling 1 per %lu bytes; figures are estimates):\n",
+               (unsigned long)rate);
+        printf("----------------------------------------------\n");
+    } else {
+        printf("Memory report:\n----------------------------------------------\n");
+    }
+    for (i = 0; i < count; ++i) {
+        const NexusSiteStat *s = &sites[i];
+        if (s->est_alloc_total > min_allocs) {
             printf("%s line: %u\n", s->file, s->line);
-            printf(" - Bytes live: %lu\n - Allocations: %u\n - Frees: %u\n\n",
-                   (unsigned long)s->bytes_live, s->alloc_total, s->free_total);
+            if (s->stack) {
+                printf(" - Stack:\n");
+                nexus__stack_print(stdout, s->stack, "     ");
+            }
+            printf(" - Bytes live: %lu\n - Allocations: %lu\n - Frees: %lu\n",
+                   (unsigned long)s->est_bytes_live, (unsigned long)s->est_alloc_total,
+                   (unsigned long)s->est_free_total);
+            if (rate) {
+                printf(" - Samples: %u allocations, %u frees\n", s->alloc_total, s->free_total);
+            }
+            printf("\n");
         }
     }
     printf("----------------------------------------------\n");
-    nexus__unlock();
+    free(sites);
 }
 
-nexus_u32 nexus_debug_mem_consumption(void)
+nexus_mem_snapshot *nexus_debug_mem_snapshot(void)
 {
-    /* NOTE: Returns 32-bit for legacy compatibility; may truncate on huge heaps. */
-    unsigned i;
+    nexus_mem_snapshot *snap = (nexus_mem_snapshot*)calloc(1u, sizeof *snap);
+    NexusSiteStat *sites;
+    size_t strings = 0u, live_count = 0u, len;
+    unsigned count, i;
+    char *dst = NULL;
+
+    if (!snap) return NULL;
+    snap->timestamp   = (nexus_u64)time(NULL);
+    snap->sample_rate = g_sample_rate;
+    if (!nexus__collect_sites(&sites, &count, NEXUS_FALSE, &snap->allocs, &live_count)) {
+        free(snap);
+        return NULL;
+    }
+    snap->alloc_count = live_count;
+
+    /* Sites are sorted by file and file names are interned, so each distinct
+       name is copied once into the snapshot's own string store. */
+    for (i = 0; i < count; ++i) {
+        if (!i || sites[i].file != sites[i - 1u].file) strings += strlen(sites[i].file) + 1u;
+    }
+    snap->sites   = (nexus_mem_snapshot_site*)malloc((count ? count : 1u) * sizeof *snap->sites);
+    snap->strings = (char*)malloc(strings ? strings : 1u);
+    if (!snap->sites || !snap->strings) {
+        free(sites);
+        nexus_mem_snapshot_free(snap);
+        return NULL;
+    }
+
+    dst = snap->strings;
+    for (i = 0; i < count; ++i) {
+        nexus_mem_snapshot_site *o = &snap->sites[i];
+        if (!i || sites[i].file != sites[i - 1u].file) {
+            len = strlen(sites[i].file) + 1u;
+            memcpy(dst, sites[i].file, len);
+            o->file = dst;
+            dst += len;
+        } else {
+            o->file = snap->sites[i - 1u].file;
+        }
+        o->line            = sites[i].line;
+        o->live_count      = sites[i].live_count;
+        o->bytes_live      = sites[i].bytes_live;
+        o->alloc_total     = sites[i].alloc_total;
+        o->free_total      = sites[i].free_total;
+        o->est_bytes_live  = sites[i].est_bytes_live;
+        o->est_alloc_total = sites[i].est_alloc_total;
+        o->est_free_total  = sites[i].est_free_total;
+    }
+    snap->site_count = count;
+    free(sites);
+    return snap;
+}
+
+size_t nexus_debug_mem_consumption(void)
+{
+    unsigned i, n;
     size_t sum = 0u;
 
-    nexus__lock();
-    for (i = 0; i < g_line_count; ++i) sum += g_lines[i].bytes_live;
-    nexus__unlock();
+    for (n = 0; n < NEXUS_MEMORY_SHARDS; ++n) {
+        NexusMemShard *sh = &g_shards[n];
+        nexus__spin_lock(&sh->lock);
+        nexus__shard_drain(sh);
+        for (i = 0; i < sh->line_count; ++i) sum += sh->lines[i].est_bytes_live;
+        nexus__spin_unlock(&sh->lock);
+    }
 
     return sum;
 }
 
 void nexus_debug_mem_reset(void)
 {
-    unsigned i;
+    unsigned i, n;
+
+    for (n = 0; n < NEXUS_MEMORY_SHARDS; ++n) nexus__spin_lock(&g_shards[n].lock);
     nexus__lock();
-    for (i = 0; i < g_line_count; ++i) {
-        free(g_lines[i].allocs);
-        g_lines[i].allocs = NULL;
-        g_lines[i].alloc_count = 0u;
-        g_lines[i].alloc_capacity = 0u;
-        g_lines[i].bytes_live = 0u;
-        g_lines[i].alloc_total = 0u;
-        g_lines[i].free_total  = 0u;
-    }
-    g_line_count = 0u;
+
+    for (n = 0; n < NEXUS_MEMORY_SHARDS; ++n) {
+        NexusMemShard *sh = &g_shards[n];
+        nexus__shard_drain(sh);
+        for (i = 0; i < sh->line_count; ++i) free(sh->lines[i].allocs);
+        free(sh->lines);
+        free(sh->site_index);
+        sh->lines = NULL;
+        sh->line_count = sh->line_capacity = 0u;
+        sh->site_index = NULL;
+        sh->site_index_cap = sh->site_index_len = 0u;
+    }
+    nexus__unlock();
+    for (n = NEXUS_MEMORY_SHARDS; n-- > 0;) nexus__spin_unlock(&g_shards[n].lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Internal hooks (nexus_memory_debug.h)                               */
+/* ------------------------------------------------------------------ */
+
+size_t nexus__debug_mem_block(void *ptr, NEXUS_BOOL *aligned)
+{
+    const NexusAllocHeader *h;
+
+    *aligned = NEXUS_FALSE;
+    if (nexus__tag(ptr)->magic == nexus__tag_magic(ptr)) return nexus__tag(ptr)->size;
+    h = nexus__header(ptr);
+    if (h->magic != NEXUS_MEMORY_HEADER_MAGIC) return 0u;
+    *aligned = nexus__is_aligned(h);
+    return h->size;
+}
+
+/* Same order as everywhere else: checker cursor, shards, interner, global
+   lock, quarantine. The stack table lock is never held with any of them. */
+void nexus__debug_mem_fork_lock(void)
+{
+    unsigned n;
+
+    nexus__stack_lock();
+    nexus__spin_lock(&g_check_lock);
+    for (n = 0; n < NEXUS_MEMORY_SHARDS; ++n) nexus__spin_lock(&g_shards[n].lock);
+    nexus__intern_lock();
+    nexus__lock();
+    nexus__spin_lock(&g_quarantine_lock);
+}
+
+void nexus__debug_mem_fork_unlock(void)
+{
+    unsigned n;
+
+    nexus__spin_unlock(&g_quarantine_lock);
     nexus__unlock();
+    nexus__intern_unlock();
+    for (n = NEXUS_MEMORY_SHARDS; n-- > 0;) nexus__spin_unlock(&g_shards[n].lock);
+    nexus__spin_unlock(&g_check_lock);
+    nexus__stack_unlock();
 }
 
 #ifdef NEXUS_EXIT_CRASH
@@ -0,0 +1,19 @@
+/* nexus_memory_debug.h — internal debug allocator hooks for the preload library */
+#ifndef NEXUS_MEMORY_DEBUG_H
+#define NEXUS_MEMORY_DEBUG_H
+
+#include <nexus/nexus.h>
+
+/* Requested size of a block from nexus_debug_mem_malloc / _aligned, live
+   or unsampled, and whether it came from the aligned entry point (so it
+   must go back through nexus_debug_mem_free_aligned). 0 with *aligned
+   cleared for anything else. */
+size_t nexus__debug_mem_block(void *ptr, NEXUS_BOOL *aligned);
+
+/* Take every allocator lock before fork() and release them in both the
+   parent and the child afterwards, so the child never inherits a lock
+   held by a thread that no longer exists. */
+void   nexus__debug_mem_fork_lock(void);
+void   nexus__debug_mem_fork_unlock(void);
+
+#endif /* NEXUS_MEMORY_DEBUG_H */
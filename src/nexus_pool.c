@@ -0,0 +1,270 @@
+/* nexus_pool.c — fixed-size object pool with per-thread magazine caches */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* sched_yield() under -std=c90 */
+#endif
+
+#include <string.h>
+#include "nexus/nexus_pool.h"
+#include "nexus_atomic.h"
+
+/* ------------------------------------------------------------------ */
+/* Config                                                              */
+/* ------------------------------------------------------------------ */
+#define NEXUS_POOL_CACHES    64   /* threads map round-robin onto caches */
+#define NEXUS_POOL_MAGAZINE  32   /* objects per thread cache */
+#define NEXUS_POOL_BATCH     (NEXUS_POOL_MAGAZINE / 2)
+#define NEXUS_POOL_SLAB_SIZE (64u * 1024u)
+#define NEXUS_POOL_POISON    0xDD
+
+/* ------------------------------------------------------------------ */
+/* Types                                                               */
+/* ------------------------------------------------------------------ */
+typedef struct NexusPoolSlab {
+    struct NexusPoolSlab *next;
+} NexusPoolSlab;
+
+/* Slab header rounded so the first object keeps 16-byte alignment. */
+#define NEXUS_POOL_SLAB_HEADER (((sizeof(NexusPoolSlab) + 15u) / 16u) * 16u)
+
+typedef struct {
+    NexusSpinLock lock;                 /* uncontended unless threads share a cache */
+    unsigned      count;
+    void         *objs[NEXUS_POOL_MAGAZINE];
+} NexusPoolMagazine;
+
+struct nexus_pool {
+    size_t         obj_size;
+    size_t         stride;              /* obj_size rounded for alignment and the free link */
+    size_t         align;
+    size_t         objs_per_slab;
+    const NexusAllocator *parent;       /* slabs and the pool itself come from it */
+    const char    *file;                /* site slabs are attributed to */
+    unsigned       line;
+
+    /* Shared state, guarded by lock */
+    NexusSpinLock  lock;
+    void          *free_list;           /* intrusive: first word links to the next */
+    nexus_u8      *carve;               /* unused tail of the newest slab */
+    nexus_u8      *carve_end;
+    NexusPoolSlab *slabs;
+
+    NexusPoolMagazine caches[NEXUS_POOL_CACHES];
+};
+
+static NEXUS_THREAD_LOCAL unsigned t_pool_cache = 0u;  /* 1-based; 0 = unassigned */
+static volatile nexus_u32 g_pool_cache_next = 0u;
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static NexusPoolMagazine *nexus__pool_cache(nexus_pool *pool)
+{
+    if (!t_pool_cache)
+        t_pool_cache = nexus__atomic_add_u32(&g_pool_cache_next, 1u) % NEXUS_POOL_CACHES + 1u;
+    return &pool->caches[t_pool_cache - 1u];
+}
+
+static void *nexus__pool_next(void *obj)
+{
+    void *next;
+    memcpy(&next, obj, sizeof next);
+    return next;
+}
+
+static void nexus__pool_link(void *obj, void *next)
+{
+    memcpy(obj, &next, sizeof next);
+}
+
+/* Move up to `want` objects from the shared state into m. Caller holds
+   m->lock. Returns the number moved; 0 means the pool needs a new slab. */
+static unsigned nexus__pool_refill(nexus_pool *pool, NexusPoolMagazine *m, unsigned want)
+{
+    unsigned got = 0u;
+
+    nexus__spin_lock(&pool->lock);
+    while (got < want && pool->free_list) {
+        m->objs[m->count++] = pool->free_list;
+        pool->free_list = nexus__pool_next(pool->free_list);
+        got += 1u;
+    }
+    while (got < want && pool->carve != pool->carve_end) {
+        m->objs[m->count++] = pool->carve;
+        pool->carve += pool->stride;
+        got += 1u;
+    }
+    nexus__spin_unlock(&pool->lock);
+    return got;
+}
+
+/* Allocate a slab with no lock held, then publish it for carving. If
+   another thread published one meanwhile, ours goes back to the parent.
+   NEXUS_FALSE on out-of-memory. */
+static NEXUS_BOOL nexus__pool_grow(nexus_pool *pool)
+{
+    NexusPoolSlab *slab = (NexusPoolSlab*)nexus_allocator_alloc(pool->parent,
+        NEXUS_POOL_SLAB_HEADER + pool->stride * pool->objs_per_slab, pool->file, pool->line);
+
+    if (!slab) return NEXUS_FALSE;
+    nexus__spin_lock(&pool->lock);
+    if (pool->carve == pool->carve_end) {
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->carve = (nexus_u8*)slab + NEXUS_POOL_SLAB_HEADER;
+        pool->carve_end = pool->carve + pool->stride * pool->objs_per_slab;
+        slab = NULL;
+    }
+    nexus__spin_unlock(&pool->lock);
+    if (slab) NEXUS_ALLOCATOR_FREE(pool->parent, slab);
+    return NEXUS_TRUE;
+}
+
+/* Return the oldest `n` cached objects to the shared free list. Caller
+   holds m->lock. The chain is built outside the pool lock. */
+static void nexus__pool_drain(nexus_pool *pool, NexusPoolMagazine *m, unsigned n)
+{
+    void *first, *last;
+    unsigned i;
+
+    if (!n) return;
+    first = last = m->objs[0];
+    for (i = 1; i < n; ++i) {
+        nexus__pool_link(last, m->objs[i]);
+        last = m->objs[i];
+    }
+    memmove(m->objs, m->objs + n, (m->count - n) * sizeof m->objs[0]);
+    m->count -= n;
+
+    nexus__spin_lock(&pool->lock);
+    nexus__pool_link(last, pool->free_list);
+    pool->free_list = first;
+    nexus__spin_unlock(&pool->lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+nexus_pool *nexus_pool_create(size_t obj_size, size_t objs_per_slab, const char *file, unsigned line)
+{
+    const NexusAllocator *parent = nexus_allocator_current();
+    nexus_pool *pool;
+    size_t align, stride;
+
+    stride = obj_size < sizeof(void*) ? sizeof(void*) : obj_size;
+    align  = stride >= 16u ? 16u : sizeof(void*);
+    stride = (stride + align - 1u) / align * align;
+    if (!objs_per_slab) {
+        objs_per_slab = NEXUS_POOL_SLAB_SIZE / stride;
+        if (objs_per_slab < NEXUS_POOL_MAGAZINE) objs_per_slab = NEXUS_POOL_MAGAZINE;
+    }
+
+    if (!parent) parent = nexus_allocator_default();
+    pool = (nexus_pool*)nexus_allocator_alloc(parent, sizeof *pool, file, line);
+    if (!pool) return NULL;
+    memset(pool, 0, sizeof *pool);
+    pool->parent        = parent;
+    pool->obj_size      = obj_size;
+    pool->stride        = stride;
+    pool->align         = align;
+    pool->objs_per_slab = objs_per_slab;
+    pool->file          = file;
+    pool->line          = line;
+    return pool;
+}
+
+void nexus_pool_destroy(nexus_pool *pool)
+{
+    if (!pool) return;
+    while (pool->slabs) {
+        NexusPoolSlab *next = pool->slabs->next;
+        NEXUS_ALLOCATOR_FREE(pool->parent, pool->slabs);
+        pool->slabs = next;
+    }
+    NEXUS_ALLOCATOR_FREE(pool->parent, pool);
+}
+
+void *nexus_pool_alloc(nexus_pool *pool)
+{
+    NexusPoolMagazine *m = nexus__pool_cache(pool);
+    void *obj = NULL;
+
+    for (;;) {
+        nexus__spin_lock(&m->lock);
+        if (m->count || nexus__pool_refill(pool, m, NEXUS_POOL_BATCH)) {
+            obj = m->objs[--m->count];
+        }
+        nexus__spin_unlock(&m->lock);
+        if (obj || !nexus__pool_grow(pool)) return obj;
+    }
+}
+
+void nexus_pool_free(nexus_pool *pool, void *obj)
+{
+    NexusPoolMagazine *m;
+
+    if (!obj) return;
+#ifdef NEXUS_MEMORY_DEBUG
+    memset(obj, NEXUS_POOL_POISON, pool->obj_size);
+#endif
+    m = nexus__pool_cache(pool);
+    nexus__spin_lock(&m->lock);
+    if (m->count == NEXUS_POOL_MAGAZINE) nexus__pool_drain(pool, m, NEXUS_POOL_BATCH);
+    m->objs[m->count++] = obj;
+    nexus__spin_unlock(&m->lock);
+}
+
+void nexus_pool_flush(nexus_pool *pool)
+{
+    NexusPoolMagazine *m = nexus__pool_cache(pool);
+    nexus__spin_lock(&m->lock);
+    nexus__pool_drain(pool, m, m->count);
+    nexus__spin_unlock(&m->lock);
+}
+
+size_t nexus_pool_object_size(const nexus_pool *pool)
+{
+    return pool->obj_size;
+}
+
+/* ------------------------------------------------------------------ */
+/* NexusAllocator adapter                                              */
+/* ------------------------------------------------------------------ */
+
+static void *nexus__pool_vt_alloc(void *ctx, size_t size, const char *file, unsigned line)
+{
+    nexus_pool *pool = (nexus_pool*)ctx;
+    (void)file; (void)line;
+    return size <= pool->obj_size ? nexus_pool_alloc(pool) : NULL;
+}
+
+static void *nexus__pool_vt_realloc(void *ctx, void *ptr, size_t size, const char *file, unsigned line)
+{
+    (void)file; (void)line;
+    return size <= ((nexus_pool*)ctx)->obj_size ? ptr : NULL;
+}
+
+static void nexus__pool_vt_free(void *ctx, void *ptr)
+{
+    nexus_pool_free((nexus_pool*)ctx, ptr);
+}
+
+static void *nexus__pool_vt_alloc_aligned(void *ctx, size_t size, size_t align,
+                                          const char *file, unsigned line)
+{
+    nexus_pool *pool = (nexus_pool*)ctx;
+    (void)file; (void)line;
+    return (size <= pool->obj_size && align <= pool->align) ? nexus_pool_alloc(pool) : NULL;
+}
+
+void nexus_pool_allocator(nexus_pool *pool, NexusAllocator *out)
+{
+    out->allocate           = nexus__pool_vt_alloc;
+    out->deallocate         = nexus__pool_vt_free;
+    out->reallocate         = nexus__pool_vt_realloc;
+    out->allocate_aligned   = nexus__pool_vt_alloc_aligned;
+    out->deallocate_aligned = nexus__pool_vt_free;
+    out->ctx                = pool;
+}
@@ -0,0 +1,482 @@
+/* nexus_profile.c — per-thread event rings drained to a Chrome trace */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* clock_gettime(), nanosleep() under -std=c90 */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <nexus/nexus_profile.h>
+#include "nexus_atomic.h"
+#include "nexus_profile_impl.h"
+
+#if !defined(_WIN32)
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+/* Rings come from the real CRT; the debug allocator reports into them. */
+#ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
+#  undef malloc
+#  undef realloc
+#  undef free
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Config                                                              */
+/* ------------------------------------------------------------------ */
+#define NEXUS_PROFILE_RING          8192u   /* events per thread; power of two */
+#define NEXUS_PROFILE_CACHE_LINE    64u
+#define NEXUS_PROFILE_FLUSH_MS      50u     /* default drain interval */
+#define NEXUS_PROFILE_SLICE_MS      10u     /* flusher sleeps this long between stop checks */
+#define NEXUS_PROFILE_CALIBRATE_US  5000.0  /* rdtsc calibration window */
+
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#  define NEXUS_PROFILE_RDTSC() __rdtsc()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#  define NEXUS_PROFILE_RDTSC() __builtin_ia32_rdtsc()
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Types & globals                                                     */
+/* ------------------------------------------------------------------ */
+
+enum {
+    NEXUS_PROFILE_EV_BEGIN,
+    NEXUS_PROFILE_EV_END,
+    NEXUS_PROFILE_EV_ALLOC,
+    NEXUS_PROFILE_EV_FREE
+};
+
+typedef struct {
+    nexus_u64   ts;
+    const char *name;       /* zone name, or allocation site file */
+    const void *ptr;
+    size_t      size;
+    size_t      heap;       /* heap counter after this event (wraps; read as signed) */
+    unsigned    line;
+    unsigned    type;
+} NexusProfileEvent;
+
+/* Single producer (the owning thread) advances head, single consumer (the
+   flusher) advances tail. Rings are never freed: when a thread exits its
+   ring is released, and the next new thread takes it over once drained. */
+typedef struct NexusProfileRing {
+    struct NexusProfileRing *next;
+    volatile nexus_u32 head;
+    char               pad0[NEXUS_PROFILE_CACHE_LINE - sizeof(nexus_u32)];
+    volatile nexus_u32 tail;
+    volatile nexus_u32 owned;           /* a live thread records here */
+    nexus_u32          tid;             /* set by the owner before its first event */
+    void *volatile     thread_name;
+
+    /* Flusher only: last name written, for which thread and session */
+    const char        *name_written;
+    nexus_u32          name_tid;
+    nexus_u32          name_session;
+
+    NexusProfileEvent  events[NEXUS_PROFILE_RING];
+} NexusProfileRing;
+
+volatile nexus_u32 nexus__profile_active = 0u;
+
+static void *volatile g_rings       = NULL;     /* NexusProfileRing stack */
+static volatile nexus_u32 g_next_tid = 0u;
+static volatile size_t    g_dropped  = 0u;
+static volatile size_t    g_heap     = 0u;
+
+static NEXUS_THREAD_LOCAL NexusProfileRing *t_ring        = NULL;
+static NEXUS_THREAD_LOCAL const char       *t_thread_name = NULL;
+static NEXUS_THREAD_LOCAL unsigned          t_claiming    = 0u;
+
+/* Session state: written by start before the flusher exists, then used
+   only by the flusher until stop has joined it. */
+static FILE         *g_out      = NULL;
+static NEXUS_BOOL    g_first    = NEXUS_TRUE;
+static nexus_u32     g_session  = 0u;
+static nexus_u64     g_base     = 0u;
+static double        g_tick_us  = 0.0;
+static unsigned long g_pid      = 0ul;
+static unsigned      g_flush_ms = 0u;
+
+static volatile nexus_u32 g_flusher_run = 0u;
+static NEXUS_BOOL         g_key_ready   = NEXUS_FALSE;
+#if defined(_WIN32)
+static HANDLE             g_flusher = NULL;
+static DWORD              g_ring_key;
+#else
+static pthread_t          g_flusher;
+static pthread_key_t      g_ring_key;
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Clock                                                               */
+/* ------------------------------------------------------------------ */
+
+static nexus_u64 nexus__profile_clock(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (nexus_u64)t.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (nexus_u64)ts.tv_sec * 1000000000u + (nexus_u64)ts.tv_nsec;
+#endif
+}
+
+/* Microseconds per nexus__profile_clock tick. */
+static double nexus__profile_clock_us(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    return 1e6 / (double)f.QuadPart;
+#else
+    return 1e-3;
+#endif
+}
+
+static NEXUS_INLINE nexus_u64 nexus__profile_ticks(void)
+{
+#ifdef NEXUS_PROFILE_RDTSC
+    return (nexus_u64)NEXUS_PROFILE_RDTSC();
+#else
+    return nexus__profile_clock();
+#endif
+}
+
+/* Microseconds per tick; the TSC is timed against the clock for a few ms. */
+static double nexus__profile_calibrate(void)
+{
+#ifdef NEXUS_PROFILE_RDTSC
+    double    clock_us = nexus__profile_clock_us();
+    nexus_u64 c0 = nexus__profile_clock(), t0 = nexus__profile_ticks(), c1, t1;
+
+    do {
+        c1 = nexus__profile_clock();
+    } while ((double)(c1 - c0) * clock_us < NEXUS_PROFILE_CALIBRATE_US);
+    t1 = nexus__profile_ticks();
+    return t1 > t0 ? (double)(c1 - c0) * clock_us / (double)(t1 - t0) : clock_us;
+#else
+    return nexus__profile_clock_us();
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/* Recording                                                           */
+/* ------------------------------------------------------------------ */
+
+#if defined(_WIN32)
+static void WINAPI nexus__profile_thread_exit(void *ring)
+#else
+static void nexus__profile_thread_exit(void *ring)
+#endif
+{
+    if (!ring) return;
+    t_ring = NULL;
+    nexus__atomic_store_u32(&((NexusProfileRing*)ring)->owned, 0u);
+}
+
+/* Take over a drained ring left by an exited thread, or make a new one.
+   NULL when out of memory, or when the CRT re-enters us while we do. */
+static NexusProfileRing *nexus__profile_ring(void)
+{
+    NexusProfileRing *r;
+    void *head;
+
+    if (t_claiming) return NULL;
+    t_claiming = 1u;
+    for (r = (NexusProfileRing*)nexus__atomic_load_ptr(&g_rings); r; r = r->next) {
+        if (nexus__atomic_load_u32(&r->owned) || !nexus__atomic_cas_u32(&r->owned, 0u, 1u)) continue;
+        if (nexus__atomic_load_u32(&r->tail) == r->head) break;
+        nexus__atomic_store_u32(&r->owned, 0u);     /* flusher not done with it yet */
+    }
+    if (!r) {
+        r = (NexusProfileRing*)calloc(1u, sizeof *r);
+        if (r) {
+            r->owned = 1u;
+            do {
+                head = nexus__atomic_load_ptr(&g_rings);
+                r->next = (NexusProfileRing*)head;
+            } while (!nexus__atomic_cas_ptr(&g_rings, head, r));
+        }
+    }
+    if (r) {
+        r->tid = nexus__atomic_add_u32(&g_next_tid, 1u) + 1u;
+        nexus__atomic_store_ptr(&r->thread_name, (void*)t_thread_name);
+#if defined(_WIN32)
+        FlsSetValue(g_ring_key, r);
+#else
+        pthread_setspecific(g_ring_key, r);
+#endif
+    }
+    t_claiming = 0u;
+    return t_ring = r;
+}
+
+static void nexus__profile_push(unsigned type, const char *name, const void *ptr,
+                                size_t size, unsigned line, size_t heap)
+{
+    nexus_u64 ts = nexus__profile_ticks();
+    NexusProfileRing  *r = t_ring ? t_ring : nexus__profile_ring();
+    NexusProfileEvent *ev;
+    nexus_u32 h;
+
+    if (!r || (h = r->head) - nexus__atomic_load_u32(&r->tail) >= NEXUS_PROFILE_RING) {
+        nexus__atomic_add_size(&g_dropped, 1u);
+        return;
+    }
+    ev = &r->events[h & (NEXUS_PROFILE_RING - 1u)];
+    ev->ts   = ts;
+    ev->name = name;
+    ev->ptr  = ptr;
+    ev->size = size;
+    ev->heap = heap;
+    ev->line = line;
+    ev->type = type;
+    nexus__atomic_store_u32(&r->head, h + 1u);
+}
+
+/* ------------------------------------------------------------------ */
+/* Trace output                                                        */
+/* ------------------------------------------------------------------ */
+
+static void nexus__profile_string(const char *s)
+{
+    putc('"', g_out);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            putc('\\', g_out);
+            putc(c, g_out);
+        } else if (c < 0x20u) {
+            fprintf(g_out, "\\u%04x", (unsigned)c);
+        } else {
+            putc(c, g_out);
+        }
+    }
+    putc('"', g_out);
+}
+
+/* Separator plus the fields every record has; the caller closes it. */
+static void nexus__profile_record(char ph, nexus_u32 tid)
+{
+    fputs(g_first ? "\n" : ",\n", g_out);
+    g_first = NEXUS_FALSE;
+    fprintf(g_out, "{\"ph\":\"%c\",\"pid\":%lu,\"tid\":%lu", ph, g_pid, (unsigned long)tid);
+}
+
+static void nexus__profile_event(const NexusProfileRing *r, const NexusProfileEvent *ev)
+{
+    double ts = (double)(ev->ts - g_base) * g_tick_us;
+
+    switch (ev->type) {
+    case NEXUS_PROFILE_EV_BEGIN:
+        nexus__profile_record('B', r->tid);
+        fprintf(g_out, ",\"ts\":%.3f,\"name\":", ts);
+        nexus__profile_string(ev->name ? ev->name : "?");
+        fputs("}", g_out);
+        break;
+    case NEXUS_PROFILE_EV_END:
+        nexus__profile_record('E', r->tid);
+        fprintf(g_out, ",\"ts\":%.3f}", ts);
+        break;
+    default:
+        nexus__profile_record('i', r->tid);
+        fprintf(g_out, ",\"ts\":%.3f,\"s\":\"t\",\"cat\":\"memory\",\"name\":\"%s\","
+                       "\"args\":{\"size\":%lu,\"ptr\":\"%p\"",
+                ts, ev->type == NEXUS_PROFILE_EV_ALLOC ? "alloc" : "free",
+                (unsigned long)ev->size, (void*)ev->ptr);
+        if (ev->name) {
+            fputs(",\"file\":", g_out);
+            nexus__profile_string(ev->name);
+            fprintf(g_out, ",\"line\":%u", ev->line);
+        }
+        fputs("}}", g_out);
+
+        nexus__profile_record('C', r->tid);
+        fprintf(g_out, ",\"ts\":%.3f,\"name\":\"heap\",\"args\":{\"bytes\":", ts);
+        if (ev->heap > (size_t)-1 / 2u) fprintf(g_out, "-%lu}}", (unsigned long)((size_t)0 - ev->heap));
+        else                            fprintf(g_out, "%lu}}", (unsigned long)ev->heap);
+        break;
+    }
+}
+
+/* Write out everything recorded so far. Events older than the session
+   were left behind by the previous one and are skipped. */
+static void nexus__profile_drain(void)
+{
+    NexusProfileRing *r;
+
+    for (r = (NexusProfileRing*)nexus__atomic_load_ptr(&g_rings); r; r = r->next) {
+        nexus_u32 h = nexus__atomic_load_u32(&r->head), t = r->tail;
+        const char *name;
+
+        if (t == h) continue;
+        name = (const char*)nexus__atomic_load_ptr(&r->thread_name);
+        if (name && (name != r->name_written || r->name_tid != r->tid || r->name_session != g_session)) {
+            nexus__profile_record('M', r->tid);
+            fputs(",\"name\":\"thread_name\",\"args\":{\"name\":", g_out);
+            nexus__profile_string(name);
+            fputs("}}", g_out);
+            r->name_written = name;
+            r->name_tid     = r->tid;
+            r->name_session = g_session;
+        }
+        for (; t != h; ++t) {
+            const NexusProfileEvent *ev = &r->events[t & (NEXUS_PROFILE_RING - 1u)];
+            if (ev->ts >= g_base) nexus__profile_event(r, ev);
+        }
+        nexus__atomic_store_u32(&r->tail, h);
+    }
+    fflush(g_out);
+}
+
+static void nexus__profile_flusher_loop(void)
+{
+    unsigned waited = 0u;
+
+    while (nexus__atomic_load_u32(&g_flusher_run)) {
+#if defined(_WIN32)
+        Sleep(NEXUS_PROFILE_SLICE_MS);
+#else
+        {
+            struct timespec ts;
+            ts.tv_sec  = 0;
+            ts.tv_nsec = (long)NEXUS_PROFILE_SLICE_MS * 1000000L;
+            nanosleep(&ts, NULL);
+        }
+#endif
+        waited += NEXUS_PROFILE_SLICE_MS;
+        if (waited >= g_flush_ms) {
+            nexus__profile_drain();
+            waited = 0u;
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI nexus__profile_flusher_main(LPVOID arg) { (void)arg; nexus__profile_flusher_loop(); return 0; }
+#else
+static void *nexus__profile_flusher_main(void *arg) { (void)arg; nexus__profile_flusher_loop(); return NULL; }
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+NEXUS_BOOL nexus_profile_start(const char *path, unsigned flush_ms)
+{
+    if (nexus__atomic_load_u32(&nexus__profile_active)) return NEXUS_FALSE;
+    if (!g_key_ready) {
+#if defined(_WIN32)
+        g_ring_key = FlsAlloc(nexus__profile_thread_exit);
+        if (g_ring_key == FLS_OUT_OF_INDEXES) return NEXUS_FALSE;
+#else
+        if (pthread_key_create(&g_ring_key, nexus__profile_thread_exit) != 0)
+            return NEXUS_FALSE;
+#endif
+        g_key_ready = NEXUS_TRUE;
+    }
+
+    g_out = fopen(path, "w");
+    if (!g_out) return NEXUS_FALSE;
+#if defined(_WIN32)
+    g_pid = (unsigned long)GetCurrentProcessId();
+#else
+    g_pid = (unsigned long)getpid();
+#endif
+    g_first    = NEXUS_TRUE;
+    g_session += 1u;
+    g_flush_ms = flush_ms ? flush_ms : NEXUS_PROFILE_FLUSH_MS;
+    g_tick_us  = nexus__profile_calibrate();
+    nexus__atomic_store_size(&g_dropped, 0u);
+    nexus__atomic_store_size(&g_heap, 0u);
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", g_out);
+    g_base = nexus__profile_ticks();
+
+    nexus__atomic_store_u32(&g_flusher_run, 1u);
+#if defined(_WIN32)
+    g_flusher = CreateThread(NULL, 0, nexus__profile_flusher_main, NULL, 0, NULL);
+    if (!g_flusher) {
+#else
+    if (pthread_create(&g_flusher, NULL, nexus__profile_flusher_main, NULL) != 0) {
+#endif
+        nexus__atomic_store_u32(&g_flusher_run, 0u);
+        fclose(g_out);
+        g_out = NULL;
+        remove(path);
+        return NEXUS_FALSE;
+    }
+    nexus__atomic_store_u32(&nexus__profile_active, 1u);
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_profile_stop(void)
+{
+    NEXUS_BOOL ok;
+
+    if (!nexus__atomic_xchg_u32(&nexus__profile_active, 0u)) return NEXUS_FALSE;
+    nexus__atomic_store_u32(&g_flusher_run, 0u);
+#if defined(_WIN32)
+    WaitForSingleObject(g_flusher, INFINITE);
+    CloseHandle(g_flusher);
+    g_flusher = NULL;
+#else
+    pthread_join(g_flusher, NULL);
+#endif
+    nexus__profile_drain();
+    fputs("\n]}\n", g_out);
+    ok = ferror(g_out) ? NEXUS_FALSE : NEXUS_TRUE;
+    if (fclose(g_out) != 0) ok = NEXUS_FALSE;
+    g_out = NULL;
+    return ok;
+}
+
+NEXUS_BOOL nexus_profile_active(void)
+{
+    return nexus__atomic_load_u32(&nexus__profile_active) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+void nexus_profile_begin(const char *name)
+{
+    if (nexus__atomic_load_u32(&nexus__profile_active))
+        nexus__profile_push(NEXUS_PROFILE_EV_BEGIN, name, NULL, 0u, 0u, 0u);
+}
+
+void nexus_profile_end(void)
+{
+    if (nexus__atomic_load_u32(&nexus__profile_active))
+        nexus__profile_push(NEXUS_PROFILE_EV_END, NULL, NULL, 0u, 0u, 0u);
+}
+
+void nexus_profile_thread_name(const char *name)
+{
+    t_thread_name = name;
+    if (t_ring) nexus__atomic_store_ptr(&t_ring->thread_name, (void*)name);
+}
+
+size_t nexus_profile_dropped(void)
+{
+    return nexus__atomic_load_size(&g_dropped);
+}
+
+/* ------------------------------------------------------------------ */
+/* Internal hooks (nexus_profile_impl.h)                               */
+/* ------------------------------------------------------------------ */
+
+void nexus__profile_alloc(const void *ptr, size_t size, const char *file, unsigned line)
+{
+    size_t heap = nexus__atomic_add_size(&g_heap, size) + size;
+    nexus__profile_push(NEXUS_PROFILE_EV_ALLOC, file, ptr, size, line, heap);
+}
+
+void nexus__profile_free(const void *ptr, size_t size)
+{
+    size_t heap = nexus__atomic_add_size(&g_heap, (size_t)0 - size) - size;
+    nexus__profile_push(NEXUS_PROFILE_EV_FREE, NULL, ptr, size, 0u, heap);
+}
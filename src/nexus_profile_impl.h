@@ -0,0 +1,16 @@
+/* nexus_profile_impl.h — internal profiler hooks for the debug allocator */
+#ifndef NEXUS_PROFILE_IMPL_H
+#define NEXUS_PROFILE_IMPL_H
+
+#include <nexus/nexus.h>
+
+/* Nonzero while a session runs; callers test it before doing any work
+   for the hooks below. */
+extern volatile nexus_u32 nexus__profile_active;
+
+/* Record an allocation of `size` bytes at file:line, or the release of a
+   block of `size` bytes, on the calling thread's timeline. */
+void nexus__profile_alloc(const void *ptr, size_t size, const char *file, unsigned line);
+void nexus__profile_free(const void *ptr, size_t size);
+
+#endif /* NEXUS_PROFILE_IMPL_H */
@@ -0,0 +1,172 @@
+/* nexus_simd.c — scalar kernels, CPU detection and dispatch for nexus_simd.h */
+
+#include <stddef.h>
+#include <math.h>
+#include <nexus/nexus_simd.h>
+#include "nexus_simd_impl.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#  include <immintrin.h>
+#  define NEXUS_SIMD_CPUID_MSVC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#  define NEXUS_SIMD_CPUID_GNUC 1
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Scalar kernels (every build)                                        */
+/* ------------------------------------------------------------------ */
+#define NEXUS_SIMD_NAME(x) nexus__simd_scalar_##x
+#define V                  float_real
+#define LANES              1
+#define VZERO()            ((float_real)0)
+#define VSET1(s)           (s)
+#define VLOAD(p)           (*(p))
+#define VSTORE(p, v)       (*(p) = (v))
+#define VADD(a, b)         ((a) + (b))
+#define VMUL(a, b)         ((a) * (b))
+#define VDIV(a, b)         ((a) / (b))
+#define VSQRT(a)           ((float_real)sqrt((double)(a)))
+#define VMIN(a, b)         ((b) < (a) ? (b) : (a))
+#define VMAX(a, b)         ((b) > (a) ? (b) : (a))
+#define VFMA(a, b, c)      ((a) * (b) + (c))
+
+#include "nexus_simd_body.h"
+
+/* ------------------------------------------------------------------ */
+/* Dispatch                                                            */
+/* ------------------------------------------------------------------ */
+
+/* Set once on first use (or by nexus_simd_select); racing first calls
+   store the same table. */
+static const NexusSimdKernels *volatile g_simd_kernels = NULL;
+static volatile nexus_simd_level        g_simd_level   = NEXUS_SIMD_SCALAR;
+
+static const NexusSimdKernels *nexus__simd_table(nexus_simd_level level)
+{
+    switch (level) {
+    case NEXUS_SIMD_AVX512: return nexus__simd_avx512();
+    case NEXUS_SIMD_AVX2:   return nexus__simd_avx2();
+    case NEXUS_SIMD_SSE2:   return nexus__simd_sse2();
+    default:                return &nexus__simd_scalar_kernels;
+    }
+}
+
+/* What the CPU (and OS, for the wider register state) can run. */
+static nexus_simd_level nexus__simd_cpu(void)
+{
+#if defined(NEXUS_SIMD_CPUID_GNUC)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return NEXUS_SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return NEXUS_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return NEXUS_SIMD_SSE2;
+    return NEXUS_SIMD_SCALAR;
+#elif defined(NEXUS_SIMD_CPUID_MSVC)
+    int r[4], max_leaf;
+    unsigned __int64 xcr0 = 0;
+    NEXUS_BOOL fma, avx2 = NEXUS_FALSE, avx512 = NEXUS_FALSE;
+
+    __cpuid(r, 0);
+    max_leaf = r[0];
+    __cpuid(r, 1);
+    fma = (r[2] & (1 << 12)) != 0;
+    if (r[2] & (1 << 27)) xcr0 = _xgetbv(0);          /* OSXSAVE */
+    if (max_leaf >= 7) {
+        int s[4];
+        __cpuidex(s, 7, 0);
+        avx2   = (s[1] & (1 << 5)) != 0;
+        avx512 = (s[1] & (1 << 16)) != 0;
+    }
+    if (avx512 && (xcr0 & 0xE6) == 0xE6) return NEXUS_SIMD_AVX512;   /* XMM, YMM, opmask, ZMM */
+    if (avx2 && fma && (xcr0 & 0x6) == 0x6) return NEXUS_SIMD_AVX2;
+    return (r[3] & (1 << 26)) ? NEXUS_SIMD_SSE2 : NEXUS_SIMD_SCALAR;
+#else
+    return NEXUS_SIMD_SCALAR;
+#endif
+}
+
+const NexusSimdKernels *nexus__simd_kernels(void)
+{
+    const NexusSimdKernels *k = g_simd_kernels;
+    if (!k) {
+        nexus_simd_select(nexus_simd_detect());
+        k = g_simd_kernels;
+    }
+    return k;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+nexus_simd_level nexus_simd_detect(void)
+{
+    nexus_simd_level level = nexus__simd_cpu();
+    while (level > NEXUS_SIMD_SCALAR && !nexus__simd_table(level))
+        level = (nexus_simd_level)(level - 1);
+    return level;
+}
+
+nexus_simd_level nexus_simd_active(void)
+{
+    nexus__simd_kernels();
+    return g_simd_level;
+}
+
+nexus_simd_level nexus_simd_select(nexus_simd_level level)
+{
+    nexus_simd_level best = nexus_simd_detect();
+
+    if (level > best) level = best;
+    while (level > NEXUS_SIMD_SCALAR && !nexus__simd_table(level))
+        level = (nexus_simd_level)(level - 1);
+    g_simd_level   = level;
+    g_simd_kernels = nexus__simd_table(level);
+    return level;
+}
+
+const char *nexus_simd_level_name(nexus_simd_level level)
+{
+    switch (level) {
+    case NEXUS_SIMD_AVX512: return "avx512";
+    case NEXUS_SIMD_AVX2:   return "avx2";
+    case NEXUS_SIMD_SSE2:   return "sse2";
+    default:                return "scalar";
+    }
+}
+
+float_real nexus_simd_dot(const float_real *a, const float_real *b, size_t n)
+{
+    return nexus__simd_kernels()->dot(a, b, n);
+}
+
+void nexus_simd_axpy(float_real *y, float_real alpha, const float_real *x, size_t n)
+{
+    nexus__simd_kernels()->axpy(y, alpha, x, n);
+}
+
+void nexus_simd_scale(float_real *out, const float_real *x, float_real alpha, size_t n)
+{
+    nexus__simd_kernels()->scale(out, x, alpha, n);
+}
+
+float_real nexus_simd_sum(const float_real *x, size_t n)
+{
+    return nexus__simd_kernels()->sum(x, n);
+}
+
+float_real nexus_simd_min(const float_real *x, size_t n)
+{
+    return nexus__simd_kernels()->min(x, n);
+}
+
+float_real nexus_simd_max(const float_real *x, size_t n)
+{
+    return nexus__simd_kernels()->max(x, n);
+}
+
+void nexus_simd_fma(float_real *out, const float_real *a, const float_real *b,
+                    const float_real *c, size_t n)
+{
+    nexus__simd_kernels()->fma(out, a, b, c, n);
+}
@@ -0,0 +1,54 @@
+/* nexus_simd_avx2.c — AVX2 + FMA3 kernels (built with -mavx2 -mfma / /arch:AVX2) */
+
+#include <stddef.h>
+#include "nexus_simd_impl.h"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+#define NEXUS_SIMD_NAME(x) nexus__simd_avx2_##x
+#if defined(NEXUS_DOUBLE_PRECISION)
+#  define V             __m256d
+#  define LANES         4
+#  define VZERO()       _mm256_setzero_pd()
+#  define VSET1(s)      _mm256_set1_pd(s)
+#  define VLOAD(p)      _mm256_loadu_pd(p)
+#  define VSTORE(p, v)  _mm256_storeu_pd((p), (v))
+#  define VADD(a, b)    _mm256_add_pd((a), (b))
+#  define VMUL(a, b)    _mm256_mul_pd((a), (b))
+#  define VDIV(a, b)    _mm256_div_pd((a), (b))
+#  define VSQRT(a)      _mm256_sqrt_pd(a)
+#  define VMIN(a, b)    _mm256_min_pd((a), (b))
+#  define VMAX(a, b)    _mm256_max_pd((a), (b))
+#  define VFMA(a, b, c) _mm256_fmadd_pd((a), (b), (c))
+#else
+#  define V             __m256
+#  define LANES         8
+#  define VZERO()       _mm256_setzero_ps()
+#  define VSET1(s)      _mm256_set1_ps(s)
+#  define VLOAD(p)      _mm256_loadu_ps(p)
+#  define VSTORE(p, v)  _mm256_storeu_ps((p), (v))
+#  define VADD(a, b)    _mm256_add_ps((a), (b))
+#  define VMUL(a, b)    _mm256_mul_ps((a), (b))
+#  define VDIV(a, b)    _mm256_div_ps((a), (b))
+#  define VSQRT(a)      _mm256_sqrt_ps(a)
+#  define VMIN(a, b)    _mm256_min_ps((a), (b))
+#  define VMAX(a, b)    _mm256_max_ps((a), (b))
+#  define VFMA(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#endif
+
+#include "nexus_simd_body.h"
+
+const NexusSimdKernels *nexus__simd_avx2(void)
+{
+    return &nexus__simd_avx2_kernels;
+}
+
+#else
+
+const NexusSimdKernels *nexus__simd_avx2(void)
+{
+    return NULL;
+}
+
+#endif
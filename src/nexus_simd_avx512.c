@@ -0,0 +1,54 @@
+/* nexus_simd_avx512.c — AVX-512F kernels (built with -mavx512f / /arch:AVX512) */
+
+#include <stddef.h>
+#include "nexus_simd_impl.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+#define NEXUS_SIMD_NAME(x) nexus__simd_avx512_##x
+#if defined(NEXUS_DOUBLE_PRECISION)
+#  define V             __m512d
+#  define LANES         8
+#  define VZERO()       _mm512_setzero_pd()
+#  define VSET1(s)      _mm512_set1_pd(s)
+#  define VLOAD(p)      _mm512_loadu_pd(p)
+#  define VSTORE(p, v)  _mm512_storeu_pd((p), (v))
+#  define VADD(a, b)    _mm512_add_pd((a), (b))
+#  define VMUL(a, b)    _mm512_mul_pd((a), (b))
+#  define VDIV(a, b)    _mm512_div_pd((a), (b))
+#  define VSQRT(a)      _mm512_sqrt_pd(a)
+#  define VMIN(a, b)    _mm512_min_pd((a), (b))
+#  define VMAX(a, b)    _mm512_max_pd((a), (b))
+#  define VFMA(a, b, c) _mm512_fmadd_pd((a), (b), (c))
+#else
+#  define V             __m512
+#  define LANES         16
+#  define VZERO()       _mm512_setzero_ps()
+#  define VSET1(s)      _mm512_set1_ps(s)
+#  define VLOAD(p)      _mm512_loadu_ps(p)
+#  define VSTORE(p, v)  _mm512_storeu_ps((p), (v))
+#  define VADD(a, b)    _mm512_add_ps((a), (b))
+#  define VMUL(a, b)    _mm512_mul_ps((a), (b))
+#  define VDIV(a, b)    _mm512_div_ps((a), (b))
+#  define VSQRT(a)      _mm512_sqrt_ps(a)
+#  define VMIN(a, b)    _mm512_min_ps((a), (b))
+#  define VMAX(a, b)    _mm512_max_ps((a), (b))
+#  define VFMA(a, b, c) _mm512_fmadd_ps((a), (b), (c))
+#endif
+
+#include "nexus_simd_body.h"
+
+const NexusSimdKernels *nexus__simd_avx512(void)
+{
+    return &nexus__simd_avx512_kernels;
+}
+
+#else
+
+const NexusSimdKernels *nexus__simd_avx512(void)
+{
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,240 @@
+/* nexus_simd_body.h — kernel bodies shared by every nexus_simd level
+ *
+ * Included once per translation unit after defining:
+ *   NEXUS_SIMD_NAME(x)  unique name for kernel x
+ *   V, LANES            vector type and float_real lanes per vector
+ *   VZERO(), VSET1(s), VLOAD(p), VSTORE(p, v)   (unaligned access)
+ *   VADD, VMUL, VDIV, VMIN, VMAX (a, b), VSQRT(a) and VFMA(a, b, c) = a * b + c
+ * Main loops keep four independent accumulators to hide add latency;
+ * the remainder runs scalar. The SoA kernels (nexus_soa.h) instead run
+ * whole vectors over rows padded to NEXUS_SOA_LANES, so they take n
+ * already rounded up; only vec3_dot writes a caller-sized array.
+ */
+
+#if defined(NEXUS_DOUBLE_PRECISION)
+#  define NEXUS_SIMD_TINY DBL_MIN
+#else
+#  define NEXUS_SIMD_TINY FLT_MIN
+#endif
+
+static float_real NEXUS_SIMD_NAME(hsum)(V v)
+{
+    float_real lanes[LANES], r = 0;
+    unsigned k;
+    VSTORE(lanes, v);
+    for (k = 0; k < LANES; ++k) r += lanes[k];
+    return r;
+}
+
+static float_real NEXUS_SIMD_NAME(dot)(const float_real *a, const float_real *b, size_t n)
+{
+    V s0 = VZERO(), s1 = VZERO(), s2 = VZERO(), s3 = VZERO();
+    float_real r;
+    size_t i = 0;
+
+    for (; i + 4 * LANES <= n; i += 4 * LANES) {
+        s0 = VFMA(VLOAD(a + i),             VLOAD(b + i),             s0);
+        s1 = VFMA(VLOAD(a + i + LANES),     VLOAD(b + i + LANES),     s1);
+        s2 = VFMA(VLOAD(a + i + 2 * LANES), VLOAD(b + i + 2 * LANES), s2);
+        s3 = VFMA(VLOAD(a + i + 3 * LANES), VLOAD(b + i + 3 * LANES), s3);
+    }
+    for (; i + LANES <= n; i += LANES) s0 = VFMA(VLOAD(a + i), VLOAD(b + i), s0);
+    r = NEXUS_SIMD_NAME(hsum)(VADD(VADD(s0, s1), VADD(s2, s3)));
+    for (; i < n; ++i) r += a[i] * b[i];
+    return r;
+}
+
+static void NEXUS_SIMD_NAME(axpy)(float_real *y, float_real alpha, const float_real *x, size_t n)
+{
+    V va = VSET1(alpha);
+    size_t i = 0;
+
+    for (; i + LANES <= n; i += LANES) VSTORE(y + i, VFMA(va, VLOAD(x + i), VLOAD(y + i)));
+    for (; i < n; ++i) y[i] += alpha * x[i];
+}
+
+static void NEXUS_SIMD_NAME(scale)(float_real *out, const float_real *x, float_real alpha, size_t n)
+{
+    V va = VSET1(alpha);
+    size_t i = 0;
+
+    for (; i + LANES <= n; i += LANES) VSTORE(out + i, VMUL(va, VLOAD(x + i)));
+    for (; i < n; ++i) out[i] = alpha * x[i];
+}
+
+static float_real NEXUS_SIMD_NAME(sum)(const float_real *x, size_t n)
+{
+    V s0 = VZERO(), s1 = VZERO(), s2 = VZERO(), s3 = VZERO();
+    float_real r;
+    size_t i = 0;
+
+    for (; i + 4 * LANES <= n; i += 4 * LANES) {
+        s0 = VADD(s0, VLOAD(x + i));
+        s1 = VADD(s1, VLOAD(x + i + LANES));
+        s2 = VADD(s2, VLOAD(x + i + 2 * LANES));
+        s3 = VADD(s3, VLOAD(x + i + 3 * LANES));
+    }
+    for (; i + LANES <= n; i += LANES) s0 = VADD(s0, VLOAD(x + i));
+    r = NEXUS_SIMD_NAME(hsum)(VADD(VADD(s0, s1), VADD(s2, s3)));
+    for (; i < n; ++i) r += x[i];
+    return r;
+}
+
+static float_real NEXUS_SIMD_NAME(min)(const float_real *x, size_t n)
+{
+    float_real lanes[LANES], r;
+    size_t i = LANES;
+    unsigned k;
+    V m;
+
+    if (n < LANES) {
+        if (!n) return 0;
+        for (r = x[0], i = 1; i < n; ++i) if (x[i] < r) r = x[i];
+        return r;
+    }
+    for (m = VLOAD(x); i + LANES <= n; i += LANES) m = VMIN(m, VLOAD(x + i));
+    VSTORE(lanes, m);
+    for (r = lanes[0], k = 1; k < LANES; ++k) if (lanes[k] < r) r = lanes[k];
+    for (; i < n; ++i) if (x[i] < r) r = x[i];
+    return r;
+}
+
+static float_real NEXUS_SIMD_NAME(max)(const float_real *x, size_t n)
+{
+    float_real lanes[LANES], r;
+    size_t i = LANES;
+    unsigned k;
+    V m;
+
+    if (n < LANES) {
+        if (!n) return 0;
+        for (r = x[0], i = 1; i < n; ++i) if (x[i] > r) r = x[i];
+        return r;
+    }
+    for (m = VLOAD(x); i + LANES <= n; i += LANES) m = VMAX(m, VLOAD(x + i));
+    VSTORE(lanes, m);
+    for (r = lanes[0], k = 1; k < LANES; ++k) if (lanes[k] > r) r = lanes[k];
+    for (; i < n; ++i) if (x[i] > r) r = x[i];
+    return r;
+}
+
+static void NEXUS_SIMD_NAME(fma)(float_real *out, const float_real *a, const float_real *b,
+                                 const float_real *c, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + LANES <= n; i += LANES)
+        VSTORE(out + i, VFMA(VLOAD(a + i), VLOAD(b + i), VLOAD(c + i)));
+    for (; i < n; ++i) out[i] = a[i] * b[i] + c[i];
+}
+
+/* out[i] = a_i . b_i over three component rows */
+static void NEXUS_SIMD_NAME(vec3_dot)(float_real *out, const float_real *const a[3],
+                                      const float_real *const b[3], size_t n)
+{
+    size_t i = 0;
+
+    for (; i + LANES <= n; i += LANES) {
+        V d = VMUL(VLOAD(a[0] + i), VLOAD(b[0] + i));
+        d = VFMA(VLOAD(a[1] + i), VLOAD(b[1] + i), d);
+        VSTORE(out + i, VFMA(VLOAD(a[2] + i), VLOAD(b[2] + i), d));
+    }
+    for (; i < n; ++i) out[i] = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i];
+}
+
+/* Squared lengths are clamped to the smallest normal number, so zero
+   vectors stay zero instead of turning into NaN. */
+static void NEXUS_SIMD_NAME(vec3_normalize)(float_real *const v[3], size_t n)
+{
+    V tiny = VSET1(NEXUS_SIMD_TINY), one = VSET1(1);
+    size_t i;
+
+    for (i = 0; i < n; i += LANES) {
+        V x = VLOAD(v[0] + i), y = VLOAD(v[1] + i), z = VLOAD(v[2] + i);
+        V s = VDIV(one, VSQRT(VMAX(VFMA(z, z, VFMA(y, y, VMUL(x, x))), tiny)));
+        VSTORE(v[0] + i, VMUL(x, s));
+        VSTORE(v[1] + i, VMUL(y, s));
+        VSTORE(v[2] + i, VMUL(z, s));
+    }
+}
+
+/* One row-major 3x4 matrix (translation column pre-scaled by w) applied
+   to every vector. All loads of a block happen before its stores, so out
+   may be in. */
+static void NEXUS_SIMD_NAME(vec3_transform)(float_real *const out[3], const float_real *const in[3],
+                                            const float_real m[12], size_t n)
+{
+    V c[12], o[3];
+    size_t i;
+    unsigned r;
+
+    for (r = 0; r < 12; ++r) c[r] = VSET1(m[r]);
+    for (i = 0; i < n; i += LANES) {
+        V x = VLOAD(in[0] + i), y = VLOAD(in[1] + i), z = VLOAD(in[2] + i);
+        for (r = 0; r < 3; ++r)
+            o[r] = VFMA(c[4 * r + 2], z, VFMA(c[4 * r + 1], y, VFMA(c[4 * r], x, c[4 * r + 3])));
+        for (r = 0; r < 3; ++r) VSTORE(out[r] + i, o[r]);
+    }
+}
+
+/* out_i = a_i * b_i for 4x4 matrices stored one element per row. */
+static void NEXUS_SIMD_NAME(mat4_mul)(float_real *const out[16], const float_real *const a[16],
+                                      const float_real *const b[16], size_t n)
+{
+    V va[16], vb[16], vo[16];
+    size_t i;
+    unsigned r, c;
+
+    for (i = 0; i < n; i += LANES) {
+        for (r = 0; r < 16; ++r) {
+            va[r] = VLOAD(a[r] + i);
+            vb[r] = VLOAD(b[r] + i);
+        }
+        for (r = 0; r < 4; ++r) {
+            for (c = 0; c < 4; ++c) {
+                V e = VMUL(va[4 * r], vb[c]);
+                e = VFMA(va[4 * r + 1], vb[4 + c], e);
+                e = VFMA(va[4 * r + 2], vb[8 + c], e);
+                vo[4 * r + c] = VFMA(va[4 * r + 3], vb[12 + c], e);
+            }
+        }
+        for (r = 0; r < 16; ++r) VSTORE(out[r] + i, vo[r]);
+    }
+}
+
+/* out_i = m_i * (in_i, w), dropping the bottom row. */
+static void NEXUS_SIMD_NAME(mat4_transform)(float_real *const out[3], const float_real *const m[16],
+                                            const float_real *const in[3], float_real w, size_t n)
+{
+    V vw = VSET1(w), o[3];
+    size_t i;
+    unsigned r;
+
+    for (i = 0; i < n; i += LANES) {
+        V x = VLOAD(in[0] + i), y = VLOAD(in[1] + i), z = VLOAD(in[2] + i);
+        for (r = 0; r < 3; ++r) {
+            V e = VMUL(VLOAD(m[4 * r] + i), x);
+            e = VFMA(VLOAD(m[4 * r + 1] + i), y, e);
+            e = VFMA(VLOAD(m[4 * r + 2] + i), z, e);
+            o[r] = VFMA(VLOAD(m[4 * r + 3] + i), vw, e);
+        }
+        for (r = 0; r < 3; ++r) VSTORE(out[r] + i, o[r]);
+    }
+}
+
+static const NexusSimdKernels NEXUS_SIMD_NAME(kernels) = {
+    NEXUS_SIMD_NAME(dot),
+    NEXUS_SIMD_NAME(axpy),
+    NEXUS_SIMD_NAME(scale),
+    NEXUS_SIMD_NAME(sum),
+    NEXUS_SIMD_NAME(min),
+    NEXUS_SIMD_NAME(max),
+    NEXUS_SIMD_NAME(fma),
+    NEXUS_SIMD_NAME(vec3_dot),
+    NEXUS_SIMD_NAME(vec3_normalize),
+    NEXUS_SIMD_NAME(vec3_transform),
+    NEXUS_SIMD_NAME(mat4_mul),
+    NEXUS_SIMD_NAME(mat4_transform)
+};
+
+#undef NEXUS_SIMD_TINY
@@ -0,0 +1,39 @@
+/* nexus_simd_impl.h — internal kernel tables behind nexus_simd.h */
+#ifndef NEXUS_SIMD_IMPL_H
+#define NEXUS_SIMD_IMPL_H
+
+#include <float.h>
+#include <nexus/nexus.h>
+
+typedef struct {
+    float_real (*dot)(const float_real *a, const float_real *b, size_t n);
+    void       (*axpy)(float_real *y, float_real alpha, const float_real *x, size_t n);
+    void       (*scale)(float_real *out, const float_real *x, float_real alpha, size_t n);
+    float_real (*sum)(const float_real *x, size_t n);
+    float_real (*min)(const float_real *x, size_t n);
+    float_real (*max)(const float_real *x, size_t n);
+    void       (*fma)(float_real *out, const float_real *a, const float_real *b,
+                      const float_real *c, size_t n);
+
+    /* nexus_soa.h bulk operations; see nexus_simd_body.h */
+    void       (*vec3_dot)(float_real *out, const float_real *const a[3],
+                           const float_real *const b[3], size_t n);
+    void       (*vec3_normalize)(float_real *const v[3], size_t n);
+    void       (*vec3_transform)(float_real *const out[3], const float_real *const in[3],
+                                 const float_real m[12], size_t n);
+    void       (*mat4_mul)(float_real *const out[16], const float_real *const a[16],
+                           const float_real *const b[16], size_t n);
+    void       (*mat4_transform)(float_real *const out[3], const float_real *const m[16],
+                                 const float_real *const in[3], float_real w, size_t n);
+} NexusSimdKernels;
+
+/* Kernels for the active level (nexus_simd_active), selecting on first use. */
+const NexusSimdKernels *nexus__simd_kernels(void);
+
+/* One per level; NULL when the build could not target it (non-x86, or
+   the translation unit was compiled without the matching flags). */
+const NexusSimdKernels *nexus__simd_sse2(void);
+const NexusSimdKernels *nexus__simd_avx2(void);
+const NexusSimdKernels *nexus__simd_avx512(void);
+
+#endif /* NEXUS_SIMD_IMPL_H */
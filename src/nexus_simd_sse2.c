@@ -0,0 +1,53 @@
+/* nexus_simd_sse2.c — SSE2 kernels (baseline on x86-64) */
+
+#include <stddef.h>
+#include "nexus_simd_impl.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+#define NEXUS_SIMD_NAME(x) nexus__simd_sse2_##x
+#if defined(NEXUS_DOUBLE_PRECISION)
+#  define V             __m128d
+#  define LANES         2
+#  define VZERO()       _mm_setzero_pd()
+#  define VSET1(s)      _mm_set1_pd(s)
+#  define VLOAD(p)      _mm_loadu_pd(p)
+#  define VSTORE(p, v)  _mm_storeu_pd((p), (v))
+#  define VADD(a, b)    _mm_add_pd((a), (b))
+#  define VMUL(a, b)    _mm_mul_pd((a), (b))
+#  define VDIV(a, b)    _mm_div_pd((a), (b))
+#  define VSQRT(a)      _mm_sqrt_pd(a)
+#  define VMIN(a, b)    _mm_min_pd((a), (b))
+#  define VMAX(a, b)    _mm_max_pd((a), (b))
+#else
+#  define V             __m128
+#  define LANES         4
+#  define VZERO()       _mm_setzero_ps()
+#  define VSET1(s)      _mm_set1_ps(s)
+#  define VLOAD(p)      _mm_loadu_ps(p)
+#  define VSTORE(p, v)  _mm_storeu_ps((p), (v))
+#  define VADD(a, b)    _mm_add_ps((a), (b))
+#  define VMUL(a, b)    _mm_mul_ps((a), (b))
+#  define VDIV(a, b)    _mm_div_ps((a), (b))
+#  define VSQRT(a)      _mm_sqrt_ps(a)
+#  define VMIN(a, b)    _mm_min_ps((a), (b))
+#  define VMAX(a, b)    _mm_max_ps((a), (b))
+#endif
+#define VFMA(a, b, c)   VADD(VMUL((a), (b)), (c))   /* no FMA before AVX2 */
+
+#include "nexus_simd_body.h"
+
+const NexusSimdKernels *nexus__simd_sse2(void)
+{
+    return &nexus__simd_sse2_kernels;
+}
+
+#else
+
+const NexusSimdKernels *nexus__simd_sse2(void)
+{
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,221 @@
+/* nexus_soa.c — structure-of-arrays vector and matrix batches */
+
+#include <string.h>
+#include "nexus/nexus_soa.h"
+#include "nexus_simd_impl.h"
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static size_t nexus__soa_padded(size_t n)
+{
+    return (n + NEXUS_SOA_LANES - 1u) & ~(size_t)(NEXUS_SOA_LANES - 1u);
+}
+
+/* Move `rows` rows of `count` lanes into one fresh zeroed block with at
+   least `want` lanes per row. rows[0] is always the block start. */
+static NEXUS_BOOL nexus__soa_grow(float_real **row, unsigned rows, size_t count, size_t *capacity,
+                                  size_t want, const char *file, unsigned line)
+{
+    size_t cap = nexus__soa_padded(want), bytes;
+    float_real *block;
+    unsigned r;
+
+    if (want <= *capacity) return NEXUS_TRUE;
+    if (cap < want || cap > (size_t)-1 / sizeof(float_real) / rows) return NEXUS_FALSE;
+    bytes = cap * sizeof(float_real) * rows;
+    block = (float_real*)NEXUS_ALLOC_ALIGNED_AT(bytes, NEXUS_SOA_ALIGN, file, line);
+    if (!block) return NEXUS_FALSE;
+
+    memset(block, 0, bytes);
+    for (r = 0; r < rows; ++r) {
+        if (count) memcpy(block + r * cap, row[r], count * sizeof(float_real));
+    }
+    if (*capacity) NEXUS_FREE_ALIGNED(row[0]);
+    for (r = 0; r < rows; ++r) row[r] = block + r * cap;
+    *capacity = cap;
+    return NEXUS_TRUE;
+}
+
+/* Amortized growth for single-element appends. */
+static size_t nexus__soa_next(size_t capacity, size_t want)
+{
+    size_t doubled = capacity * 2u;
+    return (doubled > want && doubled > capacity) ? doubled : want;
+}
+
+/* ------------------------------------------------------------------ */
+/* nexus_vec3_soa                                                      */
+/* ------------------------------------------------------------------ */
+
+void nexus_vec3_soa_init(nexus_vec3_soa *v, const char *file, unsigned line)
+{
+    v->x = v->y = v->z = NULL;
+    v->count    = 0u;
+    v->capacity = 0u;
+    v->file     = file;
+    v->line     = line;
+}
+
+void nexus_vec3_soa_free(nexus_vec3_soa *v)
+{
+    if (v->capacity) NEXUS_FREE_ALIGNED(v->x);
+    nexus_vec3_soa_init(v, v->file, v->line);
+}
+
+NEXUS_BOOL nexus_vec3_soa_reserve(nexus_vec3_soa *v, size_t capacity)
+{
+    float_real *row[3];
+
+    row[0] = v->x; row[1] = v->y; row[2] = v->z;
+    if (!nexus__soa_grow(row, 3u, v->count, &v->capacity, capacity, v->file, v->line))
+        return NEXUS_FALSE;
+    v->x = row[0]; v->y = row[1]; v->z = row[2];
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_vec3_soa_resize(nexus_vec3_soa *v, size_t count)
+{
+    if (!nexus_vec3_soa_reserve(v, count)) return NEXUS_FALSE;
+    if (count > v->count) {
+        /* Padding lanes may hold kernel output; clear what becomes visible. */
+        size_t n = (count - v->count) * sizeof(float_real);
+        memset(v->x + v->count, 0, n);
+        memset(v->y + v->count, 0, n);
+        memset(v->z + v->count, 0, n);
+    }
+    v->count = count;
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_vec3_soa_push(nexus_vec3_soa *v, float_real x, float_real y, float_real z)
+{
+    if (v->count == v->capacity
+        && !nexus_vec3_soa_reserve(v, nexus__soa_next(v->capacity, v->count + 1u)))
+        return NEXUS_FALSE;
+    v->x[v->count] = x;
+    v->y[v->count] = y;
+    v->z[v->count] = z;
+    v->count += 1u;
+    return NEXUS_TRUE;
+}
+
+void nexus_vec3_soa_dot(float_real *out, const nexus_vec3_soa *a, const nexus_vec3_soa *b)
+{
+    const float_real *ra[3], *rb[3];
+
+    ra[0] = a->x; ra[1] = a->y; ra[2] = a->z;
+    rb[0] = b->x; rb[1] = b->y; rb[2] = b->z;
+    nexus__simd_kernels()->vec3_dot(out, ra, rb, a->count);
+}
+
+void nexus_vec3_soa_normalize(nexus_vec3_soa *v)
+{
+    float_real *row[3];
+
+    row[0] = v->x; row[1] = v->y; row[2] = v->z;
+    nexus__simd_kernels()->vec3_normalize(row, nexus__soa_padded(v->count));
+}
+
+NEXUS_BOOL nexus_vec3_soa_transform(nexus_vec3_soa *out, const nexus_vec3_soa *in,
+                                    const float_real m[16], float_real w)
+{
+    const float_real *src[3];
+    float_real *dst[3], m12[12];
+    unsigned r;
+
+    if (!nexus_vec3_soa_resize(out, in->count)) return NEXUS_FALSE;
+    for (r = 0; r < 3; ++r) {
+        m12[4 * r]     = m[4 * r];
+        m12[4 * r + 1] = m[4 * r + 1];
+        m12[4 * r + 2] = m[4 * r + 2];
+        m12[4 * r + 3] = m[4 * r + 3] * w;
+    }
+    src[0] = in->x;  src[1] = in->y;  src[2] = in->z;
+    dst[0] = out->x; dst[1] = out->y; dst[2] = out->z;
+    nexus__simd_kernels()->vec3_transform(dst, src, m12, nexus__soa_padded(in->count));
+    return NEXUS_TRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/* nexus_mat4_batch                                                    */
+/* ------------------------------------------------------------------ */
+
+void nexus_mat4_batch_init(nexus_mat4_batch *b, const char *file, unsigned line)
+{
+    unsigned r;
+
+    for (r = 0; r < 16; ++r) b->m[r] = NULL;
+    b->count    = 0u;
+    b->capacity = 0u;
+    b->file     = file;
+    b->line     = line;
+}
+
+void nexus_mat4_batch_free(nexus_mat4_batch *b)
+{
+    if (b->capacity) NEXUS_FREE_ALIGNED(b->m[0]);
+    nexus_mat4_batch_init(b, b->file, b->line);
+}
+
+NEXUS_BOOL nexus_mat4_batch_reserve(nexus_mat4_batch *b, size_t capacity)
+{
+    return nexus__soa_grow(b->m, 16u, b->count, &b->capacity, capacity, b->file, b->line);
+}
+
+NEXUS_BOOL nexus_mat4_batch_resize(nexus_mat4_batch *b, size_t count)
+{
+    unsigned r;
+    size_t i;
+
+    if (!nexus_mat4_batch_reserve(b, count)) return NEXUS_FALSE;
+    for (r = 0; r < 16; ++r) {
+        float_real e = (r % 5u == 0u) ? (float_real)1 : (float_real)0;   /* 0, 5, 10, 15: diagonal */
+        for (i = b->count; i < count; ++i) b->m[r][i] = e;
+    }
+    b->count = count;
+    return NEXUS_TRUE;
+}
+
+void nexus_mat4_batch_set(nexus_mat4_batch *b, size_t i, const float_real m[16])
+{
+    unsigned r;
+    for (r = 0; r < 16; ++r) b->m[r][i] = m[r];
+}
+
+void nexus_mat4_batch_get(const nexus_mat4_batch *b, size_t i, float_real m[16])
+{
+    unsigned r;
+    for (r = 0; r < 16; ++r) m[r] = b->m[r][i];
+}
+
+NEXUS_BOOL nexus_mat4_batch_mul(nexus_mat4_batch *out, const nexus_mat4_batch *a,
+                                const nexus_mat4_batch *b)
+{
+    const float_real *ra[16], *rb[16];
+    unsigned r;
+
+    if (b->count < a->count || !nexus_mat4_batch_resize(out, a->count)) return NEXUS_FALSE;
+    for (r = 0; r < 16; ++r) {
+        ra[r] = a->m[r];
+        rb[r] = b->m[r];
+    }
+    nexus__simd_kernels()->mat4_mul(out->m, ra, rb, nexus__soa_padded(a->count));
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_mat4_batch_transform(nexus_vec3_soa *out, const nexus_mat4_batch *m,
+                                      const nexus_vec3_soa *in, float_real w)
+{
+    const float_real *rm[16], *src[3];
+    float_real *dst[3];
+    unsigned r;
+
+    if (m->count < in->count || !nexus_vec3_soa_resize(out, in->count)) return NEXUS_FALSE;
+    for (r = 0; r < 16; ++r) rm[r] = m->m[r];
+    src[0] = in->x;  src[1] = in->y;  src[2] = in->z;
+    dst[0] = out->x; dst[1] = out->y; dst[2] = out->z;
+    nexus__simd_kernels()->mat4_transform(dst, rm, src, w, nexus__soa_padded(in->count));
+    return NEXUS_TRUE;
+}
@@ -0,0 +1,214 @@
+/* nexus_stack.c — call-stack capture and the deduplicated stack table */
+
+#include <stdlib.h>
+#include <string.h>
+#include <nexus/nexus_hash.h>
+#include "nexus_stack.h"
+#include "nexus_atomic.h"
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#  include <execinfo.h>
+#  define NEXUS_STACK_EXECINFO 1
+#endif
+
+/* Table storage is bookkeeping: keep it out of the tracked heap. */
+#ifdef NEXUS_OVERRIDE_STDLIB_ALLOC
+#  undef malloc
+#  undef realloc
+#  undef free
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Types & globals                                                     */
+/* ------------------------------------------------------------------ */
+#define NEXUS_STACK_CHUNK   1024u   /* entries per chunk; chunks never move */
+#define NEXUS_STACK_CHUNKS  1024u
+#define NEXUS_STACK_CACHE   64u     /* per-thread recently seen stacks */
+
+typedef struct {
+    nexus_u32 hash;
+    unsigned  depth;
+    void     *frames[NEXUS_STACK_MAX_FRAMES];
+} NexusStackEntry;
+
+/* Entries are written once, then published by bumping g_stack_count, so
+   readers need no lock. Inserts serialize on g_stack_lock, which also
+   guards the hash index. */
+static NexusStackEntry  *g_stack_chunks[NEXUS_STACK_CHUNKS];
+static volatile nexus_u32 g_stack_count = 0u;
+static NexusSpinLock     g_stack_lock  = 0u;
+static nexus_u32        *g_stack_index = NULL;   /* IDs, open addressing, power of two */
+static unsigned          g_stack_index_cap = 0u;
+
+static NEXUS_THREAD_LOCAL nexus_u32 t_stack_cache[NEXUS_STACK_CACHE];
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static nexus_u32 nexus__stack_hash(void *const *frames, unsigned depth)
+{
+    return (nexus_u32)nexus_hash_bytes(frames, depth * sizeof *frames, depth);
+}
+
+static const NexusStackEntry *nexus__stack_entry(nexus_u32 id)
+{
+    if (!id || id > nexus__atomic_load_u32(&g_stack_count)) return NULL;
+    id -= 1u;
+    return &g_stack_chunks[id / NEXUS_STACK_CHUNK][id % NEXUS_STACK_CHUNK];
+}
+
+static NEXUS_BOOL nexus__stack_equal(const NexusStackEntry *e, nexus_u32 hash,
+                                     void *const *frames, unsigned depth)
+{
+    return e->hash == hash && e->depth == depth
+        && memcmp(e->frames, frames, depth * sizeof *frames) == 0;
+}
+
+/* Caller holds g_stack_lock. */
+static NEXUS_BOOL nexus__stack_index_grow(void)
+{
+    unsigned cap = g_stack_index_cap ? g_stack_index_cap * 2u : 256u, mask = cap - 1u, k, i;
+    nexus_u32 *index = (nexus_u32*)calloc(cap, sizeof *index);
+
+    if (!index) return NEXUS_FALSE;
+    for (k = 0; k < g_stack_index_cap; ++k) {
+        nexus_u32 id = g_stack_index[k];
+        if (!id) continue;
+        for (i = nexus__stack_entry(id)->hash & mask; index[i]; i = (i + 1u) & mask) {
+            /* probe */
+        }
+        index[i] = id;
+    }
+    free(g_stack_index);
+    g_stack_index     = index;
+    g_stack_index_cap = cap;
+    return NEXUS_TRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/* Internal API                                                        */
+/* ------------------------------------------------------------------ */
+
+unsigned nexus__stack_capture(void **frames, unsigned max, unsigned skip)
+{
+#if defined(_WIN32)
+    if (max > NEXUS_STACK_MAX_FRAMES) max = NEXUS_STACK_MAX_FRAMES;
+    return (unsigned)CaptureStackBackTrace((DWORD)(1u + skip), (DWORD)max, frames, NULL);
+#elif defined(NEXUS_STACK_EXECINFO)
+    void *buf[NEXUS_STACK_MAX_FRAMES + 8];
+    int n;
+
+    if (max > NEXUS_STACK_MAX_FRAMES) max = NEXUS_STACK_MAX_FRAMES;
+    if (skip > 7u) skip = 7u;
+    n = backtrace(buf, (int)(1u + skip + max));   /* buf[0] is this function */
+    if (n <= (int)(1u + skip)) return 0u;
+    n -= (int)(1u + skip);
+    memcpy(frames, buf + 1u + skip, (size_t)n * sizeof *frames);
+    return (unsigned)n;
+#else
+    (void)frames; (void)max; (void)skip;
+    return 0u;
+#endif
+}
+
+nexus_u32 nexus__stack_intern(void *const *frames, unsigned depth)
+{
+    nexus_u32 hash, id, count;
+    nexus_u32 *cached;
+    unsigned mask, i;
+    const NexusStackEntry *e;
+    NexusStackEntry *slot;
+
+    if (!depth) return 0u;
+    if (depth > NEXUS_STACK_MAX_FRAMES) depth = NEXUS_STACK_MAX_FRAMES;
+    hash = nexus__stack_hash(frames, depth);
+
+    /* Hot stacks repeat: check this thread's cache before taking the lock. */
+    cached = &t_stack_cache[hash % NEXUS_STACK_CACHE];
+    e = nexus__stack_entry(*cached);
+    if (e && nexus__stack_equal(e, hash, frames, depth)) return *cached;
+
+    nexus__spin_lock(&g_stack_lock);
+    count = g_stack_count;
+    if ((count + 1u) * 2u > g_stack_index_cap && !nexus__stack_index_grow()) {
+        nexus__spin_unlock(&g_stack_lock);
+        return 0u;
+    }
+    mask = g_stack_index_cap - 1u;
+    for (i = hash & mask; g_stack_index[i]; i = (i + 1u) & mask) {
+        id = g_stack_index[i];
+        if (nexus__stack_equal(nexus__stack_entry(id), hash, frames, depth)) {
+            nexus__spin_unlock(&g_stack_lock);
+            *cached = id;
+            return id;
+        }
+    }
+
+    if (count >= NEXUS_STACK_CHUNK * NEXUS_STACK_CHUNKS) {
+        nexus__spin_unlock(&g_stack_lock);
+        return 0u;
+    }
+    if (!g_stack_chunks[count / NEXUS_STACK_CHUNK]) {
+        g_stack_chunks[count / NEXUS_STACK_CHUNK] =
+            (NexusStackEntry*)malloc(NEXUS_STACK_CHUNK * sizeof(NexusStackEntry));
+        if (!g_stack_chunks[count / NEXUS_STACK_CHUNK]) {
+            nexus__spin_unlock(&g_stack_lock);
+            return 0u;
+        }
+    }
+    slot = &g_stack_chunks[count / NEXUS_STACK_CHUNK][count % NEXUS_STACK_CHUNK];
+    slot->hash  = hash;
+    slot->depth = depth;
+    memcpy(slot->frames, frames, depth * sizeof *frames);
+    id = count + 1u;
+    g_stack_index[i] = id;
+    nexus__atomic_store_u32(&g_stack_count, id);   /* publish */
+    nexus__spin_unlock(&g_stack_lock);
+
+    *cached = id;
+    return id;
+}
+
+unsigned nexus__stack_frames(nexus_u32 id, void *const **frames)
+{
+    const NexusStackEntry *e = nexus__stack_entry(id);
+    if (!e) {
+        *frames = NULL;
+        return 0u;
+    }
+    *frames = e->frames;
+    return e->depth;
+}
+
+void nexus__stack_print(FILE *out, nexus_u32 id, const char *indent)
+{
+    void *const *frames;
+    unsigned depth = nexus__stack_frames(id, &frames), i;
+#if defined(NEXUS_STACK_EXECINFO)
+    char **names = depth ? backtrace_symbols(frames, (int)depth) : NULL;
+#endif
+
+    for (i = 0; i < depth; ++i) {
+#if defined(NEXUS_STACK_EXECINFO)
+        if (names) {
+            fprintf(out, "%s#%u %s\n", indent, i, names[i]);
+            continue;
+        }
+#endif
+        fprintf(out, "%s#%u %p\n", indent, i, frames[i]);
+    }
+#if defined(NEXUS_STACK_EXECINFO)
+    free(names);
+#endif
+}
+
+void nexus__stack_lock(void)
+{
+    nexus__spin_lock(&g_stack_lock);
+}
+
+void nexus__stack_unlock(void)
+{
+    nexus__spin_unlock(&g_stack_lock);
+}
@@ -0,0 +1,32 @@
+/* nexus_stack.h — internal call-stack capture and stack table */
+#ifndef NEXUS_STACK_H
+#define NEXUS_STACK_H
+
+#include <stdio.h>
+#include <nexus/nexus.h>
+
+/* Deepest stack kept per ID. */
+#define NEXUS_STACK_MAX_FRAMES 16
+
+/* Return addresses from the caller outwards, at most `max` of them, after
+   skipping `skip` frames. Returns the count; 0 where capture is
+   unsupported (anything but glibc, macOS and Windows). */
+unsigned  nexus__stack_capture(void **frames, unsigned max, unsigned skip);
+
+/* Deduplicate a captured stack into the process-wide table; equal stacks
+   get equal IDs. 0 for an empty stack or when the table cannot grow. IDs
+   and their frames stay valid for the life of the process. */
+nexus_u32 nexus__stack_intern(void *const *frames, unsigned depth);
+
+/* Frames for an ID (NULL / 0 for 0 or unknown IDs). Lock-free. */
+unsigned  nexus__stack_frames(nexus_u32 id, void *const **frames);
+
+/* One line per frame, symbolized where the platform can, each prefixed
+   with `indent`. */
+void      nexus__stack_print(FILE *out, nexus_u32 id, const char *indent);
+
+/* Hold the table lock, e.g. across fork(). */
+void      nexus__stack_lock(void);
+void      nexus__stack_unlock(void);
+
+#endif /* NEXUS_STACK_H */
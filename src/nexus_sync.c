@@ -0,0 +1,138 @@
+/* nexus_sync.c — portable atomics, spinlock, futex wait/wake and mutex */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE 1 /* syscall() */
+#elif !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L /* sched_yield(), nanosleep() under -std=c90 */
+#endif
+#if defined(_WIN32) && !defined(_WIN32_WINNT)
+#  define _WIN32_WINNT 0x0602 /* WaitOnAddress (Windows 8) */
+#endif
+
+#include <nexus/nexus_sync.h>
+#include "nexus_atomic.h"
+
+#if defined(__linux__)
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/futex.h>
+#elif !defined(_WIN32)
+#  include <time.h>
+#endif
+
+#define NEXUS_MUTEX_SPINS 100u   /* CAS attempts before sleeping */
+
+/* ------------------------------------------------------------------ */
+/* Atomics                                                             */
+/* ------------------------------------------------------------------ */
+
+nexus_u32 nexus_atomic_load_u32(nexus_atomic_u32 *p)                { return nexus__atomic_load_u32(p); }
+void      nexus_atomic_store_u32(nexus_atomic_u32 *p, nexus_u32 v)  { nexus__atomic_store_u32(p, v); }
+nexus_u32 nexus_atomic_add_u32(nexus_atomic_u32 *p, nexus_u32 v)    { return nexus__atomic_add_u32(p, v); }
+nexus_u32 nexus_atomic_xchg_u32(nexus_atomic_u32 *p, nexus_u32 v)   { return nexus__atomic_xchg_u32(p, v); }
+size_t    nexus_atomic_load_size(nexus_atomic_size *p)              { return nexus__atomic_load_size(p); }
+void      nexus_atomic_store_size(nexus_atomic_size *p, size_t v)   { nexus__atomic_store_size(p, v); }
+size_t    nexus_atomic_add_size(nexus_atomic_size *p, size_t v)     { return nexus__atomic_add_size(p, v); }
+void      nexus_atomic_fence(void)                                  { nexus__atomic_fence(); }
+
+NEXUS_BOOL nexus_atomic_cas_u32(nexus_atomic_u32 *p, nexus_u32 expected, nexus_u32 desired)
+{
+    return nexus__atomic_cas_u32(p, expected, desired) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+NEXUS_BOOL nexus_atomic_cas_size(nexus_atomic_size *p, size_t expected, size_t desired)
+{
+    return nexus__atomic_cas_size(p, expected, desired) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+/* ------------------------------------------------------------------ */
+/* Spinlock                                                            */
+/* ------------------------------------------------------------------ */
+
+void nexus_spin_lock(nexus_spinlock *l)
+{
+    nexus__spin_lock(l);
+}
+
+NEXUS_BOOL nexus_spin_trylock(nexus_spinlock *l)
+{
+    return (nexus__atomic_load_u32(l) == 0u && nexus__atomic_xchg_u32(l, 1u) == 0u) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+void nexus_spin_unlock(nexus_spinlock *l)
+{
+    nexus__spin_unlock(l);
+}
+
+/* ------------------------------------------------------------------ */
+/* Address wait/wake                                                   */
+/* ------------------------------------------------------------------ */
+
+void nexus_futex_wait(nexus_atomic_u32 *addr, nexus_u32 expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (nexus_u32*)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#elif defined(_WIN32)
+    WaitOnAddress(addr, &expected, sizeof expected, INFINITE);
+#else
+    /* No portable kernel primitive: poll with a short sleep. */
+    struct timespec ts;
+    ts.tv_sec  = 0;
+    ts.tv_nsec = 50000L;
+    if (nexus__atomic_load_u32(addr) == expected) nanosleep(&ts, NULL);
+#endif
+}
+
+void nexus_futex_wake(nexus_atomic_u32 *addr, NEXUS_BOOL all)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (nexus_u32*)addr, FUTEX_WAKE_PRIVATE, all ? 0x7FFFFFFF : 1, NULL, NULL, 0);
+#elif defined(_WIN32)
+    if (all) WakeByAddressAll((PVOID)addr);
+    else     WakeByAddressSingle((PVOID)addr);
+#else
+    (void)addr; (void)all;
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/* Mutex (Drepper, "Futexes Are Tricky", mutex #2)                     */
+/* ------------------------------------------------------------------ */
+
+void nexus_mutex_lock(nexus_mutex *m)
+{
+    unsigned spins;
+    nexus_u32 c;
+
+    for (spins = 0; spins < NEXUS_MUTEX_SPINS; ++spins) {
+        c = nexus__atomic_load_u32(&m->state);
+        if (c == 0u && nexus__atomic_cas_u32(&m->state, 0u, 1u)) return;
+        if (c == 2u) break;                 /* already sleepers: queue up */
+        nexus__cpu_relax();
+    }
+    /* Mark the lock contended; whoever takes it this way also owns the
+       duty to wake the next sleeper on unlock. */
+    while (nexus__atomic_xchg_u32(&m->state, 2u) != 0u)
+        nexus_futex_wait(&m->state, 2u);
+}
+
+NEXUS_BOOL nexus_mutex_trylock(nexus_mutex *m)
+{
+    return nexus__atomic_cas_u32(&m->state, 0u, 1u) ? NEXUS_TRUE : NEXUS_FALSE;
+}
+
+void nexus_mutex_unlock(nexus_mutex *m)
+{
+    if (nexus__atomic_xchg_u32(&m->state, 0u) == 2u)
+        nexus_futex_wake(&m->state, NEXUS_FALSE);
+}
+
+void nexus_mutex_lock_cb(void *mutex)
+{
+    nexus_mutex_lock((nexus_mutex*)mutex);
+}
+
+void nexus_mutex_unlock_cb(void *mutex)
+{
+    nexus_mutex_unlock((nexus_mutex*)mutex);
+}
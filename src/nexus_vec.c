@@ -0,0 +1,137 @@
+/* nexus_vec.c — type-generic dynamic array */
+
+#include <string.h>
+#include "nexus/nexus_vec.h"
+
+#define NEXUS_VEC_MIN_CAPACITY 8u
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static void *nexus__vec_at(const nexus_vec *v, size_t i)
+{
+    return (char*)v->data + i * v->elem_size;
+}
+
+/* Room for `extra` more elements, growing by half again (at least to
+   NEXUS_VEC_MIN_CAPACITY) so appends stay amortized O(1). */
+static NEXUS_BOOL nexus__vec_grow(nexus_vec *v, size_t extra)
+{
+    size_t want = v->count + extra, cap;
+
+    if (want < v->count) return NEXUS_FALSE;
+    if (want <= v->capacity) return NEXUS_TRUE;
+    cap = v->capacity + v->capacity / 2u;
+    if (cap < want || cap < v->capacity) cap = want;
+    if (cap < NEXUS_VEC_MIN_CAPACITY) cap = NEXUS_VEC_MIN_CAPACITY;
+    return nexus_vec_reserve(v, cap);
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+void nexus_vec_init(nexus_vec *v, size_t elem_size, const NexusAllocator *allocator,
+                    const char *file, unsigned line)
+{
+    v->data      = NULL;
+    v->count     = 0u;
+    v->capacity  = 0u;
+    v->elem_size = elem_size ? elem_size : 1u;
+    v->allocator = allocator;
+    v->file      = file;
+    v->line      = line;
+}
+
+void nexus_vec_free(nexus_vec *v)
+{
+    nexus_allocator_free(v->allocator, v->data);
+    v->data     = NULL;
+    v->count    = 0u;
+    v->capacity = 0u;
+}
+
+NEXUS_BOOL nexus_vec_reserve(nexus_vec *v, size_t capacity)
+{
+    void *p;
+
+    if (capacity <= v->capacity) return NEXUS_TRUE;
+    if (capacity > (size_t)-1 / v->elem_size) return NEXUS_FALSE;
+    p = nexus_allocator_realloc(v->allocator, v->data, capacity * v->elem_size, v->file, v->line);
+    if (!p) return NEXUS_FALSE;
+    v->data     = p;
+    v->capacity = capacity;
+    return NEXUS_TRUE;
+}
+
+NEXUS_BOOL nexus_vec_resize(nexus_vec *v, size_t count)
+{
+    if (count > v->count) {
+        if (!nexus__vec_grow(v, count - v->count)) return NEXUS_FALSE;
+        memset(nexus__vec_at(v, v->count), 0, (count - v->count) * v->elem_size);
+    }
+    v->count = count;
+    return NEXUS_TRUE;
+}
+
+void nexus_vec_clear(nexus_vec *v)
+{
+    v->count = 0u;
+}
+
+void *nexus_vec_push(nexus_vec *v, const void *elem)
+{
+    void *slot;
+
+    if (!nexus__vec_grow(v, 1u)) return NULL;
+    slot = nexus__vec_at(v, v->count);
+    if (elem) memcpy(slot, elem, v->elem_size);
+    else      memset(slot, 0, v->elem_size);
+    v->count += 1u;
+    return slot;
+}
+
+NEXUS_BOOL nexus_vec_append(nexus_vec *v, const void *elems, size_t n)
+{
+    if (!n) return NEXUS_TRUE;
+    if (!nexus__vec_grow(v, n)) return NEXUS_FALSE;
+    memcpy(nexus__vec_at(v, v->count), elems, n * v->elem_size);
+    v->count += n;
+    return NEXUS_TRUE;
+}
+
+void *nexus_vec_insert(nexus_vec *v, size_t i, const void *elem)
+{
+    void *slot;
+
+    if (i > v->count || !nexus__vec_grow(v, 1u)) return NULL;
+    slot = nexus__vec_at(v, i);
+    memmove(nexus__vec_at(v, i + 1u), slot, (v->count - i) * v->elem_size);
+    if (elem) memcpy(slot, elem, v->elem_size);
+    else      memset(slot, 0, v->elem_size);
+    v->count += 1u;
+    return slot;
+}
+
+NEXUS_BOOL nexus_vec_pop(nexus_vec *v, void *out)
+{
+    if (!v->count) return NEXUS_FALSE;
+    v->count -= 1u;
+    if (out) memcpy(out, nexus__vec_at(v, v->count), v->elem_size);
+    return NEXUS_TRUE;
+}
+
+void nexus_vec_remove(nexus_vec *v, size_t i)
+{
+    if (i >= v->count) return;
+    memmove(nexus__vec_at(v, i), nexus__vec_at(v, i + 1u), (v->count - i - 1u) * v->elem_size);
+    v->count -= 1u;
+}
+
+void nexus_vec_remove_swap(nexus_vec *v, size_t i)
+{
+    if (i >= v->count) return;
+    v->count -= 1u;
+    if (i != v->count) memcpy(nexus__vec_at(v, i), nexus__vec_at(v, v->count), v->elem_size);
+}
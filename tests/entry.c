@@ -1,11 +1,34 @@
 /* tests/entry.c */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "nexus/nexus.h"
+#include "nexus/nexus_arena.h"
+#include "nexus/nexus_pool.h"
+#include "nexus/nexus_mem_snapshot.h"
+#include "nexus/nexus_mem_stats.h"
+#include "nexus/nexus_simd.h"
+#include "nexus/nexus_soa.h"
+#include "nexus/nexus_vec.h"
+#include "nexus/nexus_hashmap.h"
+#include "nexus/nexus_hash.h"
+#include "nexus/nexus_sync.h"
+#include "nexus/nexus_jobs.h"
+#include "nexus/nexus_profile.h"
+#include "nexus/nexus_file.h"
 #include "nexus/nexus_build_config.h"
 
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
 /* Pretty-print helpers */
 static const char* yesno(int v) { return v ? "ON " : "OFF"; }
 
@@ -44,6 +67,14 @@ static void show_configuration(void) {
                NEXUS_CFG_PP_MEMORY_DEBUG,
                (int){NEXUS_CFG_CMAKE_MEMORY_DEBUG});
 
+    print_rule("MEMORY_STATS",
+               NEXUS_CFG_PP_MEMORY_STATS,
+               (int){NEXUS_CFG_CMAKE_MEMORY_STATS});
+
+    print_rule("PROFILE",
+               NEXUS_CFG_PP_PROFILE,
+               (int){NEXUS_CFG_CMAKE_PROFILE});
+
     print_rule("OVERRIDE_ALLOC",
                NEXUS_CFG_PP_OVERRIDE_ALLOC,
                (int){NEXUS_CFG_CMAKE_OVERRIDE_ALLOC});
@@ -77,33 +108,397 @@ static int run_basic_api_tests(void) {
     return ok;
 }
 
-static void exercise_memory_debug(void) {
+#if defined(NEXUS_MEMORY_DEBUG)
+/* Worker for the cross-thread test: frees blocks another thread allocated,
+   then allocates its own. */
+enum { XT_COUNT = 2000 };
+static void* xt_blocks[XT_COUNT];
+
+#if defined(_WIN32)
+static DWORD WINAPI xt_worker(LPVOID arg)
+#else
+static void* xt_worker(void* arg)
+#endif
+{
+    size_t i;
+    (void)arg;
+    for (i = 0; i < XT_COUNT; ++i) NEXUS_FREE(xt_blocks[i]);
+    for (i = 0; i < XT_COUNT; ++i) xt_blocks[i] = NEXUS_ALLOC(24);
+    return 0;
+}
+
+static int run_on_thread(void) {
+#if defined(_WIN32)
+    HANDLE t = CreateThread(NULL, 0, xt_worker, NULL, 0, NULL);
+    if (!t) return 0;
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+    return 1;
+#else
+    pthread_t t;
+    if (pthread_create(&t, NULL, xt_worker, NULL) != 0) return 0;
+    return pthread_join(t, NULL) == 0;
+#endif
+}
+
+/* Shared allocation helper: one file:line, reached along different call paths. */
+static void* stack_helper(size_t n) {
+    return nexus_debug_mem_malloc(n, __FILE__, __LINE__);
+}
+
+static void* stack_path_a(void) { return stack_helper(24); }
+static void* stack_path_b(void) { return stack_helper(40); }
+#endif
+
+static int exercise_memory_debug(void) {
+    int ok = 1;
 #if defined(NEXUS_MEMORY_DEBUG)
     puts("[memdbg] NEXUS_MEMORY_DEBUG is ON -- exercising debug allocator.");
 
     /* If your implementation needs locks, pass function pointers; we keep it NULL for simplicity. */
     nexus_debug_memory_init(NULL, NULL, NULL);
 
+    /* Consumption tracks live bytes through an alloc / free pair. */
+    {
+        size_t before = nexus_debug_mem_consumption();
+        void* p = nexus_debug_mem_malloc(1000, __FILE__, __LINE__);
+        if (nexus_debug_mem_consumption() != before + 1000u) ok = 0;
+        nexus_debug_mem_free(p);
+        if (!ok || nexus_debug_mem_consumption() != before) {
+            fprintf(stderr, "[memdbg] consumption miscounted a 1000-byte block\n");
+            ok = 0;
+        }
+    }
+
     /* Allocate, touch, and free to verify the hooks are wired. */
     {
         const size_t n = 128;
+        size_t i;
         unsigned char* p = NEXUS_ALLOC(n);
         if (!p) {
             fprintf(stderr, "[memdbg] NEXUS_ALLOC(%lu) returned NULL\n", (unsigned long)n);
         } else {
             /* Touch within bounds */
-            for (size_t i = 0; i < n; ++i) p[i] = (unsigned char)i;
+            for (i = 0; i < n; ++i) p[i] = (unsigned char)i;
             p = (unsigned char*)NEXUS_REALLOC(p, n * 2);
             if (!p) {
                 fprintf(stderr, "[memdbg] NEXUS_REALLOC failed\n");
             } else {
                 /* Touch the extended part */
-                for (size_t i = 0; i < n * 2; ++i) (void)p[i];
+                for (i = 0; i < n * 2; ++i) (void)p[i];
             }
             NEXUS_FREE(p);
         }
     }
 
+    /* Grow a buffer a byte at a time and shrink it back; contents and guards must survive. */
+    {
+        unsigned char* buf = NULL;
+        size_t i, n;
+        for (n = 1; ok && n <= 4096; ++n) {
+            buf = (unsigned char*)NEXUS_REALLOC(buf, n);
+            buf[n - 1] = (unsigned char)(n - 1);
+            for (i = 0; i < n; i += 97) {
+                if (buf[i] != (unsigned char)i) { ok = 0; break; }
+            }
+        }
+        for (n = 4096; ok && n > 0; n /= 2) buf = (unsigned char*)NEXUS_REALLOC(buf, n);
+        if (!ok || buf[0] != 0u || nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] in-place realloc lost data or guards\n");
+            ok = 0;
+        }
+        NEXUS_FREE(buf);
+    }
+
+    /* Aligned blocks: honour the alignment and keep a working tail guard. */
+    {
+        static const size_t aligns[] = { 1, 16, 32, 64, 4096 };
+        unsigned char* p;
+        unsigned char saved;
+        size_t i;
+        for (i = 0; ok && i < sizeof aligns / sizeof aligns[0]; ++i) {
+            p = (unsigned char*)NEXUS_ALLOC_ALIGNED(100, aligns[i]);
+            if (!p || ((size_t)p & (aligns[i] - 1u)) != 0u) ok = 0;
+            else {
+                memset(p, 0x5A, 100);
+                NEXUS_FREE_ALIGNED(p);
+            }
+        }
+        p = (unsigned char*)NEXUS_ALLOC_ALIGNED(40, 64);
+        saved = p[40];
+        p[40] = (unsigned char)(saved ^ 0xFFu);
+        puts("[memdbg] expecting one overshoot report:");
+        if (!nexus_debug_memory()) ok = 0;
+        p[40] = saved;
+        if (nexus_debug_memory()) ok = 0;
+        NEXUS_FREE_ALIGNED(p);
+        if (!ok) fprintf(stderr, "[memdbg] aligned allocation checks failed\n");
+    }
+
+    /* Page guards: large blocks sit against a protected page; the slack in
+       front of it is still checked, and blocks over budget fall back. */
+    {
+        enum { COUNT = 8, SIZE = 5000 };
+        unsigned char* blocks[COUNT];
+        unsigned char saved;
+        size_t i;
+        nexus_debug_mem_set_page_guard(4096, 4 * 16384);
+        for (i = 0; i < COUNT; ++i) {
+            blocks[i] = (unsigned char*)NEXUS_ALLOC(SIZE);
+            memset(blocks[i], (int)i, SIZE);
+        }
+        saved = blocks[0][SIZE];   /* SIZE is not a multiple of 16: slack follows */
+        blocks[0][SIZE] = (unsigned char)(saved ^ 0xFFu);
+        puts("[memdbg] expecting one overshoot report:");
+        if (!nexus_debug_memory()) ok = 0;
+        blocks[0][SIZE] = saved;
+        blocks[1] = (unsigned char*)NEXUS_REALLOC(blocks[1], 2 * SIZE);
+        blocks[1][2 * SIZE - 1] = 1u;
+        if (blocks[1][SIZE - 1] != 1u) ok = 0;
+        for (i = 0; i < COUNT; ++i) NEXUS_FREE(blocks[i]);
+        nexus_debug_mem_set_page_guard(0, 0);
+        if (!ok || nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] page guard checks failed\n");
+            ok = 0;
+        }
+    }
+
+    /* Quarantine: freed blocks stay poisoned until evicted; a write after
+       free is reported at eviction, and everything drains when turned off.
+       A realloc that moves leaves its old block in the quarantine too. */
+    {
+        enum { COUNT = 64 };
+        unsigned char* blocks[COUNT];
+        unsigned char* victim;
+        unsigned char* moved;
+        size_t i, errors = nexus_debug_mem_quarantine_errors();
+        nexus_debug_mem_set_quarantine(64 * 1024);
+        victim = (unsigned char*)NEXUS_ALLOC(48);
+        NEXUS_FREE(victim);
+        for (i = 0; i < COUNT; ++i) blocks[i] = (unsigned char*)NEXUS_ALLOC(100 + i);
+        for (i = 0; i < COUNT; ++i) NEXUS_FREE(blocks[i]);
+        if (victim[0] != 0xDDu || victim[47] != 0xDDu) ok = 0;   /* still parked */
+        victim[7] = 1u;
+        puts("[memdbg] expecting one write-after-free report:");
+        nexus_debug_mem_set_quarantine(0);
+        if (nexus_debug_mem_quarantine_errors() != errors + 1u) {
+            fprintf(stderr, "[memdbg] write after free went unreported\n");
+            ok = 0;
+        }
+
+        nexus_debug_mem_set_quarantine(64 * 1024);
+        victim = (unsigned char*)NEXUS_ALLOC(48);
+        memset(victim, 0x5A, 48);
+        moved = (unsigned char*)NEXUS_REALLOC(victim, 64);
+        if (!moved || moved == victim || moved[47] != 0x5Au || victim[0] != 0xDDu) ok = 0;
+        victim[3] = 1u;
+        puts("[memdbg] expecting one write-after-realloc report:");
+        nexus_debug_mem_set_quarantine(0);
+        if (nexus_debug_mem_quarantine_errors() != errors + 2u) {
+            fprintf(stderr, "[memdbg] write after realloc went unreported\n");
+            ok = 0;
+        }
+        NEXUS_FREE(moved);
+        if (!ok || nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] quarantine checks failed\n");
+            ok = 0;
+        }
+    }
+
+    /* Stack capture: two call paths into one helper are separate sites in the
+       report, and fold back into one file:line site in snapshots. */
+    {
+        void* a;
+        void* b;
+        nexus_mem_snapshot* snap;
+        unsigned i, found = 0u;
+        nexus_debug_mem_set_stack_depth(8);
+        a = stack_path_a();
+        b = stack_path_b();
+        puts("[memdbg] report with call stacks:");
+        nexus_debug_mem_print(0);
+        snap = nexus_debug_mem_snapshot();
+        for (i = 0; snap && i < snap->site_count; ++i) {
+            const nexus_mem_snapshot_site* s = &snap->sites[i];
+            if (strcmp(s->file, __FILE__) == 0 && s->live_count == 2u && s->bytes_live == 64u) found = 1u;
+        }
+        nexus_mem_snapshot_free(snap);
+        nexus_debug_mem_free(a);
+        nexus_debug_mem_free(b);
+        nexus_debug_mem_set_stack_depth(0);
+        if (!found || nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] stack-attributed sites did not fold in the snapshot\n");
+            ok = 0;
+        }
+    }
+
+    /* Incremental checker: a damaged guard is found within one lap of small steps. */
+    {
+        enum { COUNT = 100 };
+        unsigned char* blocks[COUNT];
+        unsigned char saved;
+        size_t i;
+        int found = 0;
+        for (i = 0; i < COUNT; ++i) blocks[i] = NEXUS_ALLOC(24);
+        saved = blocks[COUNT / 2][24];
+        blocks[COUNT / 2][24] = (unsigned char)(saved ^ 0xFFu);   /* one-byte overrun */
+        puts("[memdbg] expecting one overshoot report:");
+        for (i = 0; i < 2 * COUNT && !found; ++i) found = nexus_debug_memory_step(8);
+        blocks[COUNT / 2][24] = saved;
+        if (!found || nexus_debug_memory_step(COUNT * 2)) {
+            fprintf(stderr, "[memdbg] incremental guard check missed or misreported\n");
+            ok = 0;
+        }
+        if (!nexus_debug_memory_checker_start(1, 64) || nexus_debug_memory_checker_stop()) {
+            fprintf(stderr, "[memdbg] background checker failed\n");
+            ok = 0;
+        }
+        for (i = 0; i < COUNT; ++i) NEXUS_FREE(blocks[i]);
+    }
+
+    /* Free many blocks from one site out of order; exercises header slot fix-ups. */
+    {
+        enum { COUNT = 1000 };
+        void* blocks[COUNT];
+        size_t i;
+        for (i = 0; i < COUNT; ++i) blocks[i] = NEXUS_ALLOC(16 + i % 64);
+        for (i = 0; i < COUNT; i += 2) NEXUS_FREE(blocks[i]);
+        for (i = 1; i < COUNT; i += 2) NEXUS_FREE(blocks[COUNT - i]);
+        NEXUS_FREE(NULL);
+        if (nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] guard errors after out-of-order frees\n");
+            ok = 0;
+        }
+    }
+
+    /* More distinct sites than the old fixed table held; every block must stay tracked. */
+    {
+        enum { SITES = 3000 };
+        static void* blocks[SITES];
+        char file_copy[1024];
+        unsigned i;
+        strncpy(file_copy, __FILE__, sizeof file_copy - 1);
+        file_copy[sizeof file_copy - 1] = '\0';
+        for (i = 0; i < SITES; ++i) {
+            /* Alternate literal and copied names: same site, different pointers. */
+            blocks[i] = nexus_debug_mem_malloc(8, (i & 1u) ? file_copy : __FILE__, 100000u + i / 2u);
+        }
+        for (i = 0; i < SITES; ++i) nexus_debug_mem_free(blocks[i]);
+        if (nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] guard errors after many-site allocations\n");
+            ok = 0;
+        }
+    }
+
+    /* Cross-thread frees in both directions go through the remote hand-off. */
+    {
+        size_t i;
+        for (i = 0; i < XT_COUNT; ++i) xt_blocks[i] = NEXUS_ALLOC(40 + i % 16);
+        if (!run_on_thread()) {
+            fprintf(stderr, "[memdbg] could not start worker thread\n");
+            ok = 0;
+        }
+        for (i = 0; i < XT_COUNT; ++i) NEXUS_FREE(xt_blocks[i]);
+        if (nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] guard errors after cross-thread frees\n");
+            ok = 0;
+        }
+    }
+
+    /* Sampling: most blocks bypass tracking, all of them must still free/realloc cleanly. */
+    {
+        enum { COUNT = 4000 };
+        static void* blocks[COUNT];
+        size_t i, before, live = 0;
+        nexus_debug_mem_set_sample_rate(1024);
+        before = nexus_debug_mem_consumption();
+        for (i = 0; i < COUNT; ++i) blocks[i] = NEXUS_ALLOC(32 + i % 200);
+        for (i = 0; i < COUNT; i += 3) blocks[i] = NEXUS_REALLOC(blocks[i], 500);
+        for (i = 0; i < COUNT; ++i) live += i % 3 ? 32 + i % 200 : 500;
+        puts("[memdbg] sampled report:");
+        nexus_debug_mem_print(1);
+        /* About 1000 samples over ~1 MiB keep the estimate within a few
+           percent of the true live bytes (spread about 6%, mostly from the
+           grown blocks), so 25% off means a biased estimator. The stats
+           front end adds a header to every block, so its builds count more. */
+#if !defined(NEXUS_MEMORY_STATS)
+        {
+            size_t est = nexus_debug_mem_consumption() - before;
+            if (est < live - live / 4 || est > live + live / 4) {
+                fprintf(stderr, "[memdbg] sampled estimate %lu bytes, %lu live\n",
+                        (unsigned long)est, (unsigned long)live);
+                ok = 0;
+            }
+        }
+#else
+        (void)before;
+        (void)live;
+#endif
+        for (i = 0; i < COUNT; ++i) NEXUS_FREE(blocks[i]);
+        nexus_debug_mem_set_sample_rate(0);
+        if (nexus_debug_memory()) {
+            fprintf(stderr, "[memdbg] guard errors with sampling\n");
+            ok = 0;
+        }
+    }
+
+    /* Blocks tracked whatever the sampler says (aligned, page-guarded)
+       count their exact size, not a sampled estimate. */
+    {
+        size_t before;
+        void* p;
+        nexus_debug_mem_set_sample_rate(512 * 1024);
+        before = nexus_debug_mem_consumption();
+        p = nexus_debug_mem_malloc_aligned(4096, 64, __FILE__, __LINE__);
+        if (nexus_debug_mem_consumption() != before + 4096u) {
+            fprintf(stderr, "[memdbg] aligned block counted as %lu bytes under sampling\n",
+                    (unsigned long)(nexus_debug_mem_consumption() - before));
+            ok = 0;
+        }
+        nexus_debug_mem_free_aligned(p);
+
+        nexus_debug_mem_set_page_guard(4096, 0);
+        before = nexus_debug_mem_consumption();
+        p = nexus_debug_mem_malloc(8192, __FILE__, __LINE__);
+        if (nexus_debug_mem_consumption() != before + 8192u) {
+            fprintf(stderr, "[memdbg] page-guarded block counted as %lu bytes under sampling\n",
+                    (unsigned long)(nexus_debug_mem_consumption() - before));
+            ok = 0;
+        }
+        nexus_debug_mem_free(p);
+        nexus_debug_mem_set_page_guard(0, 0);
+        nexus_debug_mem_set_sample_rate(0);
+    }
+
+    /* Snapshot round-trip: live blocks show up under their site and survive write/read. */
+    {
+        enum { COUNT = 10 };
+        void* blocks[COUNT];
+        nexus_mem_snapshot* snap;
+        nexus_mem_snapshot* back = NULL;
+        const char* path = "nexus_test.nxsnap";
+        unsigned i, site_line = (unsigned)__LINE__, found = 0u;
+        for (i = 0; i < COUNT; ++i)
+            blocks[i] = nexus_debug_mem_malloc(100, __FILE__, site_line);
+        snap = nexus_debug_mem_snapshot();
+        if (snap && nexus_mem_snapshot_write(snap, path) == 0) back = nexus_mem_snapshot_read(path);
+        if (back && back->alloc_count == snap->alloc_count && back->site_count == snap->site_count) {
+            for (i = 0; i < back->site_count; ++i) {
+                const nexus_mem_snapshot_site* s = &back->sites[i];
+                if (s->line == site_line && strcmp(s->file, __FILE__) == 0
+                    && s->live_count == COUNT && s->bytes_live == COUNT * 100u) found = 1u;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "[memdbg] heap snapshot round-trip failed\n");
+            ok = 0;
+        }
+        nexus_mem_snapshot_free(snap);
+        nexus_mem_snapshot_free(back);
+        remove(path);
+        for (i = 0; i < COUNT; ++i) nexus_debug_mem_free(blocks[i]);
+    }
+
     /* Optional: demonstrate outstanding allocation reporting (allocate and free) */
     {
         void* leak = NEXUS_ALLOC(64);
@@ -125,6 +520,7 @@ static void exercise_memory_debug(void) {
     {
         NEXUS_BOOL bad = nexus_debug_memory();
         printf("[memdbg] guard/corruption check: %s\n", bad ? "ISSUES DETECTED" : "OK");
+        if (bad) ok = 0;
     }
 
     /* Reset internal tables (optional, depends on your implementation) */
@@ -133,6 +529,945 @@ static void exercise_memory_debug(void) {
 #else
     puts("[memdbg] NEXUS_MEMORY_DEBUG is OFF — skipping allocator tests.");
 #endif
+    return ok;
+}
+
+static int run_arena_tests(void) {
+    int ok = 1;
+    nexus_arena arena;
+    nexus_arena_mark mark;
+    unsigned char* a;
+    unsigned char* b;
+    size_t i;
+
+    NEXUS_ARENA_INIT(&arena, 256);
+
+    a = nexus_arena_alloc(&arena, 10);
+    b = nexus_arena_alloc(&arena, 10);
+    if (!a || !b || ((size_t)a % NEXUS_ARENA_ALIGN) || ((size_t)b % NEXUS_ARENA_ALIGN) || b < a + 10) {
+        fprintf(stderr, "[arena] bump allocations overlap or are misaligned\n");
+        ok = 0;
+    }
+
+    mark = nexus_arena_get_mark(&arena);
+    for (i = 0; i < 100; ++i) {
+        unsigned char* p = nexus_arena_alloc(&arena, 40);   /* spills into chained blocks */
+        if (!p) { ok = 0; break; }
+        memset(p, (int)i, 40);
+    }
+    if (!nexus_arena_alloc(&arena, 4096)) ok = 0;        /* oversized: dedicated block */
+    if (nexus_arena_alloc_aligned(&arena, 8, 64) == NULL
+        || ((size_t)nexus_arena_alloc_aligned(&arena, 8, 64) % 64) != 0) {
+        fprintf(stderr, "[arena] aligned allocation failed\n");
+        ok = 0;
+    }
+
+    nexus_arena_rewind(&arena, mark);
+    if (nexus_arena_used(&arena) != mark.used || nexus_arena_alloc(&arena, 10) != b + NEXUS_ARENA_ALIGN) {
+        fprintf(stderr, "[arena] rewind did not restore the mark\n");
+        ok = 0;
+    }
+
+    nexus_arena_reset(&arena);
+    if (nexus_arena_used(&arena) != 0 || nexus_arena_alloc(&arena, 10) != a) {
+        fprintf(stderr, "[arena] reset did not reuse the newest block\n");
+        ok = 0;
+    }
+
+#if defined(NEXUS_MEMORY_DEBUG)
+    if (nexus_debug_memory()) {
+        fprintf(stderr, "[arena] guard errors on arena blocks\n");
+        ok = 0;
+    }
+#endif
+    nexus_arena_free(&arena);
+    return ok;
+}
+
+static int run_pool_tests(void) {
+    enum { COUNT = 1000 };
+    static unsigned* objs[COUNT];
+    NexusAllocator pool_vt;
+    const NexusAllocator* prev;
+    int ok = 1;
+    size_t i;
+    nexus_pool* pool = NEXUS_POOL_CREATE(sizeof(unsigned) * 3, 100);
+
+    if (!pool) return 0;
+    for (i = 0; i < COUNT; ++i) {
+        objs[i] = nexus_pool_alloc(pool);
+        if (!objs[i]) { ok = 0; break; }
+        objs[i][0] = objs[i][2] = (unsigned)i;
+    }
+    for (i = 0; ok && i < COUNT; ++i) {
+        if (objs[i][0] != i || objs[i][2] != i) {
+            fprintf(stderr, "[pool] object %lu was overwritten\n", (unsigned long)i);
+            ok = 0;
+        }
+    }
+    for (i = 0; ok && i < COUNT; i += 2) nexus_pool_free(pool, objs[i]);
+    for (i = 0; ok && i < COUNT; i += 2) objs[i] = nexus_pool_alloc(pool);  /* recycled */
+    for (i = 0; ok && i < COUNT; ++i) nexus_pool_free(pool, objs[i]);
+    nexus_pool_flush(pool);
+
+#if defined(NEXUS_MEMORY_DEBUG)
+    if (nexus_debug_memory()) {
+        fprintf(stderr, "[pool] guard errors on pool slabs\n");
+        ok = 0;
+    }
+#endif
+    nexus_pool_destroy(pool);
+
+    /* Installed pool vtable: NEXUS_ALLOC serves from the pool while slabs
+       still come from the parent captured at creation, and destroy hands
+       them back there with the vtable still installed. */
+    pool = NEXUS_POOL_CREATE(32, 8);
+    if (!pool) return 0;
+    nexus_pool_allocator(pool, &pool_vt);
+    prev = nexus_allocator_set_thread(&pool_vt);
+    for (i = 0; i < 100u; ++i) {
+        objs[i] = (unsigned*)NEXUS_ALLOC(16);
+        if (!objs[i]) { ok = 0; break; }
+        objs[i][0] = objs[i][3] = (unsigned)i;
+    }
+    for (i = 0; ok && i < 100u; ++i) {
+        if (objs[i][0] != i || objs[i][3] != i) ok = 0;
+        NEXUS_FREE(objs[i]);
+    }
+    if (!ok) fprintf(stderr, "[pool] installed pool vtable failed to allocate\n");
+    nexus_pool_destroy(pool);
+    nexus_allocator_set_thread(prev);
+    return ok;
+}
+
+static unsigned counting_allocs = 0u;
+static unsigned counting_frees  = 0u;
+
+static void* counting_alloc(void* ctx, size_t n, const char* file, unsigned line) {
+    const NexusAllocator* inner = (const NexusAllocator*)ctx;
+    counting_allocs += 1u;
+    return inner->allocate(inner->ctx, n, file, line);
+}
+
+static void counting_free(void* ctx, void* p) {
+    const NexusAllocator* inner = (const NexusAllocator*)ctx;
+    counting_frees += 1u;
+    inner->deallocate(inner->ctx, p);
+}
+
+static int run_allocator_tests(void) {
+    NexusAllocator counting = { counting_alloc, counting_free, NULL, NULL, NULL, NULL };
+    NexusAllocator arena_vt;
+    nexus_arena arena;
+    const NexusAllocator* prev;
+    char* p;
+    unsigned i, allocs, frees;
+    int ok = 1;
+
+    /* Thread-installed allocator takes over NEXUS_ALLOC */
+    counting.ctx = (void*)nexus_allocator_system();
+    prev = nexus_allocator_set_thread(&counting);
+    p = (char*)NEXUS_ALLOC(64);
+    if (!p || counting_allocs != 1u || nexus_allocator_current() != &counting) ok = 0;
+    if (NEXUS_REALLOC(p, 128) != NULL) ok = 0;   /* no reallocate in the vtable */
+    NEXUS_FREE(p);
+    nexus_allocator_set_thread(prev);
+    if (nexus_allocator_installed != 0u) ok = 0;
+
+    /* Arena adapter: frees are no-ops, the newest block grows in place */
+    NEXUS_ARENA_INIT(&arena, 1024);
+    nexus_arena_allocator(&arena, &arena_vt);
+    p = (char*)NEXUS_ALLOCATOR_ALLOC(&arena_vt, 10);
+    if (!p) ok = 0;
+    else {
+        memcpy(p, "arena-vt", 9);
+        if (NEXUS_ALLOCATOR_REALLOC(&arena_vt, p, 100) != p || strcmp(p, "arena-vt") != 0) ok = 0;
+        NEXUS_ALLOCATOR_FREE(&arena_vt, p);
+    }
+    nexus_arena_free(&arena);
+
+    /* Installed arena vtable: NEXUS_ALLOC bump-allocates, and growth still
+       goes to the parent captured at init instead of back into the arena. */
+    NEXUS_ARENA_INIT(&arena, 1024);
+    nexus_arena_allocator(&arena, &arena_vt);
+    prev = nexus_allocator_set_thread(&arena_vt);
+    for (i = 0; i < 64u; ++i) {
+        p = (char*)NEXUS_ALLOC(200);
+        if (!p) { ok = 0; break; }
+        memset(p, (int)i, 200);
+        NEXUS_FREE(p);
+    }
+    nexus_allocator_set_thread(prev);
+    if (nexus_arena_used(&arena) < 64u * 200u) ok = 0;
+    nexus_arena_free(&arena);
+
+    /* Blocks go back to the allocator that produced them, whatever is
+       installed by the time they are released. */
+    prev = nexus_allocator_set_thread(&counting);
+    NEXUS_ARENA_INIT(&arena, 1024);
+    nexus_allocator_set_thread(prev);
+    allocs = counting_allocs;
+    frees  = counting_frees;
+    if (!nexus_arena_alloc(&arena, 10) || !nexus_arena_alloc(&arena, 2000)) ok = 0;
+    nexus_arena_free(&arena);
+    if (counting_allocs - allocs != 2u || counting_frees - frees != 2u) ok = 0;
+
+    /* Aligned through whatever backend is active */
+    p = (char*)NEXUS_ALLOC_ALIGNED(256, 64);
+    if (!p || ((size_t)p & 63u) != 0u) ok = 0;
+    else memset(p, 0, 256);
+    NEXUS_FREE_ALIGNED(p);
+    if (NEXUS_ALLOC_ALIGNED(16, 48) != NULL) ok = 0;   /* not a power of two */
+
+    if (!ok) fprintf(stderr, "[allocator] runtime allocator checks failed\n");
+    return ok;
+}
+
+static int run_mem_stats_tests(void) {
+    nexus_mem_stats before, after;
+    nexus_mem_stats_site sites[64];
+    nexus_u64 rate[NEXUS_MEM_STATS_RATE_SECONDS];
+    unsigned i, n;
+    int ok = 1, found = 0;
+    char* p;
+    char* q;
+
+    nexus_mem_stats_get(&before);
+    p = (char*)nexus_mem_stats_malloc(100, "stats_site.c", 7u);
+    q = (char*)nexus_mem_stats_malloc(3000, "stats_site.c", 8u);
+    if (!p || !q) return 0;
+    memset(p, 0x11, 100);
+    p = (char*)nexus_mem_stats_realloc(p, 200, "stats_site.c", 7u);
+    if (!p || p[99] != 0x11) ok = 0;
+
+    nexus_mem_stats_get(&after);
+    if (after.bytes_live - before.bytes_live != 3200u) ok = 0;
+    if (after.allocs_live - before.allocs_live != 2u) ok = 0;
+    if (after.alloc_total - before.alloc_total != 3u) ok = 0;
+    if (after.size_classes[7] - before.size_classes[7] != 1u) ok = 0;   /* 100 */
+    if (after.size_classes[8] - before.size_classes[8] != 1u) ok = 0;   /* 200 */
+    if (after.size_classes[12] - before.size_classes[12] != 1u) ok = 0; /* 3000 */
+    if (after.bytes_peak < after.bytes_live) ok = 0;
+
+    n = nexus_mem_stats_sites(sites, 64u);
+    for (i = 0; i < n; ++i) {
+        if (i && sites[i].bytes_live > sites[i - 1u].bytes_live) ok = 0;
+        if (sites[i].file && strcmp(sites[i].file, "stats_site.c") == 0 && sites[i].line == 7u) {
+            found = 1;
+            if (sites[i].bytes_live != 200u || sites[i].alloc_total != 2u || sites[i].free_total != 1u) ok = 0;
+        }
+    }
+    if (!found) ok = 0;
+    if (nexus_mem_stats_rate(rate, 1000u) != NEXUS_MEM_STATS_RATE_SECONDS - 1u) ok = 0;
+
+    nexus_mem_stats_free(p);
+    nexus_mem_stats_free(q);
+    nexus_mem_stats_get(&after);
+    if (after.bytes_live != before.bytes_live || after.allocs_live != before.allocs_live) ok = 0;
+
+    if (!ok) fprintf(stderr, "[mem_stats] counter checks failed\n");
+    return ok;
+}
+
+typedef struct {
+    unsigned soft_calls, hard_calls;
+    size_t   last_live;
+    void    *cache;        /* dropped under hard pressure */
+} BudgetTestState;
+
+static void budget_pressure(void *user, const nexus_mem_pressure *p) {
+    BudgetTestState *st = (BudgetTestState*)user;
+    st->last_live = p->bytes_live;
+    if (!p->hard) {
+        st->soft_calls += 1u;
+        return;
+    }
+    st->hard_calls += 1u;
+    nexus_mem_stats_free(st->cache);
+    st->cache = NULL;
+}
+
+static int run_mem_budget_tests(void) {
+    BudgetTestState st;
+    void *a, *b, *c, *d, *t1, *t2;
+    int site, tag, spec, ok = 1;
+
+    memset(&st, 0, sizeof st);
+    /* Bytes already live at the site count once the budget is set. */
+    a = nexus_mem_stats_malloc(400, "budget_site.c", 1u);
+    site = nexus_mem_budget_set("budget_site.c", 1u, 1000u, 2000u, budget_pressure, &st);
+    if (site <= 0 || nexus_mem_budget_live(site) != 400u) ok = 0;
+
+    st.cache = nexus_mem_stats_malloc(500, "budget_site.c", 1u);    /*  900 */
+    b = nexus_mem_stats_malloc(300, "budget_site.c", 1u);           /* 1200: crosses soft */
+    c = nexus_mem_stats_malloc(300, "budget_site.c", 1u);           /* 1500: already over */
+    if (!a || !st.cache || !b || !c || st.soft_calls != 1u || st.last_live != 1200u) ok = 0;
+
+    /* 1500 + 800 passes the hard limit; the callback drops the cache and it fits. */
+    d = nexus_mem_stats_malloc(800, "budget_site.c", 1u);
+    if (!d || st.hard_calls != 1u || st.cache || nexus_mem_budget_live(site) != 1800u) ok = 0;
+    /* Nothing left to drop: refused, and nothing charged. */
+    if (nexus_mem_stats_malloc(800, "budget_site.c", 1u) || st.hard_calls != 2u
+        || nexus_mem_budget_live(site) != 1800u) ok = 0;
+    /* A refused realloc leaves the block alone; shrinking always fits. */
+    if (nexus_mem_stats_realloc(d, 1100u, "budget_site.c", 1u) || nexus_mem_budget_live(site) != 1800u) ok = 0;
+    d = nexus_mem_stats_realloc(d, 100u, "budget_site.c", 1u);
+    if (!d || nexus_mem_budget_live(site) != 1100u) ok = 0;
+    /* Dropping below soft re-arms it. */
+    nexus_mem_stats_free(b);
+    nexus_mem_stats_free(c);
+    b = nexus_mem_stats_malloc(600, "budget_site.c", 1u);
+    if (!b || st.soft_calls != 2u || nexus_mem_budget_live(site) != 1100u) ok = 0;
+    if (!ok) fprintf(stderr, "[mem_budget] per-site budget checks failed\n");
+
+    /* Line 0 covers every site of a file, unless one has its own budget. */
+    tag = nexus_mem_budget_set("budget_tag.c", 0u, 0u, 1000u, NULL, NULL);
+    t1 = nexus_mem_stats_malloc(600, "budget_tag.c", 10u);
+    t2 = nexus_mem_stats_malloc(300, "budget_tag.c", 20u);
+    if (tag <= 0 || tag == site || !t1 || !t2 || nexus_mem_budget_live(tag) != 900u
+        || nexus_mem_stats_malloc(200, "budget_tag.c", 30u)) {
+        fprintf(stderr, "[mem_budget] per-file budget checks failed\n");
+        ok = 0;
+    }
+    spec = nexus_mem_budget_set("budget_tag.c", 20u, 0u, 0u, NULL, NULL);
+    if (spec <= 0 || nexus_mem_budget_live(spec) != 300u || nexus_mem_budget_live(tag) != 600u) {
+        fprintf(stderr, "[mem_budget] a site budget did not take over from its file\n");
+        ok = 0;
+    }
+
+    /* Process-wide: a 1-byte hard limit refuses everything. */
+    if (nexus_mem_budget_set(NULL, 0u, 0u, 1u, NULL, NULL) != 0
+        || nexus_mem_stats_malloc(64, "budget_global.c", 1u)) {
+        fprintf(stderr, "[mem_budget] process-wide budget checks failed\n");
+        ok = 0;
+    }
+    nexus_mem_budget_set(NULL, 0u, 0u, 0u, NULL, NULL);
+
+    nexus_mem_stats_free(a);
+    nexus_mem_stats_free(b);
+    nexus_mem_stats_free(d);
+    nexus_mem_stats_free(t1);
+    nexus_mem_stats_free(t2);
+    nexus_mem_budget_set("budget_site.c", 1u, 0u, 0u, NULL, NULL);
+    nexus_mem_budget_set("budget_tag.c", 0u, 0u, 0u, NULL, NULL);
+    if (nexus_mem_budget_live(site) || nexus_mem_budget_live(tag) || nexus_mem_budget_live(spec)) {
+        fprintf(stderr, "[mem_budget] budgets still charged after every block was freed\n");
+        ok = 0;
+    }
+    return ok;
+}
+
+static int simd_close(double got, double want) {
+    return fabs(got - want) <= 1e-4 * (1.0 + fabs(want));
+}
+
+/* Every level this machine runs against plain loops, over lengths that hit
+   the unrolled body, the single-vector loop and the scalar tail. */
+static int run_simd_tests(void) {
+    enum { N = 203 };
+    static float_real a[N], b[N], c[N], y[N], out[N];
+    nexus_simd_level best = nexus_simd_detect(), level;
+    size_t i, n;
+    int ok = 1;
+
+    for (i = 0; i < N; ++i) {
+        a[i] = (float_real)((double)((i * 37u) % 101u) / 16.0 - 3.0);
+        b[i] = (float_real)((double)((i * 11u) % 53u) / 8.0 - 3.0);
+        c[i] = (float_real)((double)i / 4.0);
+    }
+    printf("SIMD level      : %s\n", nexus_simd_level_name(best));
+
+    for (level = NEXUS_SIMD_SCALAR; level <= best; level = (nexus_simd_level)(level + 1)) {
+        if (nexus_simd_select(level) != level) continue;   /* level not built here */
+        for (n = 0; n <= N; n += (n < 40u ? 1u : 27u)) {
+            double dot = 0.0, sum = 0.0, lo = n ? a[0] : 0.0, hi = lo;
+            for (i = 0; i < n; ++i) {
+                dot += (double)a[i] * b[i];
+                sum += a[i];
+                if (a[i] < lo) lo = a[i];
+                if (a[i] > hi) hi = a[i];
+            }
+            if (!simd_close(nexus_simd_dot(a, b, n), dot)) ok = 0;
+            if (!simd_close(nexus_simd_sum(a, n), sum)) ok = 0;
+            if (nexus_simd_min(a, n) != (float_real)lo || nexus_simd_max(a, n) != (float_real)hi) ok = 0;
+
+            memcpy(y, c, sizeof y);
+            nexus_simd_axpy(y, (float_real)0.5, a, n);
+            nexus_simd_scale(out, b, (float_real)-2, n);
+            for (i = 0; i < N; ++i) {
+                if (y[i] != (i < n ? c[i] + (float_real)0.5 * a[i] : c[i])) ok = 0;
+                if (i < n && out[i] != (float_real)-2 * b[i]) ok = 0;
+            }
+            nexus_simd_fma(out, a, b, c, n);
+            for (i = 0; i < n; ++i) if (!simd_close(out[i], (double)a[i] * b[i] + c[i])) ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr, "[simd] %s kernels disagree with the reference\n", nexus_simd_level_name(level));
+            break;
+        }
+    }
+    nexus_simd_select(best);
+    if (nexus_simd_active() != best) ok = 0;
+    return ok;
+}
+
+/* SoA batches against per-element reference math, at every SIMD level;
+   37 elements leaves a partial vector of padding lanes. */
+static int run_soa_tests(void) {
+    enum { COUNT = 37 };
+    static const float_real xf[16] = { 0, -1, 0, 5,   1, 0, 0, -2,   0, 0, 2, 0.5f,   0, 0, 0, 1 };
+    nexus_simd_level best = nexus_simd_detect(), level;
+    nexus_vec3_soa v, t;
+    nexus_mat4_batch a, b;
+    float_real dots[COUNT], ma[16], mb[16], mc[16];
+    size_t i;
+    unsigned r, c;
+    int ok = 1;
+
+    for (level = NEXUS_SIMD_SCALAR; level <= best && ok; level = (nexus_simd_level)(level + 1)) {
+        if (nexus_simd_select(level) != level) continue;
+        NEXUS_VEC3_SOA_INIT(&v);
+        NEXUS_VEC3_SOA_INIT(&t);
+        for (i = 0; i < COUNT; ++i) {
+            if (!nexus_vec3_soa_push(&v, (float_real)i, (float_real)(i % 7u) - 3, (float_real)1 - (float_real)(i % 3u))) ok = 0;
+        }
+        if (!ok || v.capacity % NEXUS_SOA_LANES || ((size_t)v.y & (NEXUS_SOA_ALIGN - 1u))) ok = 0;
+
+        nexus_vec3_soa_dot(dots, &v, &v);
+        for (i = 0; ok && i < COUNT; ++i)
+            if (!simd_close(dots[i], (double)v.x[i] * v.x[i] + (double)v.y[i] * v.y[i] + (double)v.z[i] * v.z[i])) ok = 0;
+
+        /* Points get the translation, directions do not. */
+        if (!nexus_vec3_soa_transform(&t, &v, xf, (float_real)1)) ok = 0;
+        for (i = 0; ok && i < COUNT; ++i) {
+            if (!simd_close(t.x[i], -v.y[i] + 5.0) || !simd_close(t.y[i], v.x[i] - 2.0)
+                || !simd_close(t.z[i], 2.0 * v.z[i] + 0.5)) ok = 0;
+        }
+        if (!nexus_vec3_soa_transform(&v, &v, xf, (float_real)0)) ok = 0;   /* in place */
+        if (!simd_close(v.x[3], -0.0 - 0.0) || !simd_close(v.y[3], 3.0)) ok = 0;
+
+        v.x[0] = v.y[0] = v.z[0] = 0;
+        nexus_vec3_soa_normalize(&v);
+        nexus_vec3_soa_dot(dots, &v, &v);
+        if (v.x[0] != 0 || v.y[0] != 0 || v.z[0] != 0) ok = 0;
+        for (i = 1; ok && i < COUNT; ++i) if (!simd_close(dots[i], 1.0)) ok = 0;
+
+        /* Matrix batches: new matrices are identity; a_i * b_i written over a. */
+        NEXUS_MAT4_BATCH_INIT(&a);
+        NEXUS_MAT4_BATCH_INIT(&b);
+        if (!nexus_mat4_batch_resize(&a, COUNT) || !nexus_mat4_batch_resize(&b, COUNT)) ok = 0;
+        for (i = 0; ok && i < COUNT; ++i) {
+            for (r = 0; r < 16; ++r) {
+                ma[r] = (float_real)((i + r * 3u) % 11u) - 5;
+                mb[r] = (float_real)((i * 5u + r) % 7u) - 3;
+            }
+            if (i % 4u) nexus_mat4_batch_set(&a, i, ma);   /* every fourth a stays identity */
+            nexus_mat4_batch_set(&b, i, mb);
+        }
+        if (!nexus_mat4_batch_mul(&a, &a, &b)) ok = 0;
+        for (i = 0; ok && i < COUNT; ++i) {
+            for (r = 0; r < 16; ++r) {
+                ma[r] = (i % 4u) ? (float_real)((i + r * 3u) % 11u) - 5 : (float_real)(r % 5u == 0u);
+                mb[r] = (float_real)((i * 5u + r) % 7u) - 3;
+            }
+            nexus_mat4_batch_get(&a, i, mc);
+            for (r = 0; r < 4; ++r) {
+                for (c = 0; c < 4; ++c) {
+                    double e = (double)ma[4 * r] * mb[c] + (double)ma[4 * r + 1] * mb[4 + c]
+                             + (double)ma[4 * r + 2] * mb[8 + c] + (double)ma[4 * r + 3] * mb[12 + c];
+                    if (!simd_close(mc[4 * r + c], e)) ok = 0;
+                }
+            }
+        }
+        if (!nexus_mat4_batch_transform(&t, &b, &v, (float_real)1)) ok = 0;
+        for (i = 0; ok && i < COUNT; ++i) {
+            nexus_mat4_batch_get(&b, i, mb);
+            if (!simd_close(t.z[i], (double)mb[8] * v.x[i] + (double)mb[9] * v.y[i] + (double)mb[10] * v.z[i] + mb[11]))
+                ok = 0;
+        }
+        /* Too few matrices for the inputs: refused, outputs left alone. */
+        if (!nexus_mat4_batch_resize(&b, COUNT - 1)) ok = 0;
+        if (nexus_mat4_batch_mul(&a, &a, &b) || a.count != COUNT) ok = 0;
+        if (nexus_mat4_batch_transform(&t, &b, &v, (float_real)1) || t.count != COUNT) ok = 0;
+
+        nexus_mat4_batch_free(&a);
+        nexus_mat4_batch_free(&b);
+        nexus_vec3_soa_free(&v);
+        nexus_vec3_soa_free(&t);
+        if (!ok) fprintf(stderr, "[soa] %s batch operations disagree with the reference\n", nexus_simd_level_name(level));
+    }
+    nexus_simd_select(best);
+    return ok;
+}
+
+static int run_container_tests(void) {
+    enum { COUNT = 5000 };
+    nexus_vec v, av;
+    nexus_hashmap map, names, set;
+    nexus_arena arena;
+    NexusAllocator arena_alloc;
+    nexus_u32 k, val, *pv, sum = 0u, seen = 0u;
+    const void *key;
+    void *value;
+    size_t it, cap;
+    char buf[2][16];
+    const char *name;
+    int ok = 1;
+
+    /* nexus_vec: typed pushes, ordered and unordered removal, zeroing resize. */
+    NEXUS_VEC_INIT(&v, nexus_u32);
+    for (k = 0; k < COUNT; ++k) if (!NEXUS_VEC_PUSH(&v, nexus_u32, k)) ok = 0;
+    k = 77u;
+    if (!nexus_vec_insert(&v, 0u, &k) || NEXUS_VEC_AT(&v, nexus_u32, 0) != 77u || NEXUS_VEC_AT(&v, nexus_u32, 1) != 0u) ok = 0;
+    nexus_vec_remove(&v, 0u);
+    nexus_vec_remove_swap(&v, 0u);                       /* last element (COUNT-1) moves to 0 */
+    if (!nexus_vec_pop(&v, &k) || k != COUNT - 2u || v.count != COUNT - 2u
+        || NEXUS_VEC_AT(&v, nexus_u32, 0) != COUNT - 1u || NEXUS_VEC_AT(&v, nexus_u32, 1) != 1u) ok = 0;
+    if (!nexus_vec_resize(&v, COUNT + 10u) || NEXUS_VEC_AT(&v, nexus_u32, COUNT + 9u) != 0u) ok = 0;
+    if (!nexus_vec_append(&v, NEXUS_VEC_DATA(&v, nexus_u32), 0u)) ok = 0;
+    nexus_vec_free(&v);
+
+    /* Arena-backed: growth goes through the arena's reallocate. */
+    NEXUS_ARENA_INIT(&arena, 1024);
+    nexus_arena_allocator(&arena, &arena_alloc);
+    nexus_vec_init(&av, sizeof(double), &arena_alloc, __FILE__, __LINE__);
+    for (k = 0; k < 500u; ++k) if (!NEXUS_VEC_PUSH(&av, double, k * 0.5)) ok = 0;
+    if (NEXUS_VEC_AT(&av, double, 499) != 249.5 || nexus_arena_used(&arena) == 0u) ok = 0;
+    nexus_vec_free(&av);
+    nexus_arena_free(&arena);
+    if (!ok) fprintf(stderr, "[containers] nexus_vec operations gave wrong contents\n");
+
+    /* nexus_hashmap: insert, overwrite, remove half, re-add, iterate. */
+    NEXUS_HASHMAP_INIT(&map, nexus_u32, nexus_u32);
+    for (k = 0; k < COUNT; ++k) { val = k * 3u; if (!nexus_hashmap_put(&map, &k, &val)) ok = 0; }
+    for (k = 0; k < COUNT; k += 2u)  if (!nexus_hashmap_remove(&map, &k)) ok = 0;
+    if (nexus_hashmap_remove(&map, &k) || map.count != COUNT / 2u) ok = 0;
+    for (k = 0; k < COUNT; ++k) {
+        pv = NEXUS_HASHMAP_GET(&map, nexus_u32, &k);
+        if ((k & 1u) ? (!pv || *pv != k * 3u) : pv != NULL) { ok = 0; break; }
+    }
+    for (it = 0; nexus_hashmap_next(&map, &it, &key, &value); ++seen) {
+        memcpy(&k, key, sizeof k);
+        sum += *(nexus_u32*)value - k * 3u;
+    }
+    if (seen != map.count || sum != 0u) ok = 0;
+
+    /* Churn at a steady size: deleted marks are reclaimed, not grown around. */
+    cap = map.capacity;
+    for (k = COUNT; k < 40u * COUNT; ++k) {
+        nexus_u32 old = k - COUNT / 2u;
+        if (!nexus_hashmap_put(&map, &k, &k)) { ok = 0; break; }
+        if (old >= COUNT && !nexus_hashmap_remove(&map, &old)) { ok = 0; break; }
+    }
+    if (map.count != COUNT || map.capacity > 2u * cap) ok = 0;
+    nexus_hashmap_clear(&map);
+    k = 1u;
+    if (map.count || nexus_hashmap_get(&map, &k)) ok = 0;
+    nexus_hashmap_free(&map);
+
+    /* String keys compare by contents, not pointer. */
+    NEXUS_HASHMAP_INIT_STR(&names, int);
+    strcpy(buf[0], "nexus_vec.c");
+    strcpy(buf[1], "nexus_vec.c");
+    name = buf[0];
+    if (!nexus_hashmap_put(&names, &name, NULL)) ok = 0;
+    name = buf[1];
+    if (!nexus_hashmap_emplace(&names, &name, NULL) || names.count != 1u) ok = 0;
+
+    NEXUS_HASHSET_INIT(&set, nexus_u32);
+    if (!nexus_hashmap_reserve(&set, 1000u) || set.capacity < 1000u) ok = 0;
+    cap = set.capacity;
+    for (k = 0; k < 1000u; ++k) nexus_hashmap_put(&set, &k, NULL);
+    if (set.capacity != cap || set.count != 1000u) ok = 0;
+
+    nexus_hashmap_free(&names);
+    nexus_hashmap_free(&set);
+    if (!ok) fprintf(stderr, "[containers] nexus_hashmap operations gave wrong contents\n");
+    return ok;
+}
+
+/* Hashing: every length through the short, long and block paths, at every
+   alignment, plus seed / bit sensitivity and bucket spread. Interning:
+   equal contents get equal IDs and pointers, also when interned from
+   many jobs at once. */
+typedef struct {
+    nexus_str_id *ids;
+    unsigned      names;
+} HashTestState;
+
+static void hash_intern_range(void *arg, size_t begin, size_t end) {
+    HashTestState *st = (HashTestState*)arg;
+    char name[32];
+    size_t i;
+    for (i = begin; i < end; ++i) {
+        sprintf(name, "hash.test.%u", (unsigned)(i % st->names));
+        st->ids[i] = nexus_intern(name);
+    }
+}
+
+static int run_hash_tests(void) {
+    enum { BUF = 4200, LENS = 420, KEYS = 65536, BUCKETS = 256, JOBS_N = 8000, NAMES = 500 };
+    static nexus_u64 hashes[LENS];
+    static unsigned  buckets[2][BUCKETS];
+    nexus_u8 *data = (nexus_u8*)malloc(BUF), *copy = (nexus_u8*)malloc(BUF + 8);
+    nexus_str_id *ids = (nexus_str_id*)malloc(JOBS_N * sizeof *ids);
+    HashTestState st;
+    nexus_jobs *jobs;
+    nexus_str_id a, b;
+    size_t count, len;
+    char word[8];
+    unsigned i, j, off;
+    int ok = 1;
+
+    if (!data || !copy || !ids) {
+        fprintf(stderr, "[hash] out of memory\n");
+        free(data); free(copy); free(ids);
+        return 0;
+    }
+    for (i = 0; i < BUF; ++i) data[i] = (nexus_u8)(i * 131u + (i >> 8));
+
+    /* Lengths 0..299, then around the 1 KiB block boundary and beyond. */
+    for (i = 0; i < LENS && ok; ++i) {
+        len = i < 300u ? i : i < 400u ? 1000u + (i - 300u) : 4000u + (i - 400u) * 10u;
+        hashes[i] = nexus_hash_bytes(data, len, 0u);
+        for (off = 1; off < 8u; ++off) {
+            memcpy(copy + off, data, len);
+            if (nexus_hash_bytes(copy + off, len, 0u) != hashes[i]) {
+                fprintf(stderr, "[hash] %u bytes hash differently at offset %u\n", (unsigned)len, off);
+                ok = 0;
+                break;
+            }
+        }
+        if (len && nexus_hash_bytes(data, len, 1u) == hashes[i]) {
+            fprintf(stderr, "[hash] seed ignored for %u bytes\n", (unsigned)len);
+            ok = 0;
+        }
+    }
+    for (i = 0; i < LENS && ok; ++i) {
+        for (j = i + 1u; j < LENS; ++j) {
+            if (hashes[i] == hashes[j]) {
+                fprintf(stderr, "[hash] prefixes %u and %u collide\n", i, j);
+                ok = 0;
+                break;
+            }
+        }
+    }
+    /* Every sampled single-bit flip changes a long input's hash. */
+    for (i = 0; i < BUF * 8u && ok; i += 61u) {
+        nexus_u64 base = nexus_hash_bytes(data, BUF, 7u);
+        data[i / 8u] ^= (nexus_u8)(1u << (i % 8u));
+        if (nexus_hash_bytes(data, BUF, 7u) == base) {
+            fprintf(stderr, "[hash] flipping bit %u went unnoticed\n", i);
+            ok = 0;
+        }
+        data[i / 8u] ^= (nexus_u8)(1u << (i % 8u));
+    }
+    /* Sequential keys spread evenly over both the top and the bottom byte
+       (expected 256 per bucket, standard deviation 16). */
+    for (i = 0; i < KEYS; ++i) {
+        nexus_u64 h = nexus_hash_bytes(&i, sizeof i, 0u);
+        buckets[0][(unsigned)(h >> 56)] += 1u;
+        buckets[1][(unsigned)(h & 0xFFu)] += 1u;
+    }
+    for (i = 0; i < BUCKETS && ok; ++i) {
+        if (buckets[0][i] < 128u || buckets[0][i] > 384u || buckets[1][i] < 128u || buckets[1][i] > 384u) {
+            fprintf(stderr, "[hash] bucket %u holds %u / %u of %u keys\n", i, buckets[0][i], buckets[1][i], KEYS);
+            ok = 0;
+        }
+    }
+    if (nexus_hash_u64(0u) == 0u || nexus_hash_u64(1u) == nexus_hash_u64(2u) || nexus_hash_u32(0u) == 0u
+        || nexus_hash_combine(nexus_hash_u64(1u), 2u) == nexus_hash_combine(nexus_hash_u64(2u), 1u)
+        || nexus_hash_str("nexus", 0u) != nexus_hash_bytes("nexus", 5u, 0u)) {
+        fprintf(stderr, "[hash] integer mixers misbehave\n");
+        ok = 0;
+    }
+
+    /* Interning: contents, not addresses, decide the ID. */
+    count = nexus_intern_count();
+    strcpy(word, "nexus");
+    a = nexus_intern("nexus");
+    b = nexus_intern(word);
+    if (!a || a != b || nexus_intern_n("nexus_hash", 5u) != a || nexus_intern_str(a) == word
+        || strcmp(nexus_intern_str(a), "nexus") != 0 || nexus_intern_len(a) != 5u
+        || NEXUS_INTERN_CSTR(word) != nexus_intern_str(a) || nexus_intern_find(word, 5u) != a) {
+        fprintf(stderr, "[hash] equal strings interned to different handles\n");
+        ok = 0;
+    }
+    if (nexus_intern_find("hash.test.never", 15u) || nexus_intern(NULL) || nexus_intern_str(0u)
+        || !nexus_intern("") || strcmp(nexus_intern_str(nexus_intern("")), "") != 0
+        || nexus_intern_count() < count + 2u) {
+        fprintf(stderr, "[hash] interner lookup edge cases failed\n");
+        ok = 0;
+    }
+
+    st.ids   = ids;
+    st.names = NAMES;
+    jobs = NEXUS_JOBS_CREATE(3);
+    if (!jobs) {
+        fprintf(stderr, "[hash] could not start the worker pool\n");
+        ok = 0;
+    } else {
+        nexus_jobs_parallel_for(jobs, 0, JOBS_N, 16, hash_intern_range, &st);
+        nexus_jobs_destroy(jobs);
+        for (i = 0; i < JOBS_N && ok; ++i) {
+            char name[32];
+            sprintf(name, "hash.test.%u", i % NAMES);
+            if (!ids[i] || ids[i] != ids[i % NAMES] || strcmp(nexus_intern_str(ids[i]), name) != 0
+                || (i < NAMES && i && ids[i] == ids[i - 1u])) {
+                fprintf(stderr, "[hash] concurrent interning gave a wrong ID for %s\n", name);
+                ok = 0;
+            }
+        }
+    }
+
+    free(data);
+    free(copy);
+    free(ids);
+    return ok;
+}
+
+/* Job system: parallel-for coverage, recursive fan-out that waits inside
+   jobs (stealing + helping), and a futex mutex under contention. */
+typedef struct {
+    nexus_jobs       *jobs;
+    unsigned         *out;
+    nexus_mutex       lock;
+    unsigned long     locked_sum;
+    nexus_atomic_u32  leaves;
+} JobsTestState;
+
+static JobsTestState g_jobs_state;
+
+static void jobs_fill(void *arg, size_t begin, size_t end) {
+    JobsTestState *st = (JobsTestState*)arg;
+    size_t i;
+    for (i = begin; i < end; ++i) st->out[i] += (unsigned)i * 2u;
+    nexus_mutex_lock(&st->lock);
+    for (i = begin; i < end; ++i) st->locked_sum += (unsigned long)i;
+    nexus_mutex_unlock(&st->lock);
+}
+
+/* Splits into two children per level and waits for them. */
+static void jobs_tree(void *arg) {
+    size_t depth = (size_t)arg;
+    nexus_job_counter c = NEXUS_JOB_COUNTER_INIT;
+    if (!depth) { nexus_atomic_add_u32(&g_jobs_state.leaves, 1u); return; }
+    nexus_jobs_submit(g_jobs_state.jobs, jobs_tree, (void*)(depth - 1u), &c);
+    nexus_jobs_submit(g_jobs_state.jobs, jobs_tree, (void*)(depth - 1u), &c);
+    nexus_jobs_wait(g_jobs_state.jobs, &c);
+}
+
+static int run_jobs_tests(void) {
+    enum { COUNT = 100000, DEPTH = 12 };
+    JobsTestState *st = &g_jobs_state;
+    nexus_job_counter counter = NEXUS_JOB_COUNTER_INIT;
+    unsigned long expect = 0ul;
+    size_t i;
+    int round, ok = 1;
+
+    memset(st, 0, sizeof *st);
+    st->jobs = NEXUS_JOBS_CREATE(3);
+    st->out  = (unsigned*)calloc(COUNT, sizeof *st->out);
+    if (!st->jobs || !st->out || nexus_jobs_worker_count(st->jobs) != 3u
+        || nexus_jobs_worker_index(st->jobs) != -1) {
+        fprintf(stderr, "[jobs] could not start the worker pool\n");
+        nexus_jobs_destroy(st->jobs);
+        free(st->out);
+        return 0;
+    }
+
+    /* Twice through the same counter-free path, once with a tiny grain. */
+    nexus_jobs_parallel_for(st->jobs, 0, COUNT, 0, jobs_fill, st);
+    nexus_jobs_parallel_for(st->jobs, 0, COUNT, 7, jobs_fill, st);
+    for (i = 0; i < COUNT; ++i) {
+        expect += 2ul * (unsigned long)i;
+        if (st->out[i] != (unsigned)i * 4u) { ok = 0; break; }
+    }
+    if (!ok || st->locked_sum != expect) {
+        fprintf(stderr, "[jobs] parallel_for missed or repeated indices\n");
+        ok = 0;
+    }
+
+    for (round = 0; round < 3 && ok; ++round) {
+        nexus_atomic_store_u32(&st->leaves, 0u);
+        nexus_jobs_submit(st->jobs, jobs_tree, (void*)(size_t)DEPTH, &counter);
+        nexus_jobs_wait(st->jobs, &counter);
+        if (nexus_atomic_load_u32(&st->leaves) != (1u << DEPTH) || nexus_atomic_load_u32(&counter.pending)) {
+            fprintf(stderr, "[jobs] recursive jobs finished %u of %u leaves\n",
+                    (unsigned)nexus_atomic_load_u32(&st->leaves), 1u << DEPTH);
+            ok = 0;
+        }
+    }
+
+    /* Fire-and-forget jobs still run before destroy returns. */
+    nexus_atomic_store_u32(&st->leaves, 0u);
+    for (round = 0; round < 100; ++round) nexus_jobs_submit(st->jobs, jobs_tree, (void*)(size_t)0, NULL);
+    nexus_jobs_destroy(st->jobs);
+    if (nexus_atomic_load_u32(&st->leaves) != 100u) {
+        fprintf(stderr, "[jobs] destroy dropped queued jobs\n");
+        ok = 0;
+    }
+    free(st->out);
+    return ok;
+}
+
+/* Streams path in `chunk` pieces and checks it against `expect`. */
+static int file_stream_matches(const char *path, size_t chunk, const unsigned char *expect, size_t size) {
+    nexus_file_reader *r = NEXUS_FILE_READER_OPEN(path, chunk);
+    const void *p;
+    size_t n, at = 0u;
+    int ok = r != NULL;
+
+    while (ok && (p = nexus_file_reader_next(r, &n)) != NULL) {
+        if ((chunk && n > chunk) || at + n > size || memcmp(p, expect + at, n) != 0) ok = 0;
+        at += n;
+    }
+    if (ok && (at != size || nexus_file_reader_failed(r) || nexus_file_reader_next(r, &n) || n)) ok = 0;
+    nexus_file_reader_close(r);
+    return ok;
+}
+
+static int run_file_tests(void) {
+    enum { SIZE = 300006 };
+    const char *path = "nexus_file_test.bin";
+    unsigned char *expect = (unsigned char*)malloc(SIZE);
+    nexus_file_writer *w;
+    nexus_file_map map;
+    nexus_file_reader *r;
+    size_t i, n;
+    int ok = 1;
+
+    if (!expect) return 0;
+    for (i = 0; i < SIZE; ++i) expect[i] = (unsigned char)(i * 131u + (i >> 9));
+
+    /* 7-byte writes up to offset 100002 go through the buffer, the large one past it. */
+    w = NEXUS_FILE_WRITER_OPEN(path, 4096u);
+    for (i = 0; w && i < 100000u; i += 7u) nexus_file_writer_write(w, expect + i, 7u);
+    if (!w || !nexus_file_writer_write(w, expect + 100002u, SIZE - 100002u - 5u)
+        || !nexus_file_writer_write(w, expect + SIZE - 5u, 5u) || !nexus_file_writer_close(w)) {
+        fprintf(stderr, "[file] buffered writer failed\n");
+        free(expect);
+        return 0;
+    }
+    if (!nexus_file_map_open(&map, path, NEXUS_FILE_ADVICE_SEQUENTIAL) || map.size != SIZE
+        || memcmp(map.data, expect, SIZE) != 0) {
+        fprintf(stderr, "[file] mapped view does not match what was written\n");
+        ok = 0;
+    }
+    nexus_file_map_advise(&map, 4097u, 100u, NEXUS_FILE_ADVICE_WILLNEED);
+    nexus_file_map_advise(&map, SIZE - 1u, 100u, NEXUS_FILE_ADVICE_DONTNEED);
+    nexus_file_map_close(&map);
+    if (map.data || map.size) ok = 0;
+
+    /* A short last chunk, a chunk size dividing the file exactly, one chunk for all. */
+    if (!file_stream_matches(path, 4096u, expect, SIZE)
+        || !file_stream_matches(path, SIZE / 6u, expect, SIZE)
+        || !file_stream_matches(path, 0u, expect, SIZE)) {
+        fprintf(stderr, "[file] streaming reader returned the wrong bytes\n");
+        ok = 0;
+    }
+
+    /* Closing early must stop the reading thread. */
+    r = NEXUS_FILE_READER_OPEN(path, 1024u);
+    if (!r || !nexus_file_reader_next(r, &n) || n != 1024u) ok = 0;
+    nexus_file_reader_close(r);
+
+    /* Empty files map to nothing and stream nothing. */
+    w = NEXUS_FILE_WRITER_OPEN(path, 0u);
+    if (!w || !nexus_file_writer_close(w) || !nexus_file_map_open(&map, path, NEXUS_FILE_ADVICE_NORMAL)
+        || map.data || map.size || !file_stream_matches(path, 64u, expect, 0u)) {
+        fprintf(stderr, "[file] empty file handled wrongly\n");
+        ok = 0;
+    }
+    if (nexus_file_map_open(&map, "nexus_file_test.missing", NEXUS_FILE_ADVICE_NORMAL)
+        || NEXUS_FILE_READER_OPEN("nexus_file_test.missing", 0u)) {
+        fprintf(stderr, "[file] opening a missing file succeeded\n");
+        ok = 0;
+    }
+    remove(path);
+    free(expect);
+    return ok;
+}
+
+static int run_profile_tests(void) {
+    const char *path = "nexus_profile_test.json";
+    const char *expect[] = { "\"traceEvents\"", "\"ph\":\"B\"", "\"ph\":\"E\"",
+                             "\"profile.outer\"", "\"profile.inner\"", "\"thread_name\"",
+                             "\"alloc\"", "\"free\"", "\"heap\"" };
+    char *text = NULL;
+    void *block;
+    long size = 0;
+    FILE *f;
+    unsigned i;
+    int ok = 1;
+
+    /* Outside a session every call is a no-op. */
+    nexus_profile_begin("profile.ignored");
+    nexus_profile_end();
+    if (nexus_profile_active() || nexus_profile_stop()) {
+        fprintf(stderr, "[profile] stop without a session succeeded\n");
+        return 0;
+    }
+
+    if (!nexus_profile_start(path, 1u)) {
+        fprintf(stderr, "[profile] could not start a session\n");
+        return 0;
+    }
+    if (nexus_profile_start(path, 1u)) {
+        fprintf(stderr, "[profile] second start succeeded\n");
+        ok = 0;
+    }
+    nexus_profile_thread_name("tests \"main\"");
+    nexus_profile_begin("profile.outer");
+    NEXUS_PROFILE_ZONE("profile.macro");
+    nexus_profile_begin("profile.inner");
+    block = nexus_debug_mem_malloc(96, __FILE__, __LINE__);
+    block = nexus_debug_mem_realloc(block, 4096, __FILE__, __LINE__);
+    nexus_debug_mem_free(block);
+    nexus_profile_end();
+    NEXUS_PROFILE_ZONE_END();
+    nexus_profile_end();
+    if (!nexus_profile_stop() || nexus_profile_dropped() != 0u) {
+        fprintf(stderr, "[profile] session did not close cleanly\n");
+        ok = 0;
+    }
+
+    f = fopen(path, "rb");
+    if (f && fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        text = (char*)calloc((size_t)size + 1u, 1u);
+        if (text && fread(text, 1u, (size_t)size, f) != (size_t)size) size = 0;
+    }
+    if (f) fclose(f);
+    remove(path);
+    if (!text || size <= 0) {
+        fprintf(stderr, "[profile] could not read the trace back\n");
+        free(text);
+        return 0;
+    }
+    for (i = 0; i < sizeof expect / sizeof expect[0]; ++i) {
+        if (!strstr(text, expect[i])) {
+            fprintf(stderr, "[profile] trace is missing %s\n", expect[i]);
+            ok = 0;
+        }
+    }
+    if (!strstr(text, "tests \\\"main\\\"") || strstr(text, "profile.ignored")
+        || strcmp(text + size - 4, "\n]}\n") != 0) {
+        fprintf(stderr, "[profile] trace is malformed\n");
+        ok = 0;
+    }
+#ifdef NEXUS_PROFILE
+    if (!strstr(text, "\"profile.macro\"")) {
+        fprintf(stderr, "[profile] NEXUS_PROFILE_ZONE recorded nothing\n");
+        ok = 0;
+    }
+#else
+    if (strstr(text, "profile.macro")) {
+        fprintf(stderr, "[profile] NEXUS_PROFILE_ZONE recorded without NEXUS_PROFILE\n");
+        ok = 0;
+    }
+#endif
+    free(text);
+    return ok;
 }
 
 int main(void) {
@@ -142,7 +1477,57 @@ int main(void) {
         return EXIT_FAILURE;
     }
 
-    exercise_memory_debug();
+    if (!exercise_memory_debug()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_arena_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_pool_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_allocator_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_mem_stats_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_mem_budget_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_container_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_hash_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_file_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_jobs_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_profile_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_simd_tests()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!run_soa_tests()) {
+        return EXIT_FAILURE;
+    }
 
     puts("basic test passed");
     return EXIT_SUCCESS;
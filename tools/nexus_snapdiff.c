@@ -0,0 +1,146 @@
+/* nexus_snapdiff.c — per-site growth between two debug allocator heap snapshots
+ *
+ *   nexus_snapdiff [--top N] [--all] OLD.nxsnap NEW.nxsnap
+ *
+ * Sites are matched by file and line. Output is sorted by growth in live
+ * bytes (estimates when the snapshots were sampled); sites that did not
+ * change are omitted unless --all is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nexus/nexus_mem_snapshot.h"
+
+typedef struct {
+    const char *file;
+    unsigned    line;
+    double      bytes_old, bytes_new;
+    double      live_old, live_new;
+    double      allocs;           /* allocations made between the snapshots */
+} DiffRow;
+
+static int site_cmp(const nexus_mem_snapshot_site *a, const nexus_mem_snapshot_site *b)
+{
+    int c = strcmp(a->file, b->file);
+    if (c) return c;
+    return (a->line > b->line) - (a->line < b->line);
+}
+
+static int site_qsort_cmp(const void *a, const void *b)
+{
+    return site_cmp((const nexus_mem_snapshot_site*)a, (const nexus_mem_snapshot_site*)b);
+}
+
+static int row_cmp(const void *a, const void *b)
+{
+    const DiffRow *x = (const DiffRow*)a;
+    const DiffRow *y = (const DiffRow*)b;
+    double dx = x->bytes_new - x->bytes_old, dy = y->bytes_new - y->bytes_old;
+    return (dx < dy) - (dx > dy);   /* largest growth first */
+}
+
+/* Live-allocation count estimate: scaled like the byte estimate. */
+static double est_live(const nexus_mem_snapshot_site *s)
+{
+    if (!s->bytes_live) return (double)s->live_count;
+    return (double)s->live_count * (double)s->est_bytes_live / (double)s->bytes_live;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: nexus_snapdiff [--top N] [--all] OLD NEW\n");
+}
+
+int main(int argc, char **argv)
+{
+    nexus_mem_snapshot *old_snap, *new_snap;
+    const char *paths[2] = { NULL, NULL };
+    unsigned top = 25u, npaths = 0u, i, j, rows = 0u, shown = 0u;
+    int all = 0, a;
+    DiffRow *row;
+    double total_old = 0.0, total_new = 0.0;
+
+    for (a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--all") == 0) {
+            all = 1;
+        } else if (strcmp(argv[a], "--top") == 0 && a + 1 < argc) {
+            top = (unsigned)strtoul(argv[++a], NULL, 10);
+        } else if (argv[a][0] != '-' && npaths < 2u) {
+            paths[npaths++] = argv[a];
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (npaths != 2u) { usage(); return EXIT_FAILURE; }
+
+    old_snap = nexus_mem_snapshot_read(paths[0]);
+    if (!old_snap) {
+        fprintf(stderr, "nexus_snapdiff: cannot read snapshot %s\n", paths[0]);
+        return EXIT_FAILURE;
+    }
+    new_snap = nexus_mem_snapshot_read(paths[1]);
+    if (!new_snap) {
+        fprintf(stderr, "nexus_snapdiff: cannot read snapshot %s\n", paths[1]);
+        nexus_mem_snapshot_free(old_snap);
+        return EXIT_FAILURE;
+    }
+
+    row = (DiffRow*)calloc((size_t)old_snap->site_count + new_snap->site_count + 1u, sizeof *row);
+    if (!row) {
+        fprintf(stderr, "nexus_snapdiff: out of memory\n");
+        nexus_mem_snapshot_free(old_snap);
+        nexus_mem_snapshot_free(new_snap);
+        return EXIT_FAILURE;
+    }
+
+    /* Merge-join on (file, line); written snapshots are sorted already. */
+    qsort(old_snap->sites, old_snap->site_count, sizeof *old_snap->sites, site_qsort_cmp);
+    qsort(new_snap->sites, new_snap->site_count, sizeof *new_snap->sites, site_qsort_cmp);
+    for (i = 0, j = 0; i < old_snap->site_count || j < new_snap->site_count; ++rows) {
+        const nexus_mem_snapshot_site *o = i < old_snap->site_count ? &old_snap->sites[i] : NULL;
+        const nexus_mem_snapshot_site *n = j < new_snap->site_count ? &new_snap->sites[j] : NULL;
+        int c = !o ? 1 : !n ? -1 : site_cmp(o, n);
+        DiffRow *r = &row[rows];
+
+        if (c > 0) o = NULL; else ++i;
+        if (c < 0) n = NULL; else ++j;
+        r->file = o ? o->file : n->file;
+        r->line = o ? o->line : n->line;
+        if (o) {
+            r->bytes_old = (double)o->est_bytes_live;
+            r->live_old  = est_live(o);
+            r->allocs   -= (double)o->est_alloc_total;
+        }
+        if (n) {
+            r->bytes_new = (double)n->est_bytes_live;
+            r->live_new  = est_live(n);
+            r->allocs   += (double)n->est_alloc_total;
+        }
+        total_old += r->bytes_old;
+        total_new += r->bytes_new;
+    }
+    qsort(row, rows, sizeof *row, row_cmp);
+
+    printf("snapshots: %s -> %s (%.0f s apart)\n", paths[0], paths[1],
+           (double)new_snap->timestamp - (double)old_snap->timestamp);
+    printf("live bytes: %.0f -> %.0f (%+.0f)%s\n", total_old, total_new, total_new - total_old,
+           (old_snap->sample_rate || new_snap->sample_rate) ? "  [sampled estimates]" : "");
+    printf("%14s %12s %14s %12s %12s  %s\n",
+           "delta bytes", "delta live", "bytes live", "live", "new allocs", "site");
+    for (i = 0; i < rows && (!top || shown < top); ++i) {
+        const DiffRow *r = &row[i];
+        if (!all && r->bytes_new == r->bytes_old && r->live_new == r->live_old) continue;
+        printf("%+14.0f %+12.0f %14.0f %12.0f %12.0f  %s:%u\n",
+               r->bytes_new - r->bytes_old, r->live_new - r->live_old,
+               r->bytes_new, r->live_new, r->allocs, r->file, r->line);
+        shown += 1u;
+    }
+
+    free(row);
+    nexus_mem_snapshot_free(old_snap);
+    nexus_mem_snapshot_free(new_snap);
+    return EXIT_SUCCESS;
+}